@@ -0,0 +1,159 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - ADC Linearization Table
+* File Name            : adccal.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Table storage, calibration points, piecewise-linear build and the cached
+*   dB offset (see adccal.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <LittleFS.h>
+*   - "adccal.h", "config.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "config.h"
+#include "adccal.h"
+
+uint16_t g_adcLut[ADC_LUT_SIZE + 1];
+
+struct __attribute__((packed)) AdcCalHeader {
+  uint16_t magic;      // ADC_CAL_MAGIC
+  uint8_t  version;    // ADC_CAL_VERSION
+  uint8_t  points;     // calibration points the table was built from
+  uint32_t crc32;      // over the ADC_LUT_SIZE entries
+};
+
+struct CalPoint { float raw; float mv; };
+
+static CalPoint g_points[ADC_CAL_POINTS_MAX];
+static uint8_t  g_pointCount = 0;
+static uint8_t  g_tablePoints = 0;     // 0 = ideal table
+static bool     g_fsOk = false;
+
+// Cached dB offset and the settings it was computed from.
+static float g_dbOffset, g_dbRef = -1.0f, g_dbCal;
+
+static uint16_t toQ13(float volts) {
+  long q = lroundf(volts * (1 << ADC_VOLTS_FRAC));
+  return (uint16_t)constrain(q, 0L, 65535L);
+}
+
+static void buildIdeal() {
+  for (uint16_t i = 0; i < ADC_LUT_SIZE; i++)
+    g_adcLut[i] = toQ13((float)i * ADC_IDEAL_FULL_MV / 1000.0f / (ADC_LUT_SIZE - 1));
+  g_adcLut[ADC_LUT_SIZE] = g_adcLut[ADC_LUT_SIZE - 1];
+  g_tablePoints = 0;
+}
+
+// Piecewise-linear through sorted points; one point scales the ideal slope.
+static void buildFromPoints() {
+  if (g_pointCount == 1) {
+    float gain = g_points[0].mv / max(g_points[0].raw, 1.0f);
+    for (uint16_t i = 0; i < ADC_LUT_SIZE; i++) g_adcLut[i] = toQ13(i * gain / 1000.0f);
+  } else {
+    uint8_t seg = 0;
+    for (uint16_t i = 0; i < ADC_LUT_SIZE; i++) {
+      while (seg + 2 < g_pointCount && i > g_points[seg + 1].raw) seg++;
+      const CalPoint& a = g_points[seg];
+      const CalPoint& b = g_points[seg + 1];
+      float mv = a.mv + (i - a.raw) * (b.mv - a.mv) / (b.raw - a.raw);
+      g_adcLut[i] = toQ13(mv / 1000.0f);
+    }
+  }
+  g_adcLut[ADC_LUT_SIZE] = g_adcLut[ADC_LUT_SIZE - 1];
+  g_tablePoints = g_pointCount;
+}
+
+bool adcCalBegin() {
+  buildIdeal();
+  g_fsOk = LittleFS.begin();
+  if (!g_fsOk || !LittleFS.exists(ADC_CAL_FILE)) return false;
+  File f = LittleFS.open(ADC_CAL_FILE, "r");
+  AdcCalHeader h;
+  const size_t bytes = ADC_LUT_SIZE * sizeof(uint16_t);
+  bool ok = f && f.size() == sizeof(h) + bytes &&
+            f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+            f.read((uint8_t*)g_adcLut, bytes) == bytes &&
+            h.magic == ADC_CAL_MAGIC && h.version == ADC_CAL_VERSION &&
+            h.crc32 == configCrc32((const uint8_t*)g_adcLut, bytes);
+  if (f) f.close();
+  if (!ok) {
+    buildIdeal();
+    Serial.println(F("[adc] stored table invalid, using ideal divider table"));
+    return false;
+  }
+  g_adcLut[ADC_LUT_SIZE] = g_adcLut[ADC_LUT_SIZE - 1];
+  g_tablePoints = h.points;
+  Serial.printf("[adc] calibration table loaded (%u points)\n", h.points);
+  return true;
+}
+
+float adcDbFromMeanSq(float meanSqQ26) {
+  const NodeConfig& cfg = config();
+  if (cfg.ref_rms != g_dbRef || cfg.cal_db_at_ref != g_dbCal) {
+    g_dbRef = cfg.ref_rms;
+    g_dbCal = cfg.cal_db_at_ref;
+    // 20*log10(Vrms / ref) with Vrms^2 = meanSq / 2^26
+    g_dbOffset = g_dbCal - 20.0f * log10f(fmaxf(g_dbRef, 1e-6f)) - 10.0f * log10f((float)(1UL << (2 * ADC_VOLTS_FRAC)));
+  }
+  return g_dbOffset + 10.0f * log10f(fmaxf(meanSqQ26, 1.0f));
+}
+
+bool adcCalPoint(uint8_t pin, float mv) {
+  if (g_pointCount == ADC_CAL_POINTS_MAX || !(mv >= 0.0f)) return false;
+  uint32_t sum = 0;
+  for (uint16_t i = 0; i < ADC_CAL_AVG; i++) { sum += analogRead(pin); delayMicroseconds(200); }
+  float raw = (float)sum / ADC_CAL_AVG;
+  for (uint8_t i = 0; i < g_pointCount; i++)
+    if (fabsf(g_points[i].raw - raw) < 4.0f) {
+      Serial.printf("[adc] %.1f counts is too close to point %u (%.1f)\n", raw, i, g_points[i].raw);
+      return false;
+    }
+  uint8_t at = g_pointCount;
+  while (at > 0 && g_points[at - 1].raw > raw) { g_points[at] = g_points[at - 1]; at--; }
+  g_points[at] = { raw, mv };
+  g_pointCount++;
+  Serial.printf("[adc] point %u: %.2f counts = %.1f mV\n", g_pointCount, raw, mv);
+  return true;
+}
+
+bool adcCalSave() {
+  if (!g_pointCount) { Serial.println(F("[adc] no points (adc point <mV>)")); return false; }
+  buildFromPoints();
+  if (!g_fsOk) { Serial.println(F("[adc] no filesystem, table kept in RAM only")); return false; }
+  AdcCalHeader h = { ADC_CAL_MAGIC, ADC_CAL_VERSION, g_tablePoints,
+                     configCrc32((const uint8_t*)g_adcLut, ADC_LUT_SIZE * sizeof(uint16_t)) };
+  // Write beside the old file and rename, so a reset mid-write keeps the old table.
+  File f = LittleFS.open(ADC_CAL_FILE ".new", "w");
+  bool ok = f && f.write((const uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+            f.write((const uint8_t*)g_adcLut, ADC_LUT_SIZE * sizeof(uint16_t)) == ADC_LUT_SIZE * sizeof(uint16_t);
+  if (f) f.close();
+  ok = ok && (!LittleFS.exists(ADC_CAL_FILE) || LittleFS.remove(ADC_CAL_FILE)) &&
+       LittleFS.rename(ADC_CAL_FILE ".new", ADC_CAL_FILE);
+  Serial.printf("[adc] table from %u points %s\n", g_tablePoints, ok ? "saved" : "NOT saved");
+  return ok;
+}
+
+void adcCalReset() {
+  g_pointCount = 0;
+  buildIdeal();
+  if (g_fsOk && LittleFS.exists(ADC_CAL_FILE)) LittleFS.remove(ADC_CAL_FILE);
+  Serial.println(F("[adc] back to the ideal divider table"));
+}
+
+void adcCalPrint() {
+  if (g_tablePoints) Serial.printf("[adc] calibrated table (%u points)\n", g_tablePoints);
+  else Serial.printf("[adc] ideal divider table (%u mV at count %u)\n", ADC_IDEAL_FULL_MV, ADC_LUT_SIZE - 1);
+  for (uint8_t i = 0; i < g_pointCount; i++)
+    Serial.printf("[adc]   pending point %u: %.2f counts = %.1f mV\n", i + 1, g_points[i].raw, g_points[i].mv);
+  static const uint16_t SHOW[] = { 0, 16, 128, 256, 512, 768, 896, 1008, 1023 };
+  for (uint8_t i = 0; i < sizeof(SHOW) / sizeof(SHOW[0]); i++)
+    Serial.printf("[adc]   %4u -> %7.2f mV\n", SHOW[i], g_adcLut[SHOW[i]] * 1000.0f / (1 << ADC_VOLTS_FRAC));
+}
@@ -0,0 +1,90 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - ADC Linearization Table
+* File Name            : adccal.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Convert raw A0 counts to calibrated mic-side volts with one table load per
+*   sample instead of the float 3.3 * raw / 1023 of adcToVolts(). The
+*   1024-entry table folds in the 100k/47k divider and, once calibrated, the
+*   ESP8266 ADC's own gain error and non-linearity (dead zone near 0, bow in
+*   the middle, early saturation near 1 V at the pin).
+*     - Calibration: apply known DC voltages at the mic side of the divider,
+*       "adc point <mV>" averages ADC_CAL_AVG reads for each; "adc save"
+*       turns the points into a piecewise-linear table and writes it to flash.
+*     - Boot: adcCalBegin() loads the table from LittleFS into RAM, or builds
+*       the ideal divider table when none is stored.
+*   The dB reference (ref_rms / cal_db_at_ref) is folded into one offset that
+*   is recomputed only when those settings change.
+*
+* Inputs:
+*   - ADC_CAL_FILE on LittleFS; console points; config().ref_rms, cal_db_at_ref.
+*
+* Outputs:
+*   - adcVoltsQ13(raw): mic-side volts, Q13 (1 LSB = 122 uV, ~1/26 ADC step).
+*   - adcDbFromMeanSq(): calibrated dB from a mean square of Q13 volts.
+*
+* Example Application:
+*   adcCalBegin();                               // in setup()
+*   int32_t v = adcVoltsQ13(analogRead(A0));     // per sample
+*   float db = adcDbFromMeanSq(meanSqQ26);       // per window / output
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <LittleFS.h>
+*   - "config.h" (calibration settings, configCrc32())
+*
+* Usage Notes:
+*   - File layout, little-endian: u16 magic 'AC', u8 version, u8 points,
+*     u32 CRC-32 of the entries, then ADC_LUT_SIZE u16 entries. The points
+*     themselves are not stored; repeat them to recalibrate.
+*   - One point corrects gain only; two or more give a piecewise-linear
+*     curve through the points, extended along the end segments.
+*   - analogRead() can return 1024 (pin at full scale); a guard entry after
+*     the table repeats entry 1023 so the lookup needs no clamp.
+*   - The standalone "Sound Sensor Measurements_cpp" sketch reads the same
+*     file when it runs on a board this firmware calibrated.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#define ADC_LUT_SIZE        1024
+#define ADC_VOLTS_FRAC      13           // table entries: volts in Q13
+#define ADC_CAL_FILE        "/adccal.bin"
+#define ADC_CAL_MAGIC       0x4341u      // "AC"
+#define ADC_CAL_VERSION     1
+#define ADC_CAL_POINTS_MAX  8
+#define ADC_CAL_AVG         1024         // reads averaged per calibration point
+#define ADC_IDEAL_FULL_MV   3300         // mic-side volts at count 1023 through the divider
+
+// raw count -> mic-side volts (Q13); entry ADC_LUT_SIZE is the guard.
+extern uint16_t g_adcLut[ADC_LUT_SIZE + 1];
+
+static inline int32_t adcVoltsQ13(uint16_t raw) { return g_adcLut[raw]; }
+
+// Volts (Q13) at mid-scale, the nominal mic bias.
+static inline int32_t adcMidQ13() { return g_adcLut[ADC_LUT_SIZE / 2]; }
+
+// Mount LittleFS and load the stored table, or build the ideal one.
+// Returns true if a calibrated table was loaded.
+bool adcCalBegin();
+
+// Calibrated level of a mean square of Q13 volts (i.e. Q26 volts^2):
+//   cal_db_at_ref + 20*log10(Vrms / ref_rms)
+float adcDbFromMeanSq(float meanSqQ26);
+
+// Average ADC_CAL_AVG reads of 'pin' and record them as 'mv' mic-side millivolts.
+bool adcCalPoint(uint8_t pin, float mv);
+
+// Build the table from the recorded points and write it to flash.
+bool adcCalSave();
+
+// Forget points and stored table; back to the ideal divider table.
+void adcCalReset();
+
+// Table source, points and a few sample entries on Serial.
+void adcCalPrint();
@@ -0,0 +1,298 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Binary Batch Encoding
+* File Name            : batchcodec.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Varint / zigzag writer and reader, the schema-driven batch layout from
+*   batchcodec.h, and the text-or-binary payload builder used by the batched
+*   transports.
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "batchcodec.h", "schema.h", "config.h", "sendRequest.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include "config.h"
+#include "schema.h"
+#include "batchcodec.h"
+#include "sendRequest.h"
+
+#define HEAD_NODE_MASK   0x07
+#define HEAD_SEQ_GAP     0x08
+#define HEAD_FIELDS      0x10
+#define HEAD_RESERVED    0xE0
+
+static_assert(SCHEMA_FIELD_COUNT <= 8, "encoder keeps the presence bitmap in a byte");
+
+static const float POW10[] = { 1.0f, 10.0f, 100.0f, 1000.0f };
+
+static inline uint64_t zigzag(int64_t v)  { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static inline int64_t  unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+struct ByteWriter {
+  uint8_t* out; size_t cap; size_t len; bool full;
+  void byte(uint8_t b) { if (len < cap) out[len++] = b; else full = true; }
+  void varint(uint64_t v) {
+    while (v >= 0x80) { byte((uint8_t)v | 0x80); v >>= 7; }
+    byte((uint8_t)v);
+  }
+  void svarint(int64_t v) { varint(zigzag(v)); }
+};
+
+struct ByteReader {
+  const uint8_t* in; size_t n; size_t pos; bool bad;
+  uint8_t byte() { if (pos < n) return in[pos++]; bad = true; return 0; }
+  uint64_t varint() {
+    uint64_t v = 0;
+    for (uint8_t shift = 0; shift < 64; shift += 7) {
+      uint8_t b = byte();
+      v |= (uint64_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) return v;
+    }
+    bad = true;
+    return 0;
+  }
+  int64_t svarint() { return unzigzag(varint()); }
+};
+
+static inline int32_t scaled(float v, uint8_t decimals) { return (int32_t)lroundf(v * POW10[decimals]); }
+
+size_t batchEncode(ReadingAt at, uint8_t offset, uint8_t count, const String& tz,
+                   uint8_t* out, size_t cap) {
+  if (count == 0) return 0;
+  ByteWriter w = { out, cap, 0, false };
+  const Reading& first = at(offset);
+  uint64_t baseMs = (uint64_t)first.epoch * 1000ULL + first.ms;
+  uint8_t tzLen = (uint8_t)min<size_t>(tz.length(), 47);
+
+  w.byte(BATCH_MAGIC);
+  w.varint(ESP.getChipId());
+  w.varint(first.seq);
+  w.varint(baseMs);
+  w.svarint((int64_t)config().ntp_add_hours * 60);
+  w.varint(tzLen);
+  for (uint8_t i = 0; i < tzLen; i++) w.byte((uint8_t)tz[i]);
+  w.varint(SCHEMA_FIELD_COUNT);
+  for (uint8_t f = 0; f < SCHEMA_FIELD_COUNT; f++) {
+    w.byte(SCHEMA_FIELDS[f].id);
+    w.byte(SCHEMA_FIELDS[f].wire);
+    w.byte(SCHEMA_FIELDS[f].param);
+  }
+  w.varint(count);
+
+  uint32_t prevSeq = first.seq - 1;
+  uint64_t prevMs = baseMs;
+  int64_t  prevDt = 0;
+  int32_t  prev[SCHEMA_FIELD_COUNT] = {};
+  uint8_t  nodeFields[HEAD_NODE_MASK + 1] = {};   // presence last sent per node
+  for (uint8_t i = 0; i < count; i++) {
+    const Reading& r = at(offset + i);
+    uint64_t t = (uint64_t)r.epoch * 1000ULL + r.ms;
+    int64_t dt = (int64_t)(t - prevMs);
+    uint32_t seqDelta = r.seq - prevSeq;
+    uint8_t node = r.node & HEAD_NODE_MASK;
+    uint8_t present = 0;                          // bit i = SCHEMA_FIELDS[i]
+    for (uint8_t f = 0; f < SCHEMA_FIELD_COUNT; f++)
+      if (r.fields & SCHEMA_FIELDS[f].bit) present |= 1 << f;
+
+    uint8_t head = node;
+    if (seqDelta != 1)              head |= HEAD_SEQ_GAP;
+    if (present != nodeFields[node]) head |= HEAD_FIELDS;
+    w.byte(head);
+    if (seqDelta != 1) w.svarint((int32_t)(seqDelta - 1));
+    w.svarint(dt - prevDt);
+    if (head & HEAD_FIELDS) { w.varint(present); nodeFields[node] = present; }
+    for (uint8_t f = 0; f < SCHEMA_FIELD_COUNT; f++) {
+      if (!(present & (1 << f))) continue;
+      const FieldDef& fd = SCHEMA_FIELDS[f];
+      if (fd.wire == FIELD_WIRE_BYTES) {
+        const uint8_t* b = fieldBytes(r, fd);
+        for (uint8_t k = 0; k < fd.param; k++) w.byte(b[k]);
+        continue;
+      }
+      float v = fieldValue(r, fd);
+      if (isnan(v)) { w.varint(0); continue; }
+      int32_t s = scaled(v, fd.param);
+      w.varint(zigzag((int64_t)s - prev[f]) + 1);
+      prev[f] = s;
+    }
+
+    prevSeq = r.seq;
+    prevMs = t;
+    prevDt = dt;
+  }
+  return w.full ? 0 : w.len;
+}
+
+bool batchDecode(const uint8_t* in, size_t n, BatchHeader& h, Reading* out, uint8_t cap) {
+  ByteReader rd = { in, n, 0, false };
+  if (rd.byte() != BATCH_MAGIC) return false;
+  h.chipId    = (uint32_t)rd.varint();
+  h.baseSeq   = (uint32_t)rd.varint();
+  h.baseMs    = rd.varint();
+  h.offsetMin = (int16_t)rd.svarint();
+  uint64_t tzLen = rd.varint();
+  if (tzLen >= sizeof(h.tz)) return false;
+  for (uint8_t i = 0; i < tzLen; i++) h.tz[i] = (char)rd.byte();
+  h.tz[tzLen] = '\0';
+
+  // Field table: known ids map to the registry, unknown ones are skipped by wire type.
+  uint64_t nf = rd.varint();
+  if (rd.bad || nf > BATCH_FIELDS_MAX) return false;
+  h.fieldCount = (uint8_t)nf;
+  h.unknownFields = 0;
+  uint8_t wire[BATCH_FIELDS_MAX], param[BATCH_FIELDS_MAX];
+  const FieldDef* def[BATCH_FIELDS_MAX];
+  for (uint8_t f = 0; f < h.fieldCount; f++) {
+    uint8_t id = rd.byte();
+    wire[f] = rd.byte();
+    param[f] = rd.byte();
+    if (wire[f] > FIELD_WIRE_BYTES) return false;           // cannot be skipped
+    if (wire[f] == FIELD_WIRE_SCALED && param[f] > 3) return false;
+    def[f] = schemaField(id);
+    if (def[f] && (def[f]->wire != wire[f] || (wire[f] == FIELD_WIRE_BYTES && def[f]->param != param[f])))
+      return false;                                          // same id, different shape
+    if (!def[f]) h.unknownFields++;
+  }
+  uint64_t count = rd.varint();
+  if (rd.bad || count > cap) return false;
+  h.count = (uint8_t)count;
+
+  uint32_t seq = h.baseSeq - 1;
+  uint64_t t = h.baseMs;
+  int64_t  dt = 0;
+  int32_t  val[BATCH_FIELDS_MAX] = {};
+  uint32_t nodeFields[HEAD_NODE_MASK + 1] = {};
+  for (uint8_t i = 0; i < h.count; i++) {
+    uint8_t head = rd.byte();
+    if (head & HEAD_RESERVED) return false;
+    uint8_t node = head & HEAD_NODE_MASK;
+    seq += (head & HEAD_SEQ_GAP) ? (uint32_t)(rd.svarint() + 1) : 1;
+    dt += rd.svarint();
+    t += dt;
+    if (head & HEAD_FIELDS) {
+      uint64_t p = rd.varint();
+      if (p >> h.fieldCount) return false;
+      nodeFields[node] = (uint32_t)p;
+    }
+
+    Reading& r = out[i];
+    r = Reading();
+    r.epoch = (uint32_t)(t / 1000);
+    r.ms = (uint16_t)(t % 1000);
+    r.node = node;
+    r.seq = seq;
+    for (uint8_t f = 0; f < h.fieldCount; f++) {
+      if (!(nodeFields[node] & (1UL << f))) continue;
+      if (wire[f] == FIELD_WIRE_BYTES) {
+        uint8_t* b = def[f] ? fieldBytes(r, *def[f]) : nullptr;
+        for (uint8_t k = 0; k < param[f]; k++) { uint8_t x = rd.byte(); if (b) b[k] = x; }
+      } else {
+        uint64_t z = rd.varint();
+        float v = NAN;
+        if (z) { val[f] += (int32_t)unzigzag(z - 1); v = val[f] / POW10[param[f]]; }
+        if (def[f]) fieldSetValue(r, *def[f], v);
+      }
+      if (def[f]) r.fields |= def[f]->bit;
+    }
+  }
+  return !rd.bad && rd.pos == n;
+}
+
+uint8_t batchPayload(uint8_t offset, uint8_t count, const String& tz, BatchPayload& out) {
+  count = min<uint8_t>(count, readingCount() - offset);
+  out.text = "";
+  out.bin.reset();
+  out.binLen = 0;
+  if (count == 0) return 0;
+
+  if (config().batch_format == BATCH_FORMAT_BINARY) {
+    size_t cap = BATCH_MAX_BYTES(count);
+    out.bin.reset(new (std::nothrow) uint8_t[cap]);
+    if (!out.bin) return 0;
+    out.binLen = batchEncode(readingAt, offset, count, tz, out.bin.get(), cap);
+    return count;
+  }
+
+  out.text.reserve(count * 128);
+  String iso;
+  for (uint8_t i = 0; i < count; i++) {
+    const Reading& r = readingAt(offset + i);
+    isoFromEpoch(r.epoch, iso);
+    if (i) out.text += '\n';
+    out.text += formBody(r, iso, tz, r.epoch, r.ms);
+  }
+  return count;
+}
+
+#ifdef COMPRESS_BENCH
+#include "compress.h"
+
+static Reading g_benchReadings[READING_QUEUE_CAP];
+static const Reading& benchAt(uint8_t i) { return g_benchReadings[i]; }
+
+// Two shapes: a periodic sound logger and alternating button presses.
+static void fillBench(bool periodic) {
+  uint32_t t = 1792300000UL;
+  uint16_t ms = 0;
+  for (uint8_t i = 0; i < READING_QUEUE_CAP; i++) {
+    Reading& r = g_benchReadings[i];
+    bool ultra = !periodic && (i & 1);
+    uint32_t stepMs = periodic ? 60000UL : 3000UL + (i * 7919UL) % 9000UL;
+    ms += stepMs % 1000; t += stepMs / 1000 + ms / 1000; ms %= 1000;
+    r = Reading();
+    r.epoch = t; r.ms = ms;
+    r.node = ultra ? READING_NODE_ULTRA : READING_NODE_SOUND;
+    r.fields = ultra ? READING_FIELD_DIST : READING_FIELD_SOUND;
+    r.distance_cm = ultra ? 20.0f + (i % 9) * 1.37f : 0.0f;
+    r.sound_db = ultra ? 0.0f : 41.0f + (float)((i * 37) % 11) * 0.3f;
+    r.seq = 1000 + i;
+  }
+}
+
+void runBatchCodecBench() {
+  std::unique_ptr<uint8_t[]> bin(new uint8_t[BATCH_MAX_BYTES(READING_QUEUE_CAP)]);
+  std::unique_ptr<uint8_t[]> lz(new uint8_t[BATCH_MAX_BYTES(READING_QUEUE_CAP) + 4096]);
+  std::unique_ptr<Reading[]> back(new Reading[READING_QUEUE_CAP]);
+  const String tz = "America/Los_Angeles";
+
+  Serial.println(F("\n[bench] batch encoding, bytes per reading"));
+  Serial.println(F("  shape      n   text  text+lz  binary  binary+lz  enc cyc  ok"));
+  for (uint8_t shape = 0; shape < 2; shape++) {
+    fillBench(shape == 0);
+    for (uint8_t n = 8; n <= READING_QUEUE_CAP; n *= 2) {
+      String text, iso;
+      for (uint8_t i = 0; i < n; i++) {
+        const Reading& r = benchAt(i);
+        isoFromEpoch(r.epoch, iso);
+        if (i) text += '\n';
+        text += formBody(r, iso, tz, r.epoch, r.ms);
+      }
+      size_t textLz = hsCompress((const uint8_t*)text.c_str(), text.length(), lz.get(), text.length());
+
+      uint32_t t0 = ESP.getCycleCount();
+      size_t b = batchEncode(benchAt, 0, n, tz, bin.get(), BATCH_MAX_BYTES(n));
+      uint32_t enc = ESP.getCycleCount() - t0;
+      size_t binLz = hsCompress(bin.get(), b, lz.get(), b);
+
+      BatchHeader h;
+      bool ok = b && batchDecode(bin.get(), b, h, back.get(), READING_QUEUE_CAP) && h.count == n;
+      for (uint8_t i = 0; ok && i < n; i++)
+        ok = back[i].seq == benchAt(i).seq && back[i].epoch == benchAt(i).epoch && back[i].ms == benchAt(i).ms &&
+             back[i].fields == benchAt(i).fields;
+
+      Serial.printf("  %-8s %3u  %5.1f  %7.1f  %6.1f  %9.1f  %7lu  %s\n",
+                    shape == 0 ? "periodic" : "buttons", n,
+                    (float)text.length() / n, (float)(textLz ? textLz : text.length()) / n,
+                    (float)b / n, (float)(binLz ? binLz : b) / n, (unsigned long)enc, ok ? "yes" : "NO");
+      yield();
+    }
+  }
+}
+#endif // COMPRESS_BENCH
@@ -0,0 +1,124 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Binary Batch Encoding
+* File Name            : batchcodec.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Compact alternative to the text batch (one form body per line). Everything
+*   shared by a batch is sent once; each reading only carries what changed,
+*   and only the fields it has (schema.h):
+*     header   u8 magic 0xB2
+*              varint chip ID, varint seq of the first reading
+*              varint base time (UTC epoch milliseconds of the first reading)
+*              zigzag varint ntp offset (minutes, for measured_iso formatting)
+*              varint tz length + tz bytes
+*              varint field count, then per field: u8 id, u8 wire, u8 param
+*              (the SCHEMA_FIELDS registry; "field i" below is this order)
+*              varint count
+*     reading  u8 head: node (3 bits) | seq gap << 3 | new fields << 4
+*                       (bits 5..7 zero, reserved)
+*              [zigzag varint (seq delta - 1)]       only with the seq gap bit
+*              zigzag varint delta-of-delta of the capture time (ms)
+*              [varint presence bitmap, bit i = field i]   only with new fields,
+*                                    i.e. when it differs from the previous
+*                                    reading of the same node
+*              per present field, in field order:
+*                scaled: varint 0 for NaN, else zigzag delta of the scaled
+*                        value against the field's previous value, plus 1
+*                bytes : param raw bytes
+*   Periodic readings with slowly changing values take 3 bytes each
+*   (head, zero time delta-of-delta, one small value delta). A decoder skips
+*   fields whose id it does not know by their wire type and param, so new
+*   fields do not break older decoders. 0xB1 batches (fixed distance / sound
+*   / classes / quality layout) are no longer sent but the stand-in still
+*   reads them.
+*
+* Inputs:
+*   - Readings from the queue (readings.h) or any array via an accessor.
+*
+* Outputs:
+*   - batchEncode(): payload bytes; batchDecode(): Readings back (round trip).
+*   - batchPayload(): queued readings in the configured batch_format, ready
+*     for postBatch(), coapPost() or an MQTT publish.
+*   - server/ingest_standin.py decode_batch() produces the same form fields
+*     the text encoding carries.
+*
+* Example Application:
+*   std::unique_ptr<uint8_t[]> buf(new uint8_t[BATCH_MAX_BYTES(n)]);
+*   size_t len = batchEncode(readingAt, 0, n, tzRegion, buf.get(), BATCH_MAX_BYTES(n));
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "readings.h", "schema.h" (field registry), "config.h" (ntp_add_hours, batch_format)
+*   - "sendRequest.h" (formBody() for the text format)
+*
+* Usage Notes:
+*   - Values are sent as integers scaled by 10^decimals (defaults: 0.1 cm,
+*     0.1 dB), which is below what either sensor resolves.
+*   - An absent field costs nothing; the decoder leaves it out of Reading::fields.
+*   - Select with "cfg set batch_format binary"; text stays the default because
+*     the hosted ingest.php only understands form bodies.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include "readings.h"
+#include "schema.h"
+
+#define BATCH_MAGIC           0xB2
+#define BATCH_CONTENT_TYPE    "application/x-ee570-batch"
+#define COAP_FMT_BATCH        65001     // CoAP Content-Format, experimental-use range
+#define BATCH_FIELDS_MAX      16        // decoder limit on the header's field table
+
+// Worst-case sizes: header with a 47-char tz, reading with every field.
+#define BATCH_HDR_MAX         (1 + 5 + 5 + 10 + 3 + 1 + 47 + 1 + 3 * SCHEMA_FIELD_COUNT + 1)
+#define BATCH_READING_MAX     (1 + 5 + 10 + 3 + SCHEMA_VALUES_MAX)
+#define BATCH_MAX_BYTES(n)    (BATCH_HDR_MAX + (size_t)(n) * BATCH_READING_MAX)
+
+struct BatchHeader {
+  uint32_t chipId;
+  uint32_t baseSeq;
+  uint64_t baseMs;
+  int16_t  offsetMin;
+  char     tz[48];
+  uint8_t  fieldCount;      // fields described in the header
+  uint8_t  unknownFields;   // of those, ids not in SCHEMA_FIELDS (skipped)
+  uint8_t  count;
+};
+
+// One encoded batch in either format. Text lives in 'text'; binary in 'bin'.
+struct BatchPayload {
+  String text;
+  std::unique_ptr<uint8_t[]> bin;
+  size_t binLen = 0;
+
+  bool binary() const { return (bool)bin; }
+  const uint8_t* data() const { return binary() ? bin.get() : (const uint8_t*)text.c_str(); }
+  size_t length() const { return binary() ? binLen : text.length(); }
+  const char* contentType() const { return binary() ? BATCH_CONTENT_TYPE : "text/plain"; }
+};
+
+// Reading accessor, e.g. readingAt() for the queue.
+typedef const Reading& (*ReadingAt)(uint8_t i);
+
+// Encode readings at(offset) .. at(offset + count - 1).
+// Returns the payload length, or 0 if it does not fit 'cap'.
+size_t batchEncode(ReadingAt at, uint8_t offset, uint8_t count, const String& tz,
+                   uint8_t* out, size_t cap);
+
+// Decode a payload into up to 'cap' readings (h.count is set).
+// Returns false on a malformed or truncated payload.
+bool batchDecode(const uint8_t* in, size_t n, BatchHeader& h, Reading* out, uint8_t cap);
+
+// Encode queued readings [offset, offset + count) in config().batch_format.
+// Returns the number of readings encoded (0 if the buffer could not be had).
+uint8_t batchPayload(uint8_t offset, uint8_t count, const String& tz, BatchPayload& out);
+
+#ifdef COMPRESS_BENCH
+// Bytes per reading: text, binary, and either one compressed (compress.h).
+void runBatchCodecBench();
+#endif
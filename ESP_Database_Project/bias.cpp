@@ -0,0 +1,94 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Persistent DC Bias Tracker
+* File Name            : bias.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   RTC and EEPROM records of the tracked bias (see bias.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <EEPROM.h>
+*   - "bias.h", "config.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "config.h"
+#include "bias.h"
+
+#define BIAS_MAGIC 0x4942u   // "BI"
+
+// Same shape as the sequence record: value plus its complement.
+struct __attribute__((packed)) BiasRecord {
+  uint16_t magic;
+  int32_t  biasQ16;
+  uint32_t check;       // ~biasQ16
+};
+
+static_assert(CONFIG_BIAS_OFFSET + sizeof(BiasRecord) <= CONFIG_EEPROM_SIZE,
+              "BiasRecord does not fit the EEPROM area");
+
+int32_t g_biasQ16 = (int32_t)BIAS_NOMINAL << 16;
+
+static int32_t     g_rtcQ16 = -1;     // value last written to RTC memory
+static int32_t     g_flashQ16;        // value in flash (BIAS_NOMINAL if none)
+static bool        g_flashValid = false;
+static uint32_t    g_flashMs = 0;     // last flash write
+static const char* g_source = "nominal";
+
+static bool valid(const BiasRecord& r) {
+  return r.magic == BIAS_MAGIC && r.check == ~(uint32_t)r.biasQ16 &&
+         r.biasQ16 >= 0 && r.biasQ16 <= (int32_t)ADC_LUT_SIZE << 16;
+}
+
+static BiasRecord record(int32_t q16) { return { BIAS_MAGIC, q16, ~(uint32_t)q16 }; }
+
+void biasBegin() {
+  BiasRecord f;
+  EEPROM.get(CONFIG_BIAS_OFFSET, f);
+  g_flashValid = valid(f);
+  g_flashQ16 = g_flashValid ? f.biasQ16 : g_biasQ16;
+  if (g_flashValid) { g_biasQ16 = f.biasQ16; g_source = "flash"; }
+
+  // RTC blocks are 4 bytes; the record is padded to 12. Newer than flash.
+  uint32_t rtc[3];
+  BiasRecord r;
+  if (ESP.rtcUserMemoryRead(BIAS_RTC_BLOCK, rtc, sizeof(rtc))) {
+    memcpy(&r, rtc, sizeof(r));
+    if (valid(r)) { g_biasQ16 = g_rtcQ16 = r.biasQ16; g_source = "rtc"; }
+  }
+  Serial.printf("[bias] %.2f counts (%s)\n", biasCounts(), g_source);
+}
+
+void biasService() {
+  int32_t q = g_biasQ16;
+  if (q != g_rtcQ16) {
+    uint32_t rtc[3] = {};
+    BiasRecord r = record(q);
+    memcpy(rtc, &r, sizeof(r));
+    if (ESP.rtcUserMemoryWrite(BIAS_RTC_BLOCK, rtc, sizeof(rtc))) g_rtcQ16 = q;
+  }
+  // Flash only for real drift, once the tracker has had time to settle after
+  // boot, and not more often than BIAS_FLASH_MIN_MS.
+  int32_t drift = q - g_flashQ16;
+  if (drift < 0) drift = -drift;
+  if (drift < ((int32_t)BIAS_FLASH_DELTA << 16)) return;
+  uint32_t now = millis();
+  if (now < BIAS_FLASH_SETTLE_MS) return;
+  if (g_flashMs && now - g_flashMs < BIAS_FLASH_MIN_MS) return;
+  EEPROM.put(CONFIG_BIAS_OFFSET, record(q));
+  g_flashMs = now;
+  if (EEPROM.commit()) { g_flashQ16 = q; g_flashValid = true; }
+  else Serial.println(F("[bias] commit FAILED"));
+}
+
+void biasPrint() {
+  Serial.printf("[bias] %.2f counts = %.4f V (boot value from %s)\n",
+                biasCounts(), biasVoltsQ13() / (float)(1 << ADC_VOLTS_FRAC), g_source);
+  if (g_flashValid) Serial.printf("[bias] flash copy %.2f counts\n", g_flashQ16 / 65536.0f);
+  else Serial.println(F("[bias] no flash copy yet"));
+}
@@ -0,0 +1,95 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Persistent DC Bias Tracker
+* File Name            : bias.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Track the MAX4466 output bias (~1.65 V, nominally count 512) with a slow
+*   first-order IIR that every sound sampling loop updates, and keep the
+*   estimate across deep sleep and reboots. read_sensor_2() used to assume a
+*   fixed 512 midpoint and the standalone sketch spent a whole window finding
+*   the bias; with the tracked value restored at boot, a duty-cycled node
+*   measures around the right bias from its first sample.
+*     - RTC user memory: refreshed whenever the estimate moves; survives deep
+*       sleep and resets, not power loss.
+*     - EEPROM sector: rewritten only when the estimate drifts BIAS_FLASH_DELTA
+*       counts from the stored value (or from 512 if none), at most every
+*       BIAS_FLASH_MIN_MS and not in the first BIAS_FLASH_SETTLE_MS of uptime.
+*
+* Inputs:
+*   - biasTrack(raw) from the sampling loops (sampling.h, oversample.cpp,
+*     timeweight.cpp); the RTC and EEPROM records at boot.
+*
+* Outputs:
+*   - biasQ4() for the crude dB's per-sample deviation, biasVoltsQ13() for the
+*     table-volts paths (oversampling centre, time-weighting DC seed); "bias"
+*     on the console.
+*
+* Example Application:
+*   biasBegin();                        // in setup(), after configBegin()
+*   biasTrack(analogRead(A0));          // per sample
+*   int32_t mid = biasQ4();              // once per window
+*   dev += abs(((int32_t)raw << 4) - mid); // per sample: level = dev / (16 * n)
+*   biasService();                      // in loop()
+*
+* Dependencies:
+*   - Arduino core for ESP8266 (ESP.rtcUserMemory*), <EEPROM.h>
+*   - "config.h" (CONFIG_BIAS_OFFSET), "adccal.h" (count -> volts)
+*
+* Usage Notes:
+*   - The state is Q16 counts; one shift and add per sample. BIAS_SHIFT sets
+*     the time constant in samples (2^12 = ~0.8 s at 5 kHz); oversampled
+*     windows update it R times per output, so it settles R times faster
+*     there.
+*   - With neither record valid (first power-up) the tracker starts at 512,
+*     the old fixed assumption, and converges from there.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include "adccal.h"
+
+#ifndef BIAS_SHIFT
+#define BIAS_SHIFT          12          // IIR weight 2^-12 per sample
+#endif
+#define BIAS_NOMINAL        512         // start value without a stored estimate
+#define BIAS_RTC_BLOCK      0           // RTC user memory offset (4-byte blocks), 3 blocks;
+                                        // the standalone sound meter sketch uses block 8
+#define BIAS_FLASH_DELTA    2           // counts of drift before a flash rewrite
+#define BIAS_FLASH_MIN_MS   (30UL * 60UL * 1000UL)
+#define BIAS_FLASH_SETTLE_MS 60000UL    // no flash write this soon after boot
+
+// Tracked bias, Q16 counts.
+extern int32_t g_biasQ16;
+
+// Update the tracker with one raw reading.
+static inline void biasTrack(uint16_t raw) {
+  g_biasQ16 += (((int32_t)raw << 16) - g_biasQ16) >> BIAS_SHIFT;
+}
+
+static inline float biasCounts() { return g_biasQ16 / 65536.0f; }
+
+// The bias in Q4 counts (rounded), for integer deviation sums.
+static inline int32_t biasQ4() { return (g_biasQ16 + (1 << 11)) >> 12; }
+
+// The bias in table volts (Q13), interpolated between entries.
+static inline int32_t biasVoltsQ13() {
+  uint32_t i = (uint32_t)g_biasQ16 >> 16;
+  if (i > ADC_LUT_SIZE - 1) i = ADC_LUT_SIZE - 1;
+  int32_t f = g_biasQ16 & 0xFFFF;
+  return g_adcLut[i] + (((int32_t)g_adcLut[i + 1] - g_adcLut[i]) * f >> 16);
+}
+
+// Restore the estimate from RTC memory, else flash, else BIAS_NOMINAL.
+// Call after configBegin() (EEPROM open).
+void biasBegin();
+
+// Mirror the estimate to RTC memory and, on enough drift, to flash. Call from loop().
+void biasService();
+
+// Current and stored estimates and where the boot value came from, on Serial.
+void biasPrint();
@@ -0,0 +1,229 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Acoustic Event Classifier
+* File Name            : classify.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Frame capture, fixed-point log-mel front end and int8 network (see
+*   classify.h). server/classifier_tool.py mirrors every step; keep the two
+*   in step when changing either.
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "classify.h", "classify_weights.h", "config.h", "adccal.h", "bias.h", "timeweight.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include "config.h"
+#include "adccal.h"
+#include "bias.h"
+#include "timeweight.h"
+#include "classify.h"
+#include "classify_weights.h"
+
+const char* const CLS_NAMES[CLS_CLASSES] = { "background", "traffic", "voices", "alarm", "machinery" };
+
+struct MelBin { uint8_t seg; uint8_t w; };   // seg 0xFF: outside the filter bank
+
+static int16_t  g_hann[CLS_FFT_N / 2 + 1];
+static int16_t  g_cos[CLS_FFT_N / 2], g_sin[CLS_FFT_N / 2];
+static MelBin   g_mel[CLS_BINS];
+static uint32_t g_tableFs = 0;
+
+static int32_t  g_re[CLS_FFT_N], g_im[CLS_FFT_N];
+static uint16_t g_logs[CLS_FRAMES][CLS_MELS];
+static uint8_t  g_frame = 0;            // frames done in the current window
+static uint32_t g_dueMs = 0;
+static ClsResult g_latest = {};
+static ClsStats  g_stats = {};
+
+static inline uint8_t rev8(uint8_t b) {
+  b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+  b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+  return (b & 0xAA) >> 1 | (b & 0x55) << 1;
+}
+static_assert(CLS_FFT_LOG2 == 8, "rev8() assumes a 256-point FFT");
+
+static double melOf(double f) { return 2595.0 * log10(1.0 + f / 700.0); }
+static double hzOf(double m)  { return 700.0 * (pow(10.0, m / 2595.0) - 1.0); }
+
+void clsTables(uint32_t fs) {
+  for (uint16_t n = 0; n <= CLS_FFT_N / 2; n++)
+    g_hann[n] = (int16_t)lround(32767.0 * (0.5 - 0.5 * cos(2.0 * M_PI * n / CLS_FFT_N)));
+  for (uint16_t k = 0; k < CLS_FFT_N / 2; k++) {
+    g_cos[k] = (int16_t)lround(32767.0 * cos(2.0 * M_PI * k / CLS_FFT_N));
+    g_sin[k] = (int16_t)lround(32767.0 * sin(2.0 * M_PI * k / CLS_FFT_N));
+  }
+  // Band edges equally spaced in mel; each bin sits on the rising slope of
+  // band 'seg' (weight w) and the falling slope of band seg - 1 (255 - w).
+  double pts[CLS_MELS + 2];
+  double lo = melOf(CLS_MEL_LO_HZ), hi = melOf(fs / 2.0);
+  for (uint8_t i = 0; i < CLS_MELS + 2; i++) pts[i] = hzOf(lo + (hi - lo) * i / (CLS_MELS + 1));
+  for (uint16_t k = 0; k < CLS_BINS; k++) {
+    double f = (double)k * fs / CLS_FFT_N;
+    g_mel[k] = { 0xFF, 0 };
+    for (uint8_t j = 0; j < CLS_MELS + 1; j++)
+      if (pts[j] <= f && f < pts[j + 1]) {
+        g_mel[k] = { j, (uint8_t)lround(255.0 * (f - pts[j]) / (pts[j + 1] - pts[j])) };
+        break;
+      }
+  }
+  g_tableFs = fs;
+}
+
+// Windowed sample n, stored at its bit-reversed position for the FFT.
+static inline void load(uint16_t n, uint16_t raw, int32_t mid) {
+  int32_t x = adcVoltsQ13(raw) - mid;
+  int32_t w = g_hann[n <= CLS_FFT_N / 2 ? n : CLS_FFT_N - n];
+  uint8_t r = rev8((uint8_t)n);
+  g_re[r] = (x * w) >> 15;
+  g_im[r] = 0;
+}
+
+// Integer part from the leading bit, 8 fraction bits taken linearly below it.
+static uint16_t log2Q8(uint64_t e) {
+  if (!e) return 0;
+  uint8_t n = 63 - __builtin_clzll(e);
+  uint32_t frac = (uint32_t)((e << (63 - n)) >> 55) & 0xFF;
+  return (uint16_t)(n * 256 + frac);
+}
+
+// FFT of the loaded frame, mel energies and their logs.
+static void transform(uint16_t* logMel) {
+  for (uint16_t half = 1; half < CLS_FFT_N; half <<= 1) {
+    uint16_t step = CLS_FFT_N / (2 * half);
+    for (uint16_t start = 0; start < CLS_FFT_N; start += 2 * half)
+      for (uint16_t k = 0; k < half; k++) {
+        int32_t wr = g_cos[k * step], wi = -g_sin[k * step];
+        uint16_t i = start + k, j = i + half;
+        int32_t tr = (int32_t)(((int64_t)wr * g_re[j] - (int64_t)wi * g_im[j]) >> 15);
+        int32_t ti = (int32_t)(((int64_t)wr * g_im[j] + (int64_t)wi * g_re[j]) >> 15);
+        g_re[j] = g_re[i] - tr; g_im[j] = g_im[i] - ti;
+        g_re[i] += tr;          g_im[i] += ti;
+      }
+  }
+  uint64_t e[CLS_MELS] = {};
+  for (uint16_t k = 0; k < CLS_BINS; k++) {
+    const MelBin& m = g_mel[k];
+    if (m.seg == 0xFF) continue;
+    uint64_t p = (uint64_t)((int64_t)g_re[k] * g_re[k] + (int64_t)g_im[k] * g_im[k]);
+    if (m.seg < CLS_MELS) e[m.seg] += p * m.w;
+    if (m.seg > 0) e[m.seg - 1] += p * (255 - m.w);
+  }
+  for (uint8_t b = 0; b < CLS_MELS; b++) logMel[b] = log2Q8(e[b]);
+}
+
+void clsFrame(const uint16_t* raw, int32_t midQ13, uint16_t* logMel) {
+  for (uint16_t n = 0; n < CLS_FFT_N; n++) load(n, raw[n], midQ13);
+  transform(logMel);
+}
+
+uint8_t clsInfer(const uint16_t logMel[CLS_FRAMES][CLS_MELS], uint8_t* pct) {
+  // Features: per band mean and mean absolute deviation over the frames (Q8).
+  int32_t f[CLS_FEATURES];
+  for (uint8_t b = 0; b < CLS_MELS; b++) {
+    uint32_t sum = 0;
+    for (uint8_t t = 0; t < CLS_FRAMES; t++) sum += logMel[t][b];
+    int32_t mean = (int32_t)(sum >> CLS_FRAMES_LOG2);
+    uint32_t dev = 0;
+    for (uint8_t t = 0; t < CLS_FRAMES; t++) dev += abs((int32_t)logMel[t][b] - mean);
+    f[b] = mean;
+    f[CLS_MELS + b] = (int32_t)(dev >> CLS_FRAMES_LOG2);
+  }
+
+  int8_t x[CLS_FEATURES];
+  for (uint8_t i = 0; i < CLS_FEATURES; i++) {
+    int32_t mu = (int16_t)pgm_read_word(&CLS_MU[i]);
+    int32_t mul = (int32_t)pgm_read_dword(&CLS_MUL[i]);
+    int32_t v = (int32_t)(((int64_t)(f[i] - mu) * mul + 32768) >> 16);
+    x[i] = (int8_t)constrain(v, -127, 127);
+  }
+
+  int8_t h[CLS_HIDDEN];
+  for (uint8_t j = 0; j < CLS_HIDDEN; j++) {
+    int32_t acc = (int32_t)pgm_read_dword(&CLS_B1[j]);
+    const int8_t* w = &CLS_W1[j * CLS_FEATURES];
+    for (uint8_t i = 0; i < CLS_FEATURES; i++) acc += (int8_t)pgm_read_byte(&w[i]) * x[i];
+    if (acc < 0) acc = 0;
+    h[j] = (int8_t)min<int32_t>(127, (int32_t)(((int64_t)acc * CLS_M1 + (1 << 23)) >> 24));
+  }
+
+  float z[CLS_CLASSES], zmax = -1e30f;
+  for (uint8_t c = 0; c < CLS_CLASSES; c++) {
+    int32_t acc = (int32_t)pgm_read_dword(&CLS_B2[c]);
+    const int8_t* w = &CLS_W2[c * CLS_HIDDEN];
+    for (uint8_t j = 0; j < CLS_HIDDEN; j++) acc += (int8_t)pgm_read_byte(&w[j]) * h[j];
+    z[c] = acc * CLS_LOGIT_SCALE;
+    zmax = max(zmax, z[c]);
+  }
+  float sum = 0.0f;
+  uint8_t top = 0;
+  for (uint8_t c = 0; c < CLS_CLASSES; c++) {
+    z[c] = expf(z[c] - zmax);
+    sum += z[c];
+    if (z[c] > z[top]) top = c;
+  }
+  for (uint8_t c = 0; c < CLS_CLASSES; c++) pct[c] = (uint8_t)lroundf(100.0f * z[c] / sum);
+  return top;
+}
+
+bool clsActive() { return config().cls_period_s > 0; }
+bool clsCapturing() { return g_frame > 0; }
+
+bool clsService(ClsResult& out) {
+  const NodeConfig& cfg = config();
+  if (!cfg.cls_period_s) { g_frame = 0; return false; }
+  if (g_frame == 0 && (int32_t)(millis() - g_dueMs) < 0) return false;
+  if (g_tableFs != cfg.target_fs) { clsTables(cfg.target_fs); g_frame = 0; }
+
+  // One frame, paced at target_fs like the other sampling loops.
+  const uint32_t gap = ESP.getCpuFreqMHz() * 1000000UL / cfg.target_fs;
+  const int32_t mid = biasVoltsQ13();
+  TimeWeighter* tw = twWindow();
+  uint32_t next = ESP.getCycleCount();
+  for (uint16_t n = 0; n < CLS_FFT_N; n++) {
+    while ((int32_t)(ESP.getCycleCount() - next) < 0) {}
+    next += gap;
+    uint16_t raw = analogRead(cfg.pin_sound);
+    biasTrack(raw);
+    twPush(tw, adcVoltsQ13(raw));
+    load(n, raw, mid);
+  }
+  twWindowEnd(tw, CLS_FFT_N);
+  uint32_t t0 = ESP.getCycleCount();
+  transform(g_logs[g_frame]);
+  g_stats.frameCycles = ESP.getCycleCount() - t0;
+  g_stats.maxFrameCycles = max(g_stats.maxFrameCycles, g_stats.frameCycles);
+  if (++g_frame < CLS_FRAMES) return false;
+
+  g_frame = 0;
+  g_dueMs = millis() + cfg.cls_period_s * 1000UL;
+  t0 = ESP.getCycleCount();
+  ClsResult r;
+  r.top = clsInfer(g_logs, r.pct);
+  g_stats.inferCycles = ESP.getCycleCount() - t0;
+  r.ms = millis();
+  g_stats.windows++;
+  g_latest = r;
+  out = r;
+  return true;
+}
+
+const ClsResult& clsLatest() { return g_latest; }
+const ClsStats& clsStats() { return g_stats; }
+
+void clsPrint() {
+  if (!clsActive()) { Serial.println(F("[cls] off (cfg set cls_period_s <seconds>)")); return; }
+  Serial.printf("[cls] %lu windows; cycles: %lu per frame (max %lu), %lu per inference\n",
+                (unsigned long)g_stats.windows, (unsigned long)g_stats.frameCycles,
+                (unsigned long)g_stats.maxFrameCycles, (unsigned long)g_stats.inferCycles);
+  if (!g_stats.windows) return;
+  Serial.printf("[cls] %lu ms ago:", (unsigned long)(millis() - g_latest.ms));
+  for (uint8_t c = 0; c < CLS_CLASSES; c++)
+    Serial.printf(" %s %u%%%s", CLS_NAMES[c], g_latest.pct[c], c == g_latest.top ? "*" : "");
+  Serial.println();
+}
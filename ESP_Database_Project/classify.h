@@ -0,0 +1,113 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Acoustic Event Classifier
+* File Name            : classify.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Label the sound around the node on the node itself, so a window uploads
+*   five class probabilities instead of raw levels for the backend to
+*   interpret. Every cls_period_s seconds one window of CLS_FRAMES frames
+*   of CLS_FFT_N samples is taken at target_fs and run through, in integer
+*   arithmetic:
+*     - bias removal (bias.h) and a Q15 Hann window on table volts (adccal.h);
+*     - a 256-point radix-2 FFT (32-bit data, Q15 twiddles, 64-bit products);
+*     - 16 triangular mel bands, 100 Hz .. fs/2, Q8 weights, 64-bit energies;
+*     - log2 in Q8 per band;
+*     - per band: mean and mean absolute deviation over the frames (32 features);
+*     - a 32-16-5 network with int8 weights in flash (classify_weights.h),
+*       int32 accumulators, and one float softmax per window.
+*   The result is queued as a READING_NODE_CLASS reading (readings.h) that
+*   carries the percentages in place of distance / level values.
+*
+* Inputs:
+*   - config().pin_sound, target_fs, cls_period_s (0 = off).
+*
+* Outputs:
+*   - ClsResult per window (CLS_NAMES order); ClsStats with measured cycles
+*     per frame and per inference; "cls" on the console; /metrics gauges.
+*
+* Example Application:
+*   // cfg set cls_period_s 10
+*   ClsResult r;
+*   if (clsService(r)) ...;   // ClassSensor in main.cpp (sensors.h) polls this
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "config.h", "readings.h" (READING_CLASSES), "adccal.h", "bias.h",
+*     "timeweight.h" (captured samples also feed the F/S/I stage)
+*   - "classify_weights.h" (generated by server/classifier_tool.py)
+*
+* Usage Notes:
+*   - CPU: one frame is captured per clsService() call (51 ms at 5 kHz, ADC
+*     bound), then transformed; the transform and the network are in the
+*     sampling benchmark and in ClsStats, and server/classifier_tool.py eval
+*     turns them into a CPU share per window.
+*   - server/classifier_tool.py reproduces the front end bit for bit, trains
+*     the network on recorded traces and writes classify_weights.h; the
+*     weights shipped here are a synthetic bootstrap. Record traces at the
+*     target_fs the node runs with; the model is only valid for that rate.
+*   - RAM: 2 KB FFT buffers, 1 KB tables, 256 B frame history.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include "readings.h"
+
+#define CLS_FFT_N       256
+#define CLS_FFT_LOG2    8
+#define CLS_BINS        (CLS_FFT_N / 2 + 1)
+#define CLS_MELS        16
+#define CLS_MEL_LO_HZ   100.0
+#define CLS_FRAMES      8
+#define CLS_FRAMES_LOG2 3
+#define CLS_FEATURES    (2 * CLS_MELS)
+#define CLS_HIDDEN      16
+#define CLS_CLASSES     READING_CLASSES
+
+// Class order of the network outputs and of uploaded percentages.
+extern const char* const CLS_NAMES[CLS_CLASSES];
+
+struct ClsResult {
+  uint32_t ms;                  // millis() when the window closed
+  uint8_t  pct[CLS_CLASSES];    // probabilities, percent
+  uint8_t  top;                 // index of the most likely class
+};
+
+struct ClsStats {
+  uint32_t windows;             // windows classified since boot
+  uint32_t frameCycles;         // last frame: FFT + mel + log (ADC excluded)
+  uint32_t maxFrameCycles;
+  uint32_t inferCycles;         // last window: features + network + softmax
+};
+
+// True when the classifier is on (config().cls_period_s > 0).
+bool clsActive();
+
+// True between the first and last frame of a window (frames are meant to be
+// back to back; the loop should not idle then).
+bool clsCapturing();
+
+// Capture and transform one frame when a window is due; true when the
+// window's last frame is done, with the probabilities in 'out'.
+bool clsService(ClsResult& out);
+
+// Most recent result (all zero before the first window).
+const ClsResult& clsLatest();
+const ClsStats& clsStats();
+
+// Latest probabilities and cycle counts on Serial.
+void clsPrint();
+
+// ---- Pipeline stages (used by clsService(), the benchmark and host checks) ----
+// Rebuild the window, twiddle and mel tables for sample rate fs.
+void clsTables(uint32_t fs);
+
+// One frame of raw counts around midQ13 (table volts) -> CLS_MELS log2 energies (Q8).
+void clsFrame(const uint16_t* raw, int32_t midQ13, uint16_t* logMel);
+
+// Features of CLS_FRAMES frames, then the network: percentages in pct, returns the top class.
+uint8_t clsInfer(const uint16_t logMel[CLS_FRAMES][CLS_MELS], uint8_t* pct);
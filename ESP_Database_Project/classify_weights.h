@@ -0,0 +1,84 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Acoustic Classifier Weights
+* File Name            : classify_weights.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   int8 weights and requantisation constants of the 32-16-5 classifier
+*   (classify.h). Generated by server/classifier_tool.py train; do not edit.
+*   Bootstrap model: synthetic traces (synth --files 12 --seconds 8 --seed 1). Retrain on
+*   recorded traces before trusting the labels.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+// Feature normalisation: x = clamp(((f - mu) * mul + 2^15) >> 16, -127, 127).
+static const int16_t CLS_MU[32] PROGMEM = {
+  7848, 7527, 7483, 7702, 7784, 7832, 7904, 7903, 7941, 7958, 7892, 7710, 7661, 7658, 7668, 7562,
+  275, 276, 295, 332, 347, 366, 379, 383, 384, 367, 414, 435, 368, 363, 344, 231,
+};
+static const int32_t CLS_MUL[32] PROGMEM = {
+  1530, 2087, 2114, 1823, 1834, 1871, 1801, 1860,
+  1931, 1930, 2225, 3112, 3281, 3250, 3282, 3422,
+  7171, 7257, 6661, 5415, 4865, 4472, 4281, 4317,
+  4437, 4767, 4466, 4201, 4750, 4461, 4605, 6686,
+};
+
+// Hidden layer, row per unit; h = min(127, (max(acc, 0) * CLS_M1 + 2^23) >> 24).
+static const int8_t CLS_W1[16 * 32] PROGMEM = {
+  25, 29, -13, -38, -49, -16, -47, -56, 6, 29, 50, -7, -1, -12, -53, 20,
+  1, 60, -8, -18, 24, -6, 19, -15, 18, 64, 57, 29, -26, 14, 7, 27,
+  8, 14, -9, 11, 26, -31, -6, -6, 67, 7, 24, 8, -15, -52, 25, -18,
+  17, -39, -11, 40, 46, -36, -36, 0, 17, -5, -1, -30, 22, 37, -8, -38,
+  -59, -21, -88, -28, -52, -20, -17, -3, 42, 0, 22, -20, -20, 9, -91, -11,
+  -2, -41, 13, -22, -74, -9, -28, -17, -7, 25, -7, -10, 8, -56, 34, -37,
+  -1, -45, -38, -23, 44, -8, -71, -52, -55, -22, -41, 7, -41, -10, -39, -47,
+  7, -9, 4, 20, 23, -71, -11, -82, -44, 27, -32, -37, -10, -15, -29, -46,
+  31, 26, -3, 17, 32, 43, 18, 24, -6, -38, -33, 8, 12, -7, -28, -5,
+  89, 82, 28, 47, 5, 9, 41, 31, 52, 47, 26, 44, -9, -27, 19, 86,
+  72, 42, 62, 73, -11, 37, -17, 40, 19, 0, 48, -20, -33, 41, -38, 67,
+  -11, -42, -20, -6, -17, -24, 14, -90, -38, -34, 29, -86, -37, -59, -43, 2,
+  -5, 23, -37, -8, 21, 14, -22, 20, -41, 45, -4, -14, -6, 16, 51, -10,
+  -8, 21, -23, -49, 28, -9, 37, -27, -84, 16, 9, 55, 22, 20, 33, 6,
+  -15, -13, 14, -52, -48, -21, -23, -68, 36, -31, 45, 82, 25, 21, 88, 84,
+  8, -66, -42, 12, -19, -54, -46, -31, 20, 34, 61, 6, 34, -6, 25, 70,
+  0, 11, 7, -6, 48, 39, 16, 4, 24, -11, 9, 16, 9, 55, 55, 40,
+  -29, 82, 50, 15, 29, 62, 60, 46, 22, 13, 33, 5, -17, -12, 0, 15,
+  59, -60, 0, -10, 3, 44, 45, -7, -20, -43, -4, 34, -16, 11, 11, 3,
+  26, -7, -30, -41, 23, -10, -12, 31, -22, 60, 26, -11, -18, 32, -37, -20,
+  54, 127, 56, 15, -20, -26, -12, 4, -25, 21, -83, 16, 24, 22, -7, -5,
+  21, -12, -3, -93, -9, -51, 4, -10, -12, -40, -17, -47, -35, -48, -72, 22,
+  16, -68, 20, -49, -15, -26, -24, 1, -14, -36, 24, 37, 60, -5, -16, 20,
+  18, -29, -25, 13, -5, 2, -24, -26, -5, 19, 8, 42, 32, 35, 45, -2,
+  -100, -49, -60, -43, -77, -34, -34, -39, -32, -60, -11, 24, -26, 8, -21, 23,
+  45, -47, -13, 28, 6, 1, -66, -2, 32, 42, 22, -15, -14, -41, -12, 51,
+  -24, -57, 24, -64, 25, 0, 51, 48, 10, 44, 8, -20, -39, -63, -40, 13,
+  23, 36, 75, 13, 8, -15, 6, 95, 61, 20, 35, -51, -28, -43, -68, 21,
+  19, -41, -8, -33, 15, 39, 79, 55, 10, -14, -45, -46, -8, -4, -17, 40,
+  5, -10, -16, -8, -38, -30, 9, -16, -3, 33, -11, 33, -6, 44, 17, -55,
+  70, -105, -41, 94, 102, 35, 69, 37, 74, 97, 72, 1, -85, -22, 7, -82,
+  -22, 2, -41, -25, -39, -25, -11, -21, -51, -16, -30, 25, 18, -33, -30, 11,
+};
+static const int32_t CLS_B1[16] PROGMEM = {
+  401, -515, 14, 397, 10, 1368, -76, 1923,
+  389, -73, 1607, 87, 22, 220, 255, -1143,
+};
+#define CLS_M1 50462L
+
+// Output layer, row per class; probabilities = softmax(acc * CLS_LOGIT_SCALE).
+static const int8_t CLS_W2[5 * 16] PROGMEM = {
+  -50, 0, 58, 81, -50, -85, -10, -73, 16, -20, -29, -35, 62, -109, -35, -4,
+  -30, -18, -28, 18, -22, 79, -33, 38, -10, -26, 126, -32, -80, -21, -50, -113,
+  13, -19, -49, -27, 89, -35, 4, -50, 57, -36, -18, -4, -27, -4, -23, -14,
+  53, -14, 33, -51, -56, -19, 22, 103, -31, 12, -73, 60, 28, 26, 31, -9,
+  -15, 20, -13, -51, 21, 49, -24, -41, -65, 17, -12, 9, -50, -58, 26, 127,
+};
+static const int32_t CLS_B2[5] PROGMEM = {
+  -103, 451, -116, 273, -506,
+};
+#define CLS_LOGIT_SCALE 9.862693095e-04f
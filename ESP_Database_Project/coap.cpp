@@ -0,0 +1,248 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - CoAP Transport
+* File Name            : coap.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Message encoding, Block1 segmentation and CON retransmission (see coap.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WiFi.h>, <WiFiUdp.h>
+*   - "coap.h", "netstats.h" (datagram bytes, exchanges, radio time)
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include "coap.h"
+#include "netstats.h"
+
+// Message types and codes.
+#define COAP_TYPE_CON 0
+#define COAP_TYPE_NON 1
+#define COAP_TYPE_ACK 2
+#define COAP_TYPE_RST 3
+#define COAP_CODE_POST 0x02
+
+// Option numbers (must be emitted in ascending order).
+#define COAP_OPT_URI_PATH       11
+#define COAP_OPT_CONTENT_FORMAT 12
+#define COAP_OPT_BLOCK1         27
+#define COAP_OPT_SIZE1          60
+
+#define COAP_TOKEN_LEN 4
+#define COAP_MAX_BLOCKS 64
+
+static WiFiUDP  g_udp;
+static bool     g_udpOpen = false;
+static uint16_t g_mid = 0;                 // next message ID
+static uint8_t  g_pkt[32 + 64 + COAP_BLOCK_SIZE];
+
+// Append one option; 'last' tracks the previous option number (delta encoding).
+static size_t putOption(uint8_t* p, uint16_t& last, uint16_t num, const uint8_t* val, size_t len) {
+  size_t o = 0;
+  uint16_t delta = num - last;
+  last = num;
+  auto nib = [](uint16_t v) -> uint8_t { return v < 13 ? v : (v < 269 ? 13 : 14); };
+  uint8_t dn = nib(delta), ln = nib((uint16_t)len);
+  p[o++] = (uint8_t)((dn << 4) | ln);
+  if (dn == 13) p[o++] = (uint8_t)(delta - 13);
+  else if (dn == 14) { uint16_t d = delta - 269; p[o++] = d >> 8; p[o++] = d & 0xFF; }
+  if (ln == 13) p[o++] = (uint8_t)(len - 13);
+  else if (ln == 14) { uint16_t l = (uint16_t)len - 269; p[o++] = l >> 8; p[o++] = l & 0xFF; }
+  memcpy(p + o, val, len);
+  return o + len;
+}
+
+// Minimal-length big-endian unsigned option value.
+static size_t putUintOption(uint8_t* p, uint16_t& last, uint16_t num, uint32_t v) {
+  uint8_t b[4];
+  size_t n = 0;
+  for (int s = 24; s >= 0; s -= 8) if (n || (v >> s) & 0xFF) b[n++] = (uint8_t)(v >> s);
+  return putOption(p, last, num, b, n);
+}
+
+// Build one CON POST carrying block 'num' of the payload.
+static size_t buildBlock(uint16_t mid, const uint8_t* token, const char* path, uint16_t fmt,
+                         const uint8_t* payload, size_t len, uint32_t num, bool blockwise) {
+  size_t off = (size_t)num * COAP_BLOCK_SIZE;
+  size_t chunk = min((size_t)COAP_BLOCK_SIZE, len - off);
+  bool more = off + chunk < len;
+
+  size_t o = 0;
+  g_pkt[o++] = (uint8_t)(0x40 | (COAP_TYPE_CON << 4) | COAP_TOKEN_LEN);   // ver 1
+  g_pkt[o++] = COAP_CODE_POST;
+  g_pkt[o++] = mid >> 8;
+  g_pkt[o++] = mid & 0xFF;
+  memcpy(g_pkt + o, token, COAP_TOKEN_LEN);
+  o += COAP_TOKEN_LEN;
+
+  uint16_t last = 0;
+  // Uri-Path: one option per non-empty segment.
+  const char* seg = path;
+  while (*seg) {
+    while (*seg == '/') seg++;
+    const char* end = seg;
+    while (*end && *end != '/') end++;
+    if (end > seg) o += putOption(g_pkt + o, last, COAP_OPT_URI_PATH, (const uint8_t*)seg, end - seg);
+    seg = end;
+  }
+  o += putUintOption(g_pkt + o, last, COAP_OPT_CONTENT_FORMAT, fmt);
+  if (blockwise) {
+    o += putUintOption(g_pkt + o, last, COAP_OPT_BLOCK1, (num << 4) | (more ? 0x08 : 0) | COAP_BLOCK_SZX);
+    if (num == 0) o += putUintOption(g_pkt + o, last, COAP_OPT_SIZE1, (uint32_t)len);
+  }
+  if (chunk) {
+    g_pkt[o++] = 0xFF;                       // payload marker
+    memcpy(g_pkt + o, payload + off, chunk);
+    o += chunk;
+  }
+  return o;
+}
+
+// Send an empty ACK for a separate (CON) response.
+static void sendEmptyAck(IPAddress ip, uint16_t port, uint16_t mid) {
+  uint8_t ack[4] = { (uint8_t)(0x40 | (COAP_TYPE_ACK << 4)), 0, (uint8_t)(mid >> 8), (uint8_t)(mid & 0xFF) };
+  g_udp.beginPacket(ip, port);
+  g_udp.write(ack, sizeof(ack));
+  g_udp.endPacket();
+  netTx(sizeof(ack));
+}
+
+// Transmit one block as CON and wait for its response, giving up at millis()
+// 'deadline'. Returns the response code (class*100+detail) or a COAP_ERR_* value.
+static int exchange(IPAddress ip, uint16_t port, size_t pktLen, uint16_t mid, const uint8_t* token,
+                    uint32_t deadline) {
+  // Initial timeout is randomised in [ACK_TIMEOUT, 1.5*ACK_TIMEOUT].
+  uint32_t timeout = COAP_ACK_TIMEOUT_MS + (uint32_t)random(COAP_ACK_TIMEOUT_MS / 2);
+  bool acked = false;    // empty ACK seen: response will arrive separately
+
+  for (uint8_t tx = 0; tx <= COAP_MAX_RETRANSMIT; tx++) {
+    int32_t left = (int32_t)(deadline - millis());
+    if (left <= 0) break;
+    if (timeout > (uint32_t)left) timeout = left;
+    if (!acked) {
+      g_udp.beginPacket(ip, port);
+      g_udp.write(g_pkt, pktLen);
+      g_udp.endPacket();
+      netTx(pktLen);
+    }
+    uint32_t t0 = millis();
+    while (millis() - t0 < timeout) {
+      int n = g_udp.parsePacket();
+      if (n <= 0) { delay(1); continue; }
+      netRx(n);
+      uint8_t rx[64];
+      n = g_udp.read(rx, sizeof(rx));      // options/payload beyond 64 B are not needed
+      if (n < 4 || (rx[0] >> 6) != 1) continue;
+      uint8_t type = (rx[0] >> 4) & 0x03;
+      uint8_t tkl = rx[0] & 0x0F;
+      uint8_t code = rx[1];
+      uint16_t rmid = ((uint16_t)rx[2] << 8) | rx[3];
+
+      if (type == COAP_TYPE_RST && rmid == mid) return COAP_ERR_RESET;
+      if (type == COAP_TYPE_ACK && rmid == mid) {
+        if (code == 0) { acked = true; continue; }            // empty ACK
+        return (code >> 5) * 100 + (code & 0x1F);             // piggybacked response
+      }
+      // Separate response: match by token, ACK it if confirmable.
+      if (acked && tkl == COAP_TOKEN_LEN && n >= 4 + COAP_TOKEN_LEN &&
+          memcmp(rx + 4, token, COAP_TOKEN_LEN) == 0 && code != 0) {
+        if (type == COAP_TYPE_CON) sendEmptyAck(g_udp.remoteIP(), g_udp.remotePort(), rmid);
+        return (code >> 5) * 100 + (code & 0x1F);
+      }
+    }
+    timeout *= 2;                          // exponential back-off
+  }
+  return COAP_ERR_TIMEOUT;
+}
+
+// Resolve 'host' and open the client socket on first use.
+static bool openSocket(const char* host, IPAddress& ip) {
+  if (!WiFi.hostByName(host, ip)) return false;
+  if (!g_udpOpen) {
+    g_mid = (uint16_t)ESP.random();        // random start avoids reuse across reboots
+    g_udpOpen = g_udp.begin(49152 + (ESP.random() % 16384));
+  }
+  return g_udpOpen;
+}
+
+int coapPing(const char* host, uint16_t port, uint32_t timeoutMs) {
+  IPAddress ip;
+  if (!openSocket(host, ip)) return COAP_ERR_SOCKET;
+  uint16_t mid = g_mid++;
+  uint8_t ping[4] = { (uint8_t)(0x40 | (COAP_TYPE_CON << 4)), 0, (uint8_t)(mid >> 8), (uint8_t)(mid & 0xFF) };
+  uint32_t t0 = millis();
+  g_udp.beginPacket(ip, port);
+  g_udp.write(ping, sizeof(ping));
+  g_udp.endPacket();
+  netTx(sizeof(ping));
+  while (millis() - t0 < timeoutMs) {
+    int n = g_udp.parsePacket();
+    if (n <= 0) { delay(1); continue; }
+    netRx(n);
+    uint8_t rx[4];
+    if (g_udp.read(rx, sizeof(rx)) < 4) continue;
+    if (((rx[0] >> 4) & 0x03) == COAP_TYPE_RST && (((uint16_t)rx[2] << 8) | rx[3]) == mid)
+      return (int)(millis() - t0);
+  }
+  return COAP_ERR_TIMEOUT;
+}
+
+// Send all blocks of one POST; coapPost() adds the accounting.
+static int postBlocks(IPAddress ip, uint16_t port, const char* path,
+                      const uint8_t* payload, size_t len, uint16_t contentFormat, uint32_t blocks) {
+  bool blockwise = blocks > 1;
+
+  uint8_t token[COAP_TOKEN_LEN];
+  uint32_t rnd = ESP.random();
+  memcpy(token, &rnd, COAP_TOKEN_LEN);
+
+  int code = COAP_ERR_TIMEOUT;
+  uint32_t deadline = millis() + COAP_POST_BUDGET_MS;
+  for (uint32_t num = 0; num < blocks; num++) {
+    uint16_t mid = g_mid++;
+    size_t n = buildBlock(mid, token, path, contentFormat, payload, len, num, blockwise);
+    code = exchange(ip, port, n, mid, token, deadline);
+    if (code < 0) return code;
+    bool last = num + 1 == blocks;
+    if (!last && code != 231) return code;  // expect 2.31 Continue between blocks
+  }
+  return code;
+}
+
+int coapPost(const char* host, uint16_t port, const char* path,
+             const uint8_t* payload, size_t len, uint16_t contentFormat) {
+  IPAddress ip;
+  if (!openSocket(host, ip)) return COAP_ERR_SOCKET;
+
+  uint32_t blocks = len ? (len + COAP_BLOCK_SIZE - 1) / COAP_BLOCK_SIZE : 1;
+  if (blocks > COAP_MAX_BLOCKS) return COAP_ERR_TOO_LARGE;
+
+  uint32_t t0 = millis();
+  int code = postBlocks(ip, port, path, payload, len, contentFormat, blocks);
+  uint32_t ms = millis() - t0;
+  netRequest(code >= 200 && code < 300, ms);
+  netRadio(ms);
+  return code;
+}
+
+bool coapParseBase(const char* base, String& host, uint16_t& port) {
+  String s = base;
+  int p = s.indexOf("//");
+  if (p >= 0) s = s.substring(p + 2);
+  int slash = s.indexOf('/');
+  if (slash >= 0) s = s.substring(0, slash);
+  port = COAP_DEFAULT_PORT;
+  int colon = s.indexOf(':');
+  if (colon >= 0) {
+    port = (uint16_t)s.substring(colon + 1).toInt();
+    s = s.substring(0, colon);
+  }
+  host = s;
+  return host.length() > 0 && port != 0;
+}
@@ -0,0 +1,83 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - CoAP Transport
+* File Name            : coap.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Minimal CoAP (RFC 7252) client over UDP for high-rate telemetry. A batch is
+*   sent as confirmable (CON) POSTs; payloads larger than one block use
+*   block-wise transfer (RFC 7959, Block1). Lost packets are retransmitted
+*   with exponential back-off, and the server deduplicates by message ID, so a
+*   retransmission never creates a second row.
+*
+* Inputs:
+*   - host/port/path of the CoAP ingest resource, payload bytes.
+*
+* Outputs:
+*   - coapPost(): final CoAP response code as class*100 + detail (201, 204, ...),
+*     or a negative COAP_ERR_* value.
+*   - coapPing(): liveness check for endpoint probing (endpoints.h).
+*
+* Example Application:
+*   BatchPayload body; uint8_t n = batchPayload(0, 8, tzRegion, body);
+*   int code = coapPost("192.168.1.20", 5683, "/ingest", body.data(), body.length(),
+*                       body.binary() ? COAP_FMT_BATCH : COAP_FMT_TEXT);
+*   if (code >= 200 && code < 300) readingDrop(n);
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <WiFiUdp.h>
+*
+* Usage Notes:
+*   - No connection setup or handshake: one datagram per block plus its ACK.
+*   - CON retransmission follows RFC 7252 (randomised ACK timeout, doubling)
+*     but stops at COAP_POST_BUDGET_MS, so a dead server stalls sampling for
+*     a few seconds per attempt rather than a minute and a half.
+*   - Blocks are COAP_BLOCK_SIZE bytes (SZX in the Block1 option).
+*   - Binary batches (batchcodec.h) go out with Content-Format COAP_FMT_BATCH.
+*   - DTLS-PSK is not available: neither the ESP8266 Arduino core nor its BearSSL
+*     build ships a DTLS stack. Use CoAP only on trusted networks.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#define COAP_DEFAULT_PORT   5683
+#define COAP_BLOCK_SZX      5                         // 2^(5+4) = 512-byte blocks
+#define COAP_BLOCK_SIZE     (1u << (COAP_BLOCK_SZX + 4))
+
+// RFC 7252 transmission parameters.
+#define COAP_ACK_TIMEOUT_MS 2000
+#define COAP_MAX_RETRANSMIT 4
+// Longest coapPost() may block loop(), all blocks and retransmissions
+// included. The full RFC schedule (62..93 s) is cut short; the batch
+// back-off in serviceBatch() (main.cpp) retries later instead.
+#ifndef COAP_POST_BUDGET_MS
+#define COAP_POST_BUDGET_MS 5000
+#endif
+
+// Content-Format registry values used here.
+#define COAP_FMT_TEXT       0      // text/plain;charset=utf-8
+#define COAP_FMT_OCTETS     42     // application/octet-stream
+
+// Negative return codes from coapPost().
+#define COAP_ERR_SOCKET     (-1)   // could not open the UDP socket / resolve host
+#define COAP_ERR_TIMEOUT    (-2)   // no ACK within COAP_POST_BUDGET_MS
+#define COAP_ERR_RESET      (-3)   // server answered RST
+#define COAP_ERR_TOO_LARGE  (-4)   // payload needs more blocks than allowed
+
+// POST 'len' bytes to coap://host:port/path. Blocks until the final response,
+// at most COAP_POST_BUDGET_MS.
+int coapPost(const char* host, uint16_t port, const char* path,
+             const uint8_t* payload, size_t len, uint16_t contentFormat);
+
+// CoAP ping (RFC 7252 4.3): an empty CON that any CoAP endpoint answers with
+// RST. One try, no retransmission. Returns the round trip in ms, or a
+// negative COAP_ERR_* value.
+int coapPing(const char* host, uint16_t port, uint32_t timeoutMs);
+
+// Split "coap://host[:port]" into host and port (default COAP_DEFAULT_PORT).
+bool coapParseBase(const char* base, String& host, uint16_t& port);
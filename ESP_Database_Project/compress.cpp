@@ -0,0 +1,179 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Batch Payload Compression
+* File Name            : compress.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   LZSS encoder with a bounded hash-chain match search, the matching decoder,
+*   and the optional compression benchmark (see compress.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "compress.h", "sendRequest.h" (formBody() for bench batches)
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include "compress.h"
+
+#define HS_WINDOW      (1u << HS_WINDOW_BITS)
+#define HS_MAX_MATCH   (1u << HS_LOOKAHEAD_BITS)
+#define HS_MIN_MATCH   2        // 1+W+L = 14 bits beats two literals (18 bits)
+#define HS_MAX_CHAIN   16       // candidates examined per position
+#define HS_HASH_SIZE   256
+
+// Match index: most recent position (+1, 0 = none) per 2-byte hash, and the
+// previous position with the same hash for each window slot.
+static uint16_t g_head[HS_HASH_SIZE];
+static uint16_t g_prev[HS_WINDOW];
+
+static inline uint8_t hash2(const uint8_t* p) { return (uint8_t)((p[0] << 3) ^ p[1]); }
+
+// MSB-first bit writer into a bounded buffer.
+struct BitWriter {
+  uint8_t* out; size_t cap; size_t len; uint8_t acc; uint8_t used; bool full;
+  void put(uint16_t v, uint8_t bits) {
+    while (bits--) {
+      acc = (acc << 1) | ((v >> bits) & 1);
+      if (++used == 8) {
+        if (len < cap) out[len++] = acc; else full = true;
+        acc = 0; used = 0;
+      }
+    }
+  }
+  size_t finish() {
+    if (used) put(0, 8 - used);
+    return full ? 0 : len;
+  }
+};
+
+static inline void insert(const uint8_t* in, size_t i, size_t n) {
+  if (i + 1 >= n) return;
+  uint8_t h = hash2(in + i);
+  g_prev[i & (HS_WINDOW - 1)] = g_head[h];
+  g_head[h] = (uint16_t)(i + 1);
+}
+
+size_t hsCompress(const uint8_t* in, size_t n, uint8_t* out, size_t cap) {
+  if (n == 0 || n > 0xFFFE) return 0;       // chain entries are 16-bit positions
+  if (cap > n - 1) cap = n - 1;             // must beat the identity encoding
+  memset(g_head, 0, sizeof(g_head));
+  BitWriter bw = { out, cap, 0, 0, 0, false };
+
+  size_t i = 0;
+  while (i < n && !bw.full) {
+    size_t bestLen = 0, bestOff = 0;
+    size_t maxLen = min<size_t>(HS_MAX_MATCH, n - i);
+    if (maxLen >= HS_MIN_MATCH) {
+      uint16_t cand = g_head[hash2(in + i)];
+      for (uint8_t depth = 0; cand && depth < HS_MAX_CHAIN; depth++) {
+        size_t j = cand - 1;
+        if (i - j > HS_WINDOW) break;       // chain only gets older
+        size_t len = 0;
+        while (len < maxLen && in[j + len] == in[i + len]) len++;
+        if (len > bestLen) {
+          bestLen = len; bestOff = i - j;
+          if (len == maxLen) break;
+        }
+        cand = g_prev[j & (HS_WINDOW - 1)];
+      }
+    }
+
+    if (bestLen >= HS_MIN_MATCH) {
+      bw.put(0, 1);
+      bw.put((uint16_t)(bestOff - 1), HS_WINDOW_BITS);
+      bw.put((uint16_t)(bestLen - 1), HS_LOOKAHEAD_BITS);
+      for (size_t k = 0; k < bestLen; k++) insert(in, i + k, n);
+      i += bestLen;
+    } else {
+      bw.put(1, 1);
+      bw.put(in[i], 8);
+      insert(in, i, n);
+      i++;
+    }
+  }
+  return bw.finish();
+}
+
+size_t hsDecompress(const uint8_t* in, size_t n, uint8_t* out, size_t cap) {
+  size_t bitPos = 0, totalBits = n * 8, len = 0;
+  auto get = [&](uint8_t bits) -> uint16_t {
+    uint16_t v = 0;
+    while (bits--) {
+      v = (v << 1) | ((in[bitPos >> 3] >> (7 - (bitPos & 7))) & 1);
+      bitPos++;
+    }
+    return v;
+  };
+
+  // Trailing pad bits are shorter than any complete token.
+  while (bitPos < totalBits) {
+    if (get(1)) {
+      if (totalBits - bitPos < 8) break;
+      if (len >= cap) return 0;
+      out[len++] = (uint8_t)get(8);
+    } else {
+      if (totalBits - bitPos < HS_WINDOW_BITS + HS_LOOKAHEAD_BITS) break;
+      size_t off = get(HS_WINDOW_BITS) + 1;
+      size_t cnt = get(HS_LOOKAHEAD_BITS) + 1;
+      if (off > len || len + cnt > cap) return 0;
+      for (size_t k = 0; k < cnt; k++, len++) out[len] = out[len - off];
+    }
+  }
+  return len;
+}
+
+#ifdef COMPRESS_BENCH
+#include "sendRequest.h"
+
+// Representative batch: alternating nodes, one reading every few seconds.
+static String benchBatch(uint8_t readings) {
+  String body;
+  for (uint8_t r = 0; r < readings; r++) {
+    char iso[32];
+    snprintf(iso, sizeof(iso), "2026-10-18T09:%02u:%02u.%03uZ", (r * 7 / 60) % 60, (r * 7) % 60, (r * 113) % 1000);
+    bool ultra = r & 1;
+    Reading rd = {};
+    rd.node = ultra ? READING_NODE_ULTRA : READING_NODE_SOUND;
+    rd.fields = ultra ? READING_FIELD_DIST : READING_FIELD_SOUND;
+    rd.distance_cm = ultra ? 20.0f + (r % 9) * 1.37f : 0.0f;
+    rd.sound_db = ultra ? 0.0f : 38.0f + (r % 5) * 2.11f;
+    if (r) body += '\n';
+    body += formBody(rd, iso, "America/Los_Angeles");
+  }
+  return body;
+}
+
+void runCompressBench() {
+  static const uint8_t SIZES[] = { 1, 4, 8, 16, 32 };
+  Serial.println(F("\n[bench] batch compression (" HS_CONTENT_ENCODING ")"));
+  Serial.println(F("  readings   raw B  comp B  ratio  enc cyc/KB  dec cyc/KB  B/reading"));
+  for (uint8_t s = 0; s < sizeof(SIZES); s++) {
+    String body = benchBatch(SIZES[s]);
+    size_t n = body.length();
+    std::unique_ptr<uint8_t[]> comp(new uint8_t[n]);
+    std::unique_ptr<uint8_t[]> back(new uint8_t[n]);
+
+    uint32_t t0 = ESP.getCycleCount();
+    size_t c = hsCompress((const uint8_t*)body.c_str(), n, comp.get(), n);
+    uint32_t tEnc = ESP.getCycleCount() - t0;
+    size_t d = 0;
+    uint32_t tDec = 0;
+    if (c) {
+      t0 = ESP.getCycleCount();
+      d = hsDecompress(comp.get(), c, back.get(), n);
+      tDec = ESP.getCycleCount() - t0;
+    }
+    bool ok = c && d == n && !memcmp(back.get(), body.c_str(), n);
+    size_t sent = c ? c : n;
+    Serial.printf("  %8u  %6u  %6u  %5.2f  %10lu  %10lu  %9.1f %s\n",
+                  SIZES[s], (unsigned)n, (unsigned)sent, (float)n / sent,
+                  (unsigned long)((uint64_t)tEnc * 1024 / n), (unsigned long)((uint64_t)tDec * 1024 / n),
+                  (float)sent / SIZES[s], ok ? "" : (c ? "ROUND-TRIP FAILED" : "(not smaller)"));
+    yield();
+  }
+}
+#endif // COMPRESS_BENCH
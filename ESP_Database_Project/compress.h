@@ -0,0 +1,62 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Batch Payload Compression
+* File Name            : compress.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Small-footprint LZSS codec for batch upload bodies, using the heatshrink
+*   bitstream (window 2^HS_WINDOW_BITS, lookahead 2^HS_LOOKAHEAD_BITS):
+*     '1' + 8 bits                    literal byte
+*     '0' + W bits (offset - 1) + L bits (length - 1)   back-reference
+*   bits MSB first, last byte zero-padded. Batched readings repeat node_name,
+*   tz_region and most of the timestamp on every line, so the previous line is
+*   almost always inside the 512-byte window.
+*
+* Inputs:
+*   - Batch body already in RAM (batchPayload(), batchcodec.h).
+*
+* Outputs:
+*   - hsCompress()   : compressed bytes, or 0 if the result would not be smaller.
+*   - hsDecompress() : inverse, for round-trip checks and the bench.
+*   - runCompressBench(): ratio and CPU cycles per KB for 1..32-reading batches.
+*
+* Example Application:
+*   uint8_t* out = new uint8_t[body.length()];
+*   size_t n = hsCompress((const uint8_t*)body.c_str(), body.length(), out, body.length());
+*   if (n) { http.addHeader("Content-Encoding", HS_CONTENT_ENCODING); http.POST(out, n); }
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*
+* Usage Notes:
+*   - The encoder's match index (hash heads + chain over the window) is 1.5 KB
+*     of static RAM; the window itself is the input buffer, no copy is made.
+*   - The decoder needs no state beyond its output buffer.
+*   - Window / lookahead sizes are part of the coding name; change both together.
+*   - Build with -DCOMPRESS_BENCH (bench environment) for the measurements.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#define HS_WINDOW_BITS      9
+#define HS_LOOKAHEAD_BITS   4
+#define HS_CONTENT_ENCODING "x-heatshrink-w9l4"   // Content-Encoding token
+
+// Compress n bytes from 'in' into 'out' (capacity 'cap').
+// Returns the compressed size, or 0 if it would not be smaller than n
+// (or does not fit 'cap'); send the body uncompressed in that case.
+size_t hsCompress(const uint8_t* in, size_t n, uint8_t* out, size_t cap);
+
+// Decompress into 'out'; returns the decoded size, or 0 on overflow.
+size_t hsDecompress(const uint8_t* in, size_t n, uint8_t* out, size_t cap);
+
+#ifdef COMPRESS_BENCH
+// Compression ratio and cycles/KB (both directions) for synthetic batches
+// built from formBody() lines.
+void runCompressBench();
+#endif
@@ -0,0 +1,386 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Runtime Configuration Store
+* File Name            : config.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Load, validate, edit and persist the NodeConfig block declared in config.h.
+*
+* Inputs:
+*   - Emulated EEPROM sector (CONFIG_EEPROM_SIZE bytes at CONFIG_EEPROM_OFFSET).
+*
+* Outputs:
+*   - RAM copy of the configuration; batched flash commits.
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <EEPROM.h>
+*   - "config.h"
+*
+* Usage Notes:
+*   - The EEPROM library keeps its own RAM mirror of the sector and only erases
+*     and rewrites flash on commit() when that mirror changed, so a commit of an
+*     identical image costs nothing. We still compare first to skip the copy.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "config.h"
+
+static NodeConfig     g_cfg;
+static bool           g_dirty = false;
+static unsigned long  g_dirtyMs = 0;
+
+// Standard CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320), nibble table.
+// 16 entries keep flash use tiny; the block is small and read once per boot.
+uint32_t configCrc32(const uint8_t* p, size_t n) {
+  static const uint32_t T[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+  uint32_t c = 0xFFFFFFFFu;
+  while (n--) {
+    c ^= *p++;
+    c = (c >> 4) ^ T[c & 0x0F];
+    c = (c >> 4) ^ T[c & 0x0F];
+  }
+  return ~c;
+}
+
+static const size_t CONFIG_HDR_SIZE = offsetof(NodeConfig, crc32) + sizeof(uint32_t);
+
+// CRC over the payload that follows the header, up to 'len' bytes of image.
+static uint32_t payloadCrc(const void* image, size_t len) {
+  return configCrc32(reinterpret_cast<const uint8_t*>(image) + CONFIG_HDR_SIZE, len - CONFIG_HDR_SIZE);
+}
+
+// Copy a C string into a fixed field, always NUL-terminated.
+static void copyField(char* dst, size_t cap, const char* src) {
+  strncpy(dst, src, cap - 1);
+  dst[cap - 1] = '\0';
+}
+
+static void loadDefaults(NodeConfig& c) {
+  memset(&c, 0, sizeof(c));
+  c.magic   = CONFIG_MAGIC;
+  c.version = CONFIG_VERSION;
+  c.length  = sizeof(NodeConfig);
+
+  copyField(c.wifi_ssid,   sizeof(c.wifi_ssid),   CFG_DEFAULT_WIFI_SSID);
+  copyField(c.wifi_pass,   sizeof(c.wifi_pass),   CFG_DEFAULT_WIFI_PASS);
+  copyField(c.server_base, sizeof(c.server_base), CFG_DEFAULT_SERVER_BASE);
+  copyField(c.post_path,   sizeof(c.post_path),   CFG_DEFAULT_POST_PATH);
+
+  c.pin_trig      = D5;  // HC-SR04 trig
+  c.pin_echo      = D1;  // HC-SR04 echo
+  c.pin_btn_ultra = D3;  // pushbutton to GND (INPUT_PULLUP)
+  c.pin_btn_sound = D7;  // pushbutton to GND (INPUT_PULLUP)
+  c.pin_sound     = A0;  // MAX4466 analog out
+
+  c.samples       = CFG_DEFAULT_SAMPLES;
+  c.target_fs     = CFG_DEFAULT_TARGET_FS;
+  c.ref_rms       = CFG_DEFAULT_REF_RMS;
+  c.cal_db_at_ref = CFG_DEFAULT_CAL_DB_AT_REF;
+  c.thresholds_db[0] = 35.0f;  // Quiet  < 35
+  c.thresholds_db[1] = 60.0f;  // Normal 35–60
+  c.thresholds_db[2] = 75.0f;  // Loud   60–75, Very Loud > 75
+
+  c.ntp_add_hours = NTP_ADD_HOURS;
+
+  c.transport = CFG_DEFAULT_TRANSPORT;
+  // node_key stays all-zero until provisioned ("cfg set node_key <64 hex>").
+
+  c.tls_mode = CFG_DEFAULT_TLS_MODE;
+  // tls_fp[] stays all-zero (unused) until "cfg set tls_fp<n> <40 hex>".
+
+  c.batch_size = CFG_DEFAULT_BATCH_SIZE;
+  c.flush_ms   = CFG_DEFAULT_FLUSH_MS;
+
+  copyField(c.mqtt_topic, sizeof(c.mqtt_topic), CFG_DEFAULT_MQTT_TOPIC);
+
+  c.live_rate_hz = CFG_DEFAULT_LIVE_RATE_HZ;
+  c.summary_s    = CFG_DEFAULT_SUMMARY_S;
+  c.compress     = CFG_DEFAULT_COMPRESS;
+  c.batch_format = CFG_DEFAULT_BATCH_FORMAT;
+  c.link_adapt   = CFG_DEFAULT_LINK_ADAPT;
+  c.metrics_port = CFG_DEFAULT_METRICS_PORT;
+  c.oversample   = CFG_DEFAULT_OVERSAMPLE;
+  c.tw_rate_hz   = CFG_DEFAULT_TW_RATE_HZ;
+  c.cls_period_s = CFG_DEFAULT_CLS_PERIOD_S;
+  c.quality_drop = CFG_DEFAULT_QUALITY_DROP;
+  c.range_min_cm = CFG_DEFAULT_RANGE_MIN_CM;
+  c.range_max_cm = CFG_DEFAULT_RANGE_MAX_CM;
+  c.range_pings  = CFG_DEFAULT_RANGE_PINGS;
+  c.range_idle_ms   = CFG_DEFAULT_RANGE_IDLE_MS;
+  c.range_motion_cm = CFG_DEFAULT_RANGE_MOTION_CM;
+  // live_url stays empty until "cfg set live_url ws://...".
+}
+
+// Parse exactly 2*n hex digits into out[]; false on bad length or digit.
+static bool parseHex(const char* s, uint8_t* out, size_t n) {
+  if (strlen(s) != 2 * n) return false;
+  for (size_t i = 0; i < n; i++) {
+    uint8_t b = 0;
+    for (uint8_t k = 0; k < 2; k++) {
+      char ch = s[2 * i + k];
+      b <<= 4;
+      if      (ch >= '0' && ch <= '9') b |= ch - '0';
+      else if (ch >= 'a' && ch <= 'f') b |= ch - 'a' + 10;
+      else if (ch >= 'A' && ch <= 'F') b |= ch - 'A' + 10;
+      else return false;
+    }
+    out[i] = b;
+  }
+  return true;
+}
+
+// Reject values that would break sampling (e.g., divide by zero).
+static bool sane(const NodeConfig& c) {
+  for (uint8_t i = 0; i < CFG_ALT_BASES; i++)
+    if (c.server_alt[i][sizeof(c.server_alt[i]) - 1] != '\0') return false;
+  return c.samples > 0 && c.target_fs > 0 && c.target_fs <= 100000UL &&
+         c.transport <= TRANSPORT_LAST &&
+         c.batch_size > 0 &&
+         c.tls_mode <= TLS_CA &&
+         c.wifi_ssid[sizeof(c.wifi_ssid) - 1] == '\0' &&
+         c.wifi_pass[sizeof(c.wifi_pass) - 1] == '\0' &&
+         c.server_base[sizeof(c.server_base) - 1] == '\0' &&
+         c.post_path[sizeof(c.post_path) - 1] == '\0' &&
+         c.mqtt_topic[sizeof(c.mqtt_topic) - 1] == '\0' &&
+         c.live_url[sizeof(c.live_url) - 1] == '\0' &&
+         c.live_rate_hz <= 50 && c.summary_s > 0 &&
+         c.compress <= COMPRESS_ON &&
+         c.batch_format <= BATCH_FORMAT_BINARY &&
+         c.link_adapt <= 1 &&
+         c.oversample > 0 && c.oversample <= 16 && !(c.oversample & (c.oversample - 1)) &&
+         (uint64_t)c.target_fs * c.oversample <= 100000ULL &&
+         c.tw_rate_hz <= 50 && c.tw_rate_hz <= c.target_fs &&
+         (c.cls_period_s == 0 || c.target_fs >= 1000) &&
+         c.quality_drop <= 0x7F &&
+         c.range_min_cm >= 2 && c.range_min_cm < c.range_max_cm && c.range_max_cm <= 600 &&
+         c.range_pings >= 1 && c.range_pings <= 9 &&
+         (c.range_idle_ms == 0 || c.range_idle_ms >= 50) && c.range_motion_cm > 0;
+}
+
+bool configBegin() {
+  EEPROM.begin(CONFIG_EEPROM_SIZE);
+
+  // Straight binary copy out of the RAM mirror; no parsing.
+  const uint8_t* image = EEPROM.getConstDataPtr() + CONFIG_EEPROM_OFFSET;
+  NodeConfig stored;
+  memcpy(&stored, image, sizeof(stored));
+
+  // Fields are only ever appended, so an older (shorter) block is still
+  // usable: take its prefix and keep defaults for the newer fields.
+  bool valid = stored.magic == CONFIG_MAGIC &&
+               stored.version <= CONFIG_VERSION &&
+               stored.length > CONFIG_HDR_SIZE &&
+               stored.length <= sizeof(NodeConfig) &&
+               stored.crc32 == payloadCrc(image, stored.length);
+
+  loadDefaults(g_cfg);
+  if (valid) {
+    memcpy(&g_cfg, image, stored.length);
+    if (!sane(g_cfg)) valid = false;
+  }
+  if (!valid) {
+    Serial.println(F("[cfg] no valid block, using defaults"));
+    loadDefaults(g_cfg);
+    // Not written until something changes: a fresh board with defaults
+    // needs no flash cycle at all.
+    g_dirty = false;
+    return false;
+  }
+
+  // Upgraded from an older layout: persist the new image lazily.
+  g_dirty = false;
+  if (stored.version != CONFIG_VERSION) {
+    Serial.printf("[cfg] migrated v%u -> v%u\n", stored.version, CONFIG_VERSION);
+    configMarkDirty();
+  }
+  return true;
+}
+
+const NodeConfig& config() { return g_cfg; }
+
+NodeConfig& configEdit() { return g_cfg; }
+
+void configMarkDirty() {
+  g_dirty = true;
+  g_dirtyMs = millis();   // each change restarts the quiet window
+}
+
+void configReset() {
+  loadDefaults(g_cfg);
+  configMarkDirty();
+}
+
+bool configFlush() {
+  if (!g_dirty) return true;
+  g_dirty = false;
+
+  g_cfg.magic   = CONFIG_MAGIC;
+  g_cfg.version = CONFIG_VERSION;
+  g_cfg.length  = sizeof(NodeConfig);
+  g_cfg.crc32   = payloadCrc(&g_cfg, sizeof(NodeConfig));
+
+  uint8_t* mirror = EEPROM.getDataPtr() + CONFIG_EEPROM_OFFSET;
+  if (memcmp(mirror, &g_cfg, sizeof(g_cfg)) == 0) return true;  // nothing to wear
+
+  memcpy(mirror, &g_cfg, sizeof(g_cfg));
+  bool ok = EEPROM.commit();
+  Serial.println(ok ? F("[cfg] committed") : F("[cfg] commit FAILED"));
+  return ok;
+}
+
+void configService() {
+  if (g_dirty && (millis() - g_dirtyMs >= CONFIG_COMMIT_DELAY_MS)) configFlush();
+}
+
+bool configSetField(const char* key, const char* value) {
+  NodeConfig& c = g_cfg;
+  const NodeConfig prev = c;   // restored if the new value is rejected
+  char* end = nullptr;
+
+  if      (!strcmp(key, "wifi_ssid"))   copyField(c.wifi_ssid,   sizeof(c.wifi_ssid),   value);
+  else if (!strcmp(key, "wifi_pass"))   copyField(c.wifi_pass,   sizeof(c.wifi_pass),   value);
+  else if (!strcmp(key, "server_base")) copyField(c.server_base, sizeof(c.server_base), value);
+  else if (!strncmp(key, "server_alt", 10) && key[10] >= '0' && key[10] < '0' + CFG_ALT_BASES && !key[11]) {
+    // "none" clears the slot.
+    char* alt = c.server_alt[key[10] - '0'];
+    if (!strcmp(value, "none")) alt[0] = '\0';
+    else copyField(alt, sizeof(c.server_alt[0]), value);
+  }
+  else if (!strcmp(key, "post_path"))   copyField(c.post_path,   sizeof(c.post_path),   value);
+  else if (!strcmp(key, "mqtt_topic"))  copyField(c.mqtt_topic,  sizeof(c.mqtt_topic),  value);
+  else if (!strcmp(key, "live_url"))    copyField(c.live_url,    sizeof(c.live_url),    value);
+  else if (!strcmp(key, "live_rate_hz"))  c.live_rate_hz = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "summary_s"))     c.summary_s    = (uint16_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "pin_trig"))      c.pin_trig      = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "pin_echo"))      c.pin_echo      = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "pin_btn_ultra")) c.pin_btn_ultra = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "pin_btn_sound")) c.pin_btn_sound = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "pin_sound"))     c.pin_sound     = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "samples"))       c.samples       = (uint16_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "target_fs"))     c.target_fs     = strtoul(value, &end, 0);
+  else if (!strcmp(key, "ref_rms"))       c.ref_rms       = strtof(value, &end);
+  else if (!strcmp(key, "cal_db_at_ref")) c.cal_db_at_ref = strtof(value, &end);
+  else if (!strcmp(key, "threshold0"))    c.thresholds_db[0] = strtof(value, &end);
+  else if (!strcmp(key, "threshold1"))    c.thresholds_db[1] = strtof(value, &end);
+  else if (!strcmp(key, "threshold2"))    c.thresholds_db[2] = strtof(value, &end);
+  else if (!strcmp(key, "ntp_add_hours")) c.ntp_add_hours = (int8_t)strtol(value, &end, 0);
+  else if (!strcmp(key, "transport")) {
+    if      (!strcmp(value, "https"))     c.transport = TRANSPORT_HTTPS;
+    else if (!strcmp(value, "hmac_http")) c.transport = TRANSPORT_HMAC_HTTP;
+    else if (!strcmp(value, "coap"))      c.transport = TRANSPORT_COAP;
+    else if (!strcmp(value, "mqtt"))      c.transport = TRANSPORT_MQTT;
+    else if (!strcmp(value, "https_batch")) c.transport = TRANSPORT_HTTPS_BATCH;
+    else return false;
+  }
+  else if (!strcmp(key, "node_key")) {
+    if (!parseHex(value, c.node_key, NODE_KEY_LEN)) { c = prev; return false; }
+  }
+  else if (!strcmp(key, "batch_size"))    c.batch_size = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "flush_ms"))      c.flush_ms   = strtoul(value, &end, 0);
+  else if (!strcmp(key, "metrics_port"))  c.metrics_port = (uint16_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "oversample"))    c.oversample   = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "tw_rate_hz"))    c.tw_rate_hz   = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "cls_period_s"))  c.cls_period_s = (uint16_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "quality_drop"))  c.quality_drop = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "range_min_cm"))  c.range_min_cm = (uint16_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "range_max_cm"))  c.range_max_cm = (uint16_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "range_pings"))   c.range_pings  = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "range_idle_ms")) c.range_idle_ms = (uint16_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "range_motion_cm")) c.range_motion_cm = (uint8_t)strtoul(value, &end, 0);
+  else if (!strcmp(key, "range_profile")) {
+    // Presets for range_min_cm / range_max_cm / range_pings.
+    if      (!strcmp(value, "near")) { c.range_min_cm = 3; c.range_max_cm = 100; c.range_pings = 3; }
+    else if (!strcmp(value, "room")) { c.range_min_cm = 3; c.range_max_cm = 300; c.range_pings = 3; }
+    else if (!strcmp(value, "full")) { c.range_min_cm = CFG_DEFAULT_RANGE_MIN_CM;
+                                       c.range_max_cm = CFG_DEFAULT_RANGE_MAX_CM;
+                                       c.range_pings  = CFG_DEFAULT_RANGE_PINGS; }
+    else return false;
+  }
+  else if (!strcmp(key, "link_adapt")) {
+    if      (!strcmp(value, "off")) c.link_adapt = 0;
+    else if (!strcmp(value, "on"))  c.link_adapt = 1;
+    else return false;
+  }
+  else if (!strcmp(key, "compress")) {
+    if      (!strcmp(value, "off"))  c.compress = COMPRESS_OFF;
+    else if (!strcmp(value, "auto")) c.compress = COMPRESS_AUTO;
+    else if (!strcmp(value, "on"))   c.compress = COMPRESS_ON;
+    else return false;
+  }
+  else if (!strcmp(key, "batch_format")) {
+    if      (!strcmp(value, "text"))   c.batch_format = BATCH_FORMAT_TEXT;
+    else if (!strcmp(value, "binary")) c.batch_format = BATCH_FORMAT_BINARY;
+    else return false;
+  }
+  else if (!strcmp(key, "tls_mode")) {
+    if      (!strcmp(value, "insecure")) c.tls_mode = TLS_INSECURE;
+    else if (!strcmp(value, "pinned"))   c.tls_mode = TLS_PINNED;
+    else if (!strcmp(value, "ca"))       c.tls_mode = TLS_CA;
+    else return false;
+  }
+  else if (!strncmp(key, "tls_fp", 6) && key[6] >= '0' && key[6] < '0' + TLS_FP_PINS && !key[7]) {
+    // "none" clears the slot; otherwise 40 hex digits (colons allowed).
+    uint8_t* fp = c.tls_fp[key[6] - '0'];
+    if (!strcmp(value, "none")) { memset(fp, 0, TLS_FP_LEN); }
+    else {
+      char hex[2 * TLS_FP_LEN + 1];
+      size_t n = 0;
+      for (const char* p = value; *p && n < sizeof(hex) - 1; p++) if (*p != ':') hex[n++] = *p;
+      hex[n] = '\0';
+      if (!parseHex(hex, fp, TLS_FP_LEN)) { c = prev; return false; }
+    }
+  }
+  else return false;
+
+  bool parsed = !end || (end != value && *end == '\0');   // numeric fields only
+  if (!parsed || !sane(c)) { c = prev; return false; }
+  configMarkDirty();
+  return true;
+}
+
+void configPrint() {
+  const NodeConfig& c = g_cfg;
+  Serial.printf("[cfg] v%u  %s\n", c.version, g_dirty ? "(pending commit)" : "");
+  Serial.printf("  wifi_ssid=%s  wifi_pass=%s\n", c.wifi_ssid, c.wifi_pass[0] ? "****" : "");
+  Serial.printf("  server_base=%s  post_path=%s\n", c.server_base, c.post_path);
+  for (uint8_t i = 0; i < CFG_ALT_BASES; i++)
+    if (c.server_alt[i][0]) Serial.printf("  server_alt%u=%s\n", i, c.server_alt[i]);
+  Serial.printf("  pins trig=%u echo=%u btn_ultra=%u btn_sound=%u sound=%u\n",
+                c.pin_trig, c.pin_echo, c.pin_btn_ultra, c.pin_btn_sound, c.pin_sound);
+  Serial.printf("  samples=%u target_fs=%lu oversample=%u ref_rms=%.4f cal_db_at_ref=%.1f\n",
+                c.samples, (unsigned long)c.target_fs, c.oversample, c.ref_rms, c.cal_db_at_ref);
+  Serial.printf("  thresholds=%.1f/%.1f/%.1f ntp_add_hours=%d\n",
+                c.thresholds_db[0], c.thresholds_db[1], c.thresholds_db[2], c.ntp_add_hours);
+  bool keySet = false;
+  for (uint8_t i = 0; i < NODE_KEY_LEN; i++) keySet |= (c.node_key[i] != 0);
+  static const char* const TRANSPORT_NAMES[] = { "https", "hmac_http", "coap", "mqtt", "https_batch" };
+  Serial.printf("  transport=%s node_key=%s batch_size=%u flush_ms=%lu link_adapt=%s\n",
+                TRANSPORT_NAMES[c.transport], keySet ? "****" : "(unset)",
+                c.batch_size, (unsigned long)c.flush_ms, c.link_adapt ? "on" : "off");
+  Serial.printf("  mqtt_topic=%s\n", c.mqtt_topic);
+  Serial.printf("  live_url=%s live_rate_hz=%u summary_s=%u\n", c.live_url, c.live_rate_hz, c.summary_s);
+  static const char* const COMPRESS_NAMES[] = { "off", "auto", "on" };
+  static const char* const FORMAT_NAMES[] = { "text", "binary" };
+  Serial.printf("  compress=%s batch_format=%s\n", COMPRESS_NAMES[c.compress], FORMAT_NAMES[c.batch_format]);
+  Serial.printf("  metrics_port=%u tw_rate_hz=%u cls_period_s=%u quality_drop=0x%02x\n",
+                c.metrics_port, c.tw_rate_hz, c.cls_period_s, c.quality_drop);
+  Serial.printf("  range_min_cm=%u range_max_cm=%u range_pings=%u range_idle_ms=%u range_motion_cm=%u\n",
+                c.range_min_cm, c.range_max_cm, c.range_pings, c.range_idle_ms, c.range_motion_cm);
+  static const char* const TLS_NAMES[] = { "insecure", "pinned", "ca" };
+  Serial.printf("  tls_mode=%s\n", TLS_NAMES[c.tls_mode]);
+  for (uint8_t i = 0; i < TLS_FP_PINS; i++) {
+    bool used = false;
+    for (uint8_t k = 0; k < TLS_FP_LEN; k++) used |= (c.tls_fp[i][k] != 0);
+    if (!used) continue;
+    Serial.printf("  tls_fp%u=", i);
+    for (uint8_t k = 0; k < TLS_FP_LEN; k++) Serial.printf("%02X%s", c.tls_fp[i][k], k + 1 < TLS_FP_LEN ? ":" : "\n");
+  }
+}
@@ -0,0 +1,311 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Runtime Configuration Store
+* File Name            : config.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Declare the persistent node configuration. Every tunable that used to be a
+*   compile-time constant (Wi-Fi credentials, endpoint, pins, sampling and
+*   calibration values, NTP offset) lives in one packed, versioned, CRC-protected
+*   binary block in the emulated EEPROM sector.
+*
+* Inputs:
+*   - Flash sector contents at boot (copied to RAM by the EEPROM library).
+*   - configSet*() / configSetField() calls at runtime.
+*
+* Outputs:
+*   - config(): read-only reference to the live NodeConfig in RAM.
+*   - Flash commits, batched by configService().
+*
+* Example Application:
+*   configBegin();                         // in setup(), before Wi-Fi
+*   WiFi.begin(config().wifi_ssid, config().wifi_pass);
+*   ...
+*   configSetField("samples", "400");      // RAM only, marks dirty
+*   configService();                       // in loop(); commits once quiet
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - <EEPROM.h> (flash sector emulation)
+*
+* Usage Notes:
+*   - Boot load is a single memcpy plus CRC check; there is no text parsing.
+*   - A missing or corrupt block falls back to the compile-time defaults below
+*     (override them with -D build flags). An older block is migrated: its
+*     fields are kept and newer fields take their defaults.
+*   - Writes only touch RAM. configService() commits after CONFIG_COMMIT_DELAY_MS
+*     without further changes, and skips the erase/write when the image in
+*     flash is already identical.
+*   - Only append fields to NodeConfig, and bump CONFIG_VERSION when you do.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+// ================== Layout ==================
+#define CONFIG_MAGIC          0x4346u   // "CF"
+#define CONFIG_VERSION        17
+#define CONFIG_EEPROM_SIZE    1024      // bytes mirrored in RAM by EEPROM.begin()
+#define CONFIG_EEPROM_OFFSET  0
+#define CONFIG_SEQ_OFFSET     1000      // upload sequence record (sequence.cpp)
+#define CONFIG_SEQ_OFFSET_V1  448       // where layouts v2..v5 kept it
+#define CONFIG_BIAS_OFFSET    1012      // mic DC bias record (bias.cpp)
+#ifndef CONFIG_COMMIT_DELAY_MS
+#define CONFIG_COMMIT_DELAY_MS 5000UL   // quiet time before a batched commit
+#endif
+
+// ================== Defaults ==================
+// Used on first boot and whenever the stored block fails validation.
+#ifndef CFG_DEFAULT_WIFI_SSID
+#define CFG_DEFAULT_WIFI_SSID   "Mark P"
+#endif
+#ifndef CFG_DEFAULT_WIFI_PASS
+#define CFG_DEFAULT_WIFI_PASS   "testingwifi"
+#endif
+#ifndef CFG_DEFAULT_SERVER_BASE
+#define CFG_DEFAULT_SERVER_BASE "https://markpulido.io/api"   // Hostinger /api folder
+#endif
+#define CFG_ALT_BASES           2     // failover endpoints after server_base (endpoints.h)
+#ifndef CFG_DEFAULT_POST_PATH
+#define CFG_DEFAULT_POST_PATH   "/ingest.php"                 // calls sp_insert_sensor_data
+#endif
+#ifndef CFG_DEFAULT_SAMPLES
+#define CFG_DEFAULT_SAMPLES     200       // sound samples per window
+#endif
+#ifndef CFG_DEFAULT_TARGET_FS
+#define CFG_DEFAULT_TARGET_FS   5000      // Hz (200 us between samples)
+#endif
+#ifndef CFG_DEFAULT_REF_RMS
+#define CFG_DEFAULT_REF_RMS     0.0045f   // Vrms at the calibration point
+#endif
+#ifndef CFG_DEFAULT_CAL_DB_AT_REF
+#define CFG_DEFAULT_CAL_DB_AT_REF 26.0f   // phone SPL reading at REF_RMS
+#endif
+#ifndef CFG_DEFAULT_TRANSPORT
+#define CFG_DEFAULT_TRANSPORT   TRANSPORT_HTTPS
+#endif
+// Apply this offset (hours) to NTP's UTC result.
+//   Example: PST (standard, not daylight) = UTC-8
+#ifndef NTP_ADD_HOURS
+#define NTP_ADD_HOURS -8
+#endif
+
+// ================== Upload transport ==================
+enum Transport : uint8_t {
+  TRANSPORT_HTTPS     = 0,   // BearSSL TLS POST (postToServer)
+  TRANSPORT_HMAC_HTTP = 1,   // plain HTTP + HMAC-SHA256 header (postToServerSigned)
+  TRANSPORT_COAP      = 2,   // batched CoAP POST over UDP (coap.h)
+  TRANSPORT_MQTT      = 3,   // batched QoS1 publishes, persistent session (mqtt.h)
+  TRANSPORT_HTTPS_BATCH = 4, // batched POST over HTTPS (or http://), optional compression
+};
+#define TRANSPORT_LAST TRANSPORT_HTTPS_BATCH
+
+// Batch body compression (compress.h) for TRANSPORT_HTTPS_BATCH.
+enum CompressMode : uint8_t {
+  COMPRESS_OFF  = 0,   // always identity
+  COMPRESS_AUTO = 1,   // once the server advertises the coding (Accept-Encoding)
+  COMPRESS_ON   = 2,   // try before any advertisement; a 415 turns it off
+};
+
+// Batch payload encoding (batchcodec.h) for the batched transports.
+enum BatchFormat : uint8_t {
+  BATCH_FORMAT_TEXT   = 0,   // one formBody() line per reading
+  BATCH_FORMAT_BINARY = 1,   // varint / delta records, BATCH_CONTENT_TYPE
+};
+
+#ifndef CFG_DEFAULT_BATCH_SIZE
+#define CFG_DEFAULT_BATCH_SIZE  8         // readings per batched upload
+#endif
+#ifndef CFG_DEFAULT_MQTT_TOPIC
+#define CFG_DEFAULT_MQTT_TOPIC  "ee570/nodes"   // publishes go to <topic>/<nodeId>
+#endif
+#ifndef CFG_DEFAULT_LIVE_RATE_HZ
+#define CFG_DEFAULT_LIVE_RATE_HZ 0        // live level stream off
+#endif
+#ifndef CFG_DEFAULT_SUMMARY_S
+#define CFG_DEFAULT_SUMMARY_S   60        // live mode: Leq summary via the durable path
+#endif
+#ifndef CFG_DEFAULT_COMPRESS
+#define CFG_DEFAULT_COMPRESS    COMPRESS_AUTO
+#endif
+#ifndef CFG_DEFAULT_BATCH_FORMAT
+#define CFG_DEFAULT_BATCH_FORMAT BATCH_FORMAT_TEXT   // hosted ingest.php takes form bodies only
+#endif
+#ifndef CFG_DEFAULT_LINK_ADAPT
+#define CFG_DEFAULT_LINK_ADAPT  1         // scale batch_size / flush_ms with link cost (linkquality.h)
+#endif
+#ifndef CFG_DEFAULT_METRICS_PORT
+#define CFG_DEFAULT_METRICS_PORT 9100     // GET /metrics (metrics.h); 0 = no server
+#endif
+#ifndef CFG_DEFAULT_OVERSAMPLE
+#define CFG_DEFAULT_OVERSAMPLE  1         // ADC oversampling ratio (oversample.h); 1 = off
+#endif
+#ifndef CFG_DEFAULT_TW_RATE_HZ
+#define CFG_DEFAULT_TW_RATE_HZ  0         // F/S/I level outputs per second (timeweight.h); 0 = off
+#endif
+#ifndef CFG_DEFAULT_CLS_PERIOD_S
+#define CFG_DEFAULT_CLS_PERIOD_S 0        // seconds between classified windows (classify.h); 0 = off
+#endif
+#ifndef CFG_DEFAULT_QUALITY_DROP
+#define CFG_DEFAULT_QUALITY_DROP 0x06     // QUALITY_STUCK | QUALITY_BIAS (quality.h): sensor faults
+#endif
+#ifndef CFG_DEFAULT_RANGE_MIN_CM
+#define CFG_DEFAULT_RANGE_MIN_CM 2        // echoes closer than this are ringing (ranging.h)
+#endif
+#ifndef CFG_DEFAULT_RANGE_MAX_CM
+#define CFG_DEFAULT_RANGE_MAX_CM 450      // ~30 ms echo timeout, the old fixed value
+#endif
+#ifndef CFG_DEFAULT_RANGE_PINGS
+#define CFG_DEFAULT_RANGE_PINGS  1        // pings per reading (median of the valid ones)
+#endif
+#ifndef CFG_DEFAULT_RANGE_IDLE_MS
+#define CFG_DEFAULT_RANGE_IDLE_MS 0       // adaptive ranging idle interval (ranging.h); 0 = off
+#endif
+#ifndef CFG_DEFAULT_RANGE_MOTION_CM
+#define CFG_DEFAULT_RANGE_MOTION_CM 10    // cm/s or cm std deviation that counts as motion
+#endif
+#ifndef CFG_DEFAULT_FLUSH_MS
+#define CFG_DEFAULT_FLUSH_MS    30000UL   // upload a partial batch after this long
+#endif
+
+#define NODE_KEY_LEN 32      // HMAC-SHA256 key bytes
+
+// ================== TLS verification ==================
+enum TlsMode : uint8_t {
+  TLS_INSECURE = 0,   // setInsecure(): no server authentication
+  TLS_PINNED   = 1,   // known public key or certificate fingerprint (tls.cpp)
+  TLS_CA       = 2,   // full X.509 chain against TLS_CA_PEM (tls_pins.h)
+};
+
+#define TLS_FP_PINS 3        // runtime certificate fingerprints (SHA-1, 20 bytes)
+#define TLS_FP_LEN  20
+#ifndef CFG_DEFAULT_TLS_MODE
+#define CFG_DEFAULT_TLS_MODE TLS_INSECURE
+#endif
+
+// ================== Stored image ==================
+// Header fields come first so a future layout can still be recognised.
+// crc32 covers every byte after the header, up to 'length'.
+struct __attribute__((packed)) NodeConfig {
+  // --- header ---
+  uint16_t magic;
+  uint8_t  version;
+  uint8_t  reserved;
+  uint16_t length;            // sizeof(NodeConfig) when written
+  uint32_t crc32;
+
+  // --- network ---
+  char     wifi_ssid[33];
+  char     wifi_pass[65];
+  char     server_base[96];
+  char     post_path[32];
+
+  // --- GPIO ---
+  uint8_t  pin_trig;
+  uint8_t  pin_echo;
+  uint8_t  pin_btn_ultra;
+  uint8_t  pin_btn_sound;
+  uint8_t  pin_sound;
+
+  // --- sound sampling / calibration ---
+  uint16_t samples;
+  uint32_t target_fs;
+  float    ref_rms;
+  float    cal_db_at_ref;
+  float    thresholds_db[3];  // Quiet / Normal / Loud upper bounds
+
+  // --- time ---
+  int8_t   ntp_add_hours;
+
+  // --- upload transport ---
+  uint8_t  transport;               // Transport
+  uint8_t  node_key[NODE_KEY_LEN];  // per-node HMAC key (TRANSPORT_HMAC_HTTP)
+
+  // --- TLS ---
+  uint8_t  tls_mode;                        // TlsMode
+  uint8_t  tls_fp[TLS_FP_PINS][TLS_FP_LEN]; // all-zero entry = unused
+
+  // --- batching (batched transports) ---
+  uint8_t  batch_size;      // 1..READING_QUEUE_CAP (baseline when link_adapt is on)
+  uint32_t flush_ms;        // max age of the oldest queued reading (same)
+
+  // --- MQTT ---
+  char     mqtt_topic[40];  // topic prefix; node ID is appended
+
+  // --- live level stream (livestream.h) ---
+  char     live_url[64];    // ws://host:port/path or wss://...
+  uint8_t  live_rate_hz;    // level updates per second, 0 = off
+  uint16_t summary_s;       // Leq summary period for the durable upload path
+
+  // --- batch compression ---
+  uint8_t  compress;        // CompressMode
+
+  // --- batch encoding ---
+  uint8_t  batch_format;    // BatchFormat
+
+  // --- failover endpoints (endpoints.h) ---
+  char     server_alt[CFG_ALT_BASES][96];  // same scheme as server_base; empty = unused
+
+  // --- adaptive batching (linkquality.h) ---
+  uint8_t  link_adapt;      // 0 = use batch_size / flush_ms as configured
+
+  // --- metrics endpoint (metrics.h) ---
+  uint16_t metrics_port;    // TCP port for GET /metrics, 0 = off
+
+  // --- ADC oversampling (oversample.h) ---
+  uint8_t  oversample;      // 1, 2, 4, 8 or 16 ADC samples per sound sample
+
+  // --- time weighting (timeweight.h) ---
+  uint8_t  tw_rate_hz;      // level outputs per second, 0 = stage off
+
+  // --- acoustic classifier (classify.h) ---
+  uint16_t cls_period_s;    // seconds between classified windows, 0 = off
+
+  // --- signal quality (quality.h) ---
+  uint8_t  quality_drop;    // QUALITY_* flags that suppress a reading, 0 = upload all
+
+  // --- ranging profile (ranging.h) ---
+  uint16_t range_min_cm;    // near-field gate
+  uint16_t range_max_cm;    // sets the echo timeout and ping spacing
+  uint8_t  range_pings;     // pings per reading, 1..9
+  uint16_t range_idle_ms;   // adaptive ranging: interval when static, 0 = off
+  uint8_t  range_motion_cm; // adaptive ranging: motion threshold
+};
+
+static_assert(CONFIG_EEPROM_OFFSET + sizeof(NodeConfig) <= CONFIG_SEQ_OFFSET,
+              "NodeConfig does not fit the reserved EEPROM area");
+
+// Load the block from flash (or defaults). Call once in setup().
+// Returns true if a valid stored block was found.
+bool configBegin();
+
+// Live configuration (RAM copy).
+const NodeConfig& config();
+
+// Mutable access for bulk edits; call configMarkDirty() afterwards.
+NodeConfig& configEdit();
+void configMarkDirty();
+
+// Set one field by name from text, e.g. ("server_base", "https://x/api").
+// Intended for the Serial console; returns false on unknown key or bad value.
+bool configSetField(const char* key, const char* value);
+
+// Restore compile-time defaults in RAM (marks dirty).
+void configReset();
+
+// Commit pending changes once they have been quiet long enough.
+// Cheap when nothing is pending; call from loop().
+void configService();
+
+// Commit pending changes now (e.g., before deep sleep).
+bool configFlush();
+
+// Print the live configuration to Serial (password masked).
+void configPrint();
+
+// CRC-32 (IEEE) used for the config image; shared with other flash records.
+uint32_t configCrc32(const uint8_t* p, size_t n);
@@ -0,0 +1,200 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Upload Endpoint Failover
+* File Name            : endpoints.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Per-endpoint health (EWMA latency, consecutive failures, cool-down),
+*   selection and probing (see endpoints.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WiFi.h>
+*   - "endpoints.h", "config.h", "coap.h", "mqtt.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "config.h"
+#include "coap.h"
+#include "mqtt.h"
+#include "endpoints.h"
+
+#define ENDPOINT_NONE 0xFF
+
+struct EndpointHealth {
+  uint32_t ewmaMs;        // smoothed upload latency, 0 = no sample yet
+  uint32_t lastSampleMs;  // millis() of the last latency sample
+  uint32_t downUntil;     // millis() at which a down endpoint may be probed
+  uint8_t  fails;         // consecutive failures (drives the cool-down)
+  bool     down;
+  uint32_t oks, failures; // totals for endpointPrint()
+};
+
+static EndpointHealth g_ep[ENDPOINT_MAX];
+static uint8_t  g_current = ENDPOINT_NONE;
+static uint32_t g_lastProbeMs = 0;
+
+const char* endpointBase(uint8_t i) {
+  if (i == 0) return config().server_base;
+  if (i < ENDPOINT_MAX) return config().server_alt[i - 1];
+  return "";
+}
+
+static bool configured(uint8_t i) { return endpointBase(i)[0] != '\0'; }
+
+// Preferred endpoint whose latency is out of date: score it optimistically.
+static bool stale(uint8_t i, uint32_t now) {
+  return g_current != ENDPOINT_NONE && i < g_current &&
+         (g_ep[i].ewmaMs == 0 || now - g_ep[i].lastSampleMs > ENDPOINT_STALE_MS);
+}
+
+static uint32_t score(uint8_t i, uint32_t now) {
+  return i * ENDPOINT_RANK_MS + (stale(i, now) ? 0 : g_ep[i].ewmaMs);
+}
+
+uint8_t endpointPick() {
+  uint32_t now = millis();
+  uint8_t best = ENDPOINT_NONE, fallback = 0;
+  uint32_t bestScore = UINT32_MAX, soonest = UINT32_MAX;
+  for (uint8_t i = 0; i < ENDPOINT_MAX; i++) {
+    if (!configured(i)) continue;
+    const EndpointHealth& e = g_ep[i];
+    if (e.down) {
+      uint32_t wait = (long)(e.downUntil - now) > 0 ? e.downUntil - now : 0;
+      if (wait < soonest) { soonest = wait; fallback = i; }
+      continue;
+    }
+    uint32_t s = score(i, now);
+    if (s < bestScore) { bestScore = s; best = i; }
+  }
+
+  // Everything down: use the one closest to its next probe rather than none.
+  if (best == ENDPOINT_NONE) best = fallback;
+
+  // Only leave a working endpoint for a clearly better one.
+  if (g_current != ENDPOINT_NONE && best != g_current && configured(g_current) && !g_ep[g_current].down &&
+      !g_ep[best].down && bestScore + ENDPOINT_SWITCH_MS > score(g_current, now))
+    best = g_current;
+
+  if (best != g_current) {
+    if (g_current != ENDPOINT_NONE)
+      Serial.printf("[ep] switching to #%u %s (%s)\n", best, endpointBase(best),
+                    g_ep[g_current].down ? "current endpoint down" : "lower latency");
+    g_current = best;
+  }
+  return best;
+}
+
+static void markDown(uint8_t i, const char* why) {
+  EndpointHealth& e = g_ep[i];
+  uint8_t shift = min<uint8_t>(e.fails ? e.fails - 1 : 0, 5);
+  uint32_t coolMs = min<uint32_t>(ENDPOINT_DOWN_MIN_MS << shift, ENDPOINT_DOWN_MAX_MS);
+  e.down = true;
+  e.downUntil = millis() + coolMs;
+  Serial.printf("[ep] #%u %s down (%s, %u in a row), next probe in %lu s\n",
+                i, endpointBase(i), why, e.fails, (unsigned long)(coolMs / 1000));
+}
+
+static void markUp(uint8_t i, const char* how) {
+  EndpointHealth& e = g_ep[i];
+  e.fails = 0;
+  if (!e.down) return;
+  e.down = false;
+  Serial.printf("[ep] #%u %s up (%s)\n", i, endpointBase(i), how);
+}
+
+void endpointReport(uint8_t i, EndpointResult result, uint32_t latencyMs) {
+  if (i >= ENDPOINT_MAX) return;
+  EndpointHealth& e = g_ep[i];
+  uint32_t now = millis();
+
+  // A slow server error is still a latency sample; an unreachable host is not.
+  if (result != ENDPOINT_UNREACHABLE && latencyMs) {
+    bool fresh = e.ewmaMs == 0 || now - e.lastSampleMs > ENDPOINT_STALE_MS;
+    if (fresh) e.ewmaMs = latencyMs;
+    else e.ewmaMs = (uint32_t)((int32_t)e.ewmaMs + (((int32_t)latencyMs - (int32_t)e.ewmaMs) >> ENDPOINT_EWMA_SHIFT));
+    if (e.ewmaMs == 0) e.ewmaMs = 1;
+    e.lastSampleMs = now;
+  }
+
+  if (result == ENDPOINT_OK) {
+    e.oks++;
+    markUp(i, "upload ok");
+    return;
+  }
+  e.failures++;
+  if (e.fails < 255) e.fails++;
+  if (result == ENDPOINT_UNREACHABLE) markDown(i, "unreachable");
+  else if (e.fails >= ENDPOINT_FAIL_LIMIT) markDown(i, "failing");
+}
+
+EndpointResult endpointHttpResult(bool attempted, int httpCode) {
+  if (!attempted || httpCode <= 0) return ENDPOINT_UNREACHABLE;
+  if (httpCode >= 500) return ENDPOINT_FAILED;
+  return ENDPOINT_OK;
+}
+
+bool endpointHostPort(const char* url, String& host, uint16_t& port) {
+  String s = url;
+  port = s.startsWith("https://") ? 443 : s.startsWith("coap://") ? COAP_DEFAULT_PORT :
+         s.startsWith("mqtt://") ? MQTT_DEFAULT_PORT : 80;
+  int p = s.indexOf("//");
+  if (p >= 0) s = s.substring(p + 2);
+  int slash = s.indexOf('/');
+  if (slash >= 0) s = s.substring(0, slash);
+  int colon = s.indexOf(':');
+  if (colon >= 0) {
+    port = (uint16_t)s.substring(colon + 1).toInt();
+    s = s.substring(0, colon);
+  }
+  host = s;
+  return host.length() > 0 && port != 0;
+}
+
+// Liveness only: a TCP connect (UDP transports: CoAP ping). The probe time is
+// not an upload latency, so it does not feed the EWMA.
+static bool probe(uint8_t i) {
+  String host; uint16_t port;
+  if (!endpointHostPort(endpointBase(i), host, port)) return false;
+  if (!strncmp(endpointBase(i), "coap://", 7)) return coapPing(host.c_str(), port, ENDPOINT_PROBE_TIMEOUT_MS) >= 0;
+  WiFiClient tcp;
+  tcp.setTimeout(ENDPOINT_PROBE_TIMEOUT_MS);
+  bool ok = tcp.connect(host.c_str(), port);
+  tcp.stop();
+  return ok;
+}
+
+void endpointService() {
+  uint32_t now = millis();
+  if (now - g_lastProbeMs < ENDPOINT_PROBE_GAP_MS || WiFi.status() != WL_CONNECTED) return;
+  for (uint8_t i = 0; i < ENDPOINT_MAX; i++) {
+    EndpointHealth& e = g_ep[i];
+    if (!configured(i) || !e.down || (long)(now - e.downUntil) < 0) continue;
+    g_lastProbeMs = now;
+    if (probe(i)) {
+      markUp(i, "probe ok");
+    } else {
+      if (e.fails < 255) e.fails++;
+      markDown(i, "probe failed");
+    }
+    return;   // one probe per call keeps loop() responsive
+  }
+}
+
+void endpointPrint() {
+  uint32_t now = millis();
+  Serial.println(F("[ep] #  state  ewma ms  fails  ok/failed  url"));
+  for (uint8_t i = 0; i < ENDPOINT_MAX; i++) {
+    if (!configured(i)) continue;
+    const EndpointHealth& e = g_ep[i];
+    const char* state = e.down ? "down" : (i == g_current ? "used" : "up");
+    Serial.printf("     %u  %-5s  %7lu  %5u  %4lu/%-4lu  %s", i, state, (unsigned long)e.ewmaMs, e.fails,
+                  (unsigned long)e.oks, (unsigned long)e.failures, endpointBase(i));
+    if (e.down && (long)(e.downUntil - now) > 0) Serial.printf("  (probe in %lu s)", (unsigned long)((e.downUntil - now) / 1000));
+    Serial.println();
+  }
+}
@@ -0,0 +1,98 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Upload Endpoint Failover
+* File Name            : endpoints.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Choose where uploads go when more than one ingest endpoint is configured
+*   (server_base plus server_alt0/1, e.g. hosted primary, secondary host and a
+*   LAN gateway). Every upload reports its outcome and latency; each endpoint
+*   keeps an EWMA of its latency and a count of consecutive failures:
+*     - an unreachable endpoint (no connection / no response) is taken out of
+*       rotation at once, a failing one (5xx, missing ack) after
+*       ENDPOINT_FAIL_LIMIT consecutive failures;
+*     - a down endpoint stays out for an exponential cool-down
+*       (ENDPOINT_DOWN_MIN_MS .. ENDPOINT_DOWN_MAX_MS), then is probed with a
+*       TCP connect (CoAP: ping) and rejoins once the probe succeeds;
+*     - among the endpoints that are up, the lowest score wins:
+*         EWMA latency + position * ENDPOINT_RANK_MS
+*       so the primary is preferred unless an alternate is clearly faster.
+*   An endpoint ranked above the current one whose latency sample is older
+*   than ENDPOINT_STALE_MS is scored optimistically, so the next upload tries
+*   it again: that is how a slow primary gets traffic back once it recovers.
+*
+* Inputs:
+*   - config().server_base / server_alt[] (empty entries are skipped).
+*   - endpointReport() after every upload attempt.
+*
+* Outputs:
+*   - endpointPick(): index of the endpoint to use now; endpointBase(): its URL.
+*   - "[ep]" log lines on every switch, down and up transition.
+*
+* Example Application:
+*   uint8_t ep = endpointPick();
+*   uint32_t t0 = millis();
+*   bool ok = postToServer(endpointBase(ep), cfg.post_path, ..., code, resp);
+*   endpointReport(ep, endpointHttpResult(ok, code), millis() - t0);
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WiFi.h>
+*   - "config.h", "coap.h" (coapPing), "mqtt.h" (default port)
+*
+* Usage Notes:
+*   - Health lives in RAM only; after a reboot every endpoint starts up with no
+*     latency history, so the primary is tried first.
+*   - All endpoints must speak the configured transport, and with
+*     tls_mode pinned every https:// alternate needs its own pin.
+*   - Call endpointService() from loop(); it probes at most one endpoint per
+*     ENDPOINT_PROBE_GAP_MS and blocks for up to ENDPOINT_PROBE_TIMEOUT_MS.
+*   - "ep" on the Serial console prints the health table.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+#define ENDPOINT_MAX              (1 + CFG_ALT_BASES)
+#define ENDPOINT_EWMA_SHIFT       2          // new sample weight 1/4
+#define ENDPOINT_RANK_MS          500UL      // preference per position in the list
+#define ENDPOINT_SWITCH_MS        100UL      // hysteresis between endpoints that are up
+#define ENDPOINT_FAIL_LIMIT       2          // consecutive soft failures before down
+#define ENDPOINT_DOWN_MIN_MS      10000UL
+#define ENDPOINT_DOWN_MAX_MS      300000UL
+#define ENDPOINT_STALE_MS         300000UL   // re-try a preferred endpoint after this long
+#define ENDPOINT_PROBE_GAP_MS     1000UL
+#define ENDPOINT_PROBE_TIMEOUT_MS 2000UL
+
+enum EndpointResult : uint8_t {
+  ENDPOINT_OK          = 0,   // answered (2xx, or a 4xx about the request itself)
+  ENDPOINT_FAILED      = 1,   // answered with a server error / did not acknowledge
+  ENDPOINT_UNREACHABLE = 2,   // no connection or no response at all
+};
+
+// Index (0 = server_base) of the endpoint uploads should use now.
+uint8_t endpointPick();
+
+// URL of endpoint i ("" if not configured).
+const char* endpointBase(uint8_t i);
+
+// Record the outcome of one upload attempt to endpoint i.
+// latencyMs: request to response; 0 if there is no meaningful sample.
+void endpointReport(uint8_t i, EndpointResult result, uint32_t latencyMs);
+
+// Classify an HTTP attempt: (attempted, status) as returned by postToServer().
+EndpointResult endpointHttpResult(bool attempted, int httpCode);
+
+// Split "scheme://host[:port]/..." into host and port; the default port
+// follows the scheme (http 80, https 443, coap 5683, mqtt 1883).
+bool endpointHostPort(const char* url, String& host, uint16_t& port);
+
+// Probe down endpoints whose cool-down has expired. Call from loop().
+void endpointService();
+
+// Health table on Serial.
+void endpointPrint();
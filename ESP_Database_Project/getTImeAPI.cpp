@@ -13,7 +13,7 @@
  *
  * Inputs:
  *   - WiFi connection (must be configured elsewhere in the sketch)
- *   - Compile-time macro NTP_ADD_HOURS (int, hours to add to UTC; e.g., -8)
+ *   - config().ntp_add_hours (hours to add to UTC; default NTP_ADD_HOURS, e.g., -8)
  *   - Compile-time macro APPEND_Z (0/1; when 1, appends 'Z' to the string)
  *   - getTimeIsoUtc(const String& tzRegion, String& outIso):
  *       tzRegion: Ignored by this implementation (reserved for future use)
@@ -23,6 +23,8 @@
  *   - Returns 'bool' from getTimeIsoUtc: true on success, false on failure
  *   - Populates 'outIso' with "YYYY-MM-DDTHH:MM:SS" (and optionally 'Z')
  *   - Serial debug messages describing Wi-Fi/NTP status
+ *   - isoFromEpoch(): same formatting for an earlier capture time
+ *   - captureTime(): system clock (s + ms) once SNTP is synchronised
  *
  * Example Application:
  *   String iso; 
@@ -39,7 +41,7 @@
  *   - Network access to "pool.ntp.org", "time.nist.gov", "time.google.com"
  *
  * Usage Notes:
- *   - Uses a fixed offset (NTP_ADD_HOURS); no automatic DST handling.
+ *   - Uses a fixed offset (config().ntp_add_hours); no automatic DST handling.
  *   - Blocks while waiting for valid SNTP time (up to ~12 seconds).
  *   - APPEND_Z should stay 0 when using offsets (since 'Z' denotes UTC).
  *   - ensureWifi() retries for ~8 seconds; adjust if needed for your network.
@@ -49,13 +51,12 @@
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
 #include <time.h>
+#include <sys/time.h>
+#include "config.h"
 
 // ================== CONFIG ==================
-// Apply this offset (hours) to NTP's UTC result.
-//   Example: PST (standard, not daylight) = UTC-8
-#ifndef NTP_ADD_HOURS
-#define NTP_ADD_HOURS -8   // negative values subtract hours from UTC
-#endif
+// The hour offset applied to NTP's UTC result is config().ntp_add_hours;
+// its compile-time default (NTP_ADD_HOURS) lives in config.h.
 
 // Append 'Z' at the end of the formatted ISO string?
 //   'Z' indicates the string is *in UTC*. Keep this 0 when using offsets.
@@ -93,6 +94,56 @@ static bool ensureWifi(uint32_t ms = 8000) {
   return false;
 }
 
+/**
+ * @brief Format an epoch (UTC seconds) the same way getTimeIsoUtc() does.
+ *
+ * Used for readings captured earlier and uploaded later in a batch, so they
+ * carry their capture time rather than the upload time.
+ *
+ * @param epoch   UTC seconds since 1970.
+ * @param outIso  Receives "YYYY-MM-DDTHH:MM:SS" (optionally with 'Z').
+ */
+void isoFromEpoch(time_t epoch, String& outIso) {
+  // Apply the user-selected fixed offset (in hours).
+  // Casting to long avoids overflow on platforms where 'int' is 16-bit.
+  long offsetSec = (long)config().ntp_add_hours * 3600L;
+  time_t shifted = epoch + offsetSec;
+
+  // Convert to broken-down time in UTC space. We use gmtime()
+  // because we've already incorporated the offset into 'shifted'.
+  struct tm* t = gmtime(&shifted);
+
+  // Format as ISO-8601 "YYYY-MM-DDTHH:MM:SS"
+  char buf[32];
+  strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", t);
+
+  // Store in the Arduino String
+  outIso = String(buf);
+
+  // Optional: append 'Z' (only appropriate when representing pure UTC)
+  #if APPEND_Z
+    outIso += 'Z';
+  #endif
+}
+
+/**
+ * @brief Read the system clock with millisecond resolution.
+ *
+ * Valid once SNTP has synchronised (any successful getTimeIsoUtc() call).
+ *
+ * @param sec  Receives UTC seconds since 1970.
+ * @param ms   Receives milliseconds within that second.
+ * @return false if the clock has not been set yet.
+ */
+bool captureTime(uint32_t& sec, uint16_t& ms) {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (tv.tv_sec <= 1609459200L) return false;   // before 2021-01-01: not synced
+  sec = (uint32_t)tv.tv_sec;
+  ms  = (uint16_t)(tv.tv_usec / 1000);
+  return true;
+}
+
 /**
  * @brief Get an ISO-8601 time string based on NTP (UTC) with a fixed hour offset.
  *
@@ -100,7 +151,7 @@ static bool ensureWifi(uint32_t ms = 8000) {
  *   1) Verifies Wi-Fi connectivity.
  *   2) Boots SNTP using common time servers (UTC base).
  *   3) Waits until the system time is valid.
- *   4) Applies the compile-time offset NTP_ADD_HOURS.
+ *   4) Applies the configured offset (config().ntp_add_hours).
  *   5) Formats the result as "YYYY-MM-DDTHH:MM:SS" (optionally with 'Z').
  *
  * @param tzRegion  Reserved for future use (ignored).
@@ -139,30 +190,12 @@ bool getTimeIsoUtc(const String& /*tzRegion*/, String& outIso) {
     return false;
   }
 
-  // 4) Apply the user-selected fixed offset (in hours).
-  //    Casting to long avoids overflow on platforms where 'int' is 16-bit.
-  long offsetSec = (long)NTP_ADD_HOURS * 3600L;
-  time_t shifted = now + offsetSec;
-
-  // 5) Convert to broken-down time in UTC space. We use gmtime()
-  //    because we've already incorporated the offset into 'shifted'.
-  struct tm* t = gmtime(&shifted);
-
-  // Format as ISO-8601 "YYYY-MM-DDTHH:MM:SS"
-  char buf[32];
-  strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", t);
-
-  // Store in the Arduino String
-  outIso = String(buf);
-
-  // Optional: append 'Z' (only appropriate when representing pure UTC)
-  #if APPEND_Z
-    outIso += 'Z';
-  #endif
+  // 4) + 5) Apply the configured offset and format.
+  isoFromEpoch(now, outIso);
 
   // Debug print so you can see the final representation and offset used
   Serial.print("[ntp] ISO (");
-  Serial.print(NTP_ADD_HOURS);
+  Serial.print(config().ntp_add_hours);
   Serial.print("h): ");
   Serial.println(outIso);
 
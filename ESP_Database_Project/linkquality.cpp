@@ -0,0 +1,146 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Link Quality and Adaptive Batching
+* File Name            : linkquality.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   RSSI / upload-cost monitor and the batch size / flush interval controller
+*   (see linkquality.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WiFi.h>
+*   - "linkquality.h", "config.h", "readings.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "config.h"
+#include "readings.h"
+#include "linkquality.h"
+
+// Exponentially weighted moments of (x = bytes, y = latency ms) for the
+// overhead + bytes * msPerByte fit, plus per-reading size and failure rate.
+static float    g_mx, g_my, g_mxx, g_mxy;
+static float    g_bytesPerReading;
+static float    g_failRate;
+static uint16_t g_samples;
+
+static float    g_rssi;               // dBm
+static uint32_t g_lastRssiMs;
+static bool     g_rssiSampled = false;
+
+static uint8_t  g_batch;              // current decision, 0 = not made yet
+static uint32_t g_flushMs;
+static uint8_t  g_cfgBatch, g_cfgAdapt;   // configuration the decision was made from
+static uint32_t g_cfgFlushMs;
+
+static inline void ewma(float& acc, float x) { acc += LINK_EWMA_ALPHA * (x - acc); }
+
+// Fitted per-request overhead and per-byte cost; false until enough spread.
+static bool fit(float& overheadMs, float& msPerByte) {
+  if (g_samples < LINK_MIN_SAMPLES) return false;
+  float var = g_mxx - g_mx * g_mx;
+  if (var > 16.0f) {                  // sizes differ by a few bytes at least
+    msPerByte = max(0.0f, (g_mxy - g_mx * g_my) / var);
+    overheadMs = max(0.0f, g_my - msPerByte * g_mx);
+  } else {
+    msPerByte = 0.0f;                 // all batches the same size: treat it all as overhead
+    overheadMs = g_my;
+  }
+  return true;
+}
+
+static float rssiFactor() {
+  if (!g_rssiSampled || g_rssi >= LINK_RSSI_GOOD) return 1.0f;
+  if (g_rssi <= LINK_RSSI_POOR) return 2.0f;
+  return 1.0f + (LINK_RSSI_GOOD - g_rssi) / (float)(LINK_RSSI_GOOD - LINK_RSSI_POOR);
+}
+
+static void decide() {
+  const NodeConfig& cfg = config();
+  uint8_t baseBatch = min<uint8_t>(cfg.batch_size, READING_QUEUE_CAP);
+  float scale = 1.0f;
+  if (cfg.link_adapt) {
+    float overheadMs, msPerByte, cost = 1.0f;
+    if (fit(overheadMs, msPerByte)) {
+      // Break-even batch: fewer readings and the overhead dominates, more
+      // only add latency.
+      float perReadingMs = g_bytesPerReading * msPerByte;
+      cost = perReadingMs > 0.0f ? overheadMs / perReadingMs / baseBatch : overheadMs / LINK_REF_OVERHEAD_MS;
+    }
+    scale = cost * rssiFactor() * (1.0f + 2.0f * g_failRate);
+    scale = constrain(scale, 1.0f / LINK_SCALE_MAX, LINK_SCALE_MAX);
+  }
+  uint8_t batch = (uint8_t)constrain((int)lroundf(baseBatch * scale), 1, READING_QUEUE_CAP);
+  uint32_t flushMs = (uint32_t)min<double>((double)cfg.flush_ms * scale, UINT32_MAX);
+
+  // Small moves are noise; only re-decide on a change of a quarter or more
+  // (or when the configured baseline itself was edited).
+  bool edited = cfg.batch_size != g_cfgBatch || cfg.flush_ms != g_cfgFlushMs || cfg.link_adapt != g_cfgAdapt;
+  bool changed = g_batch == 0 || edited || abs((int)batch - (int)g_batch) * 4 >= g_batch ||
+                 (uint64_t)flushMs * 4 >= (uint64_t)g_flushMs * 5 ||
+                 (uint64_t)flushMs * 5 <= (uint64_t)g_flushMs * 4;
+  if (!changed) return;
+  if (g_batch) Serial.printf("[link] rssi %d dBm, fail %.0f%% -> batch %u, flush %lu ms (x%.2f)\n",
+                             (int)g_rssi, g_failRate * 100.0f, batch, (unsigned long)flushMs, scale);
+  g_batch = batch;
+  g_flushMs = flushMs;
+  g_cfgBatch = cfg.batch_size;
+  g_cfgFlushMs = cfg.flush_ms;
+  g_cfgAdapt = cfg.link_adapt;
+}
+
+void linkService() {
+  uint32_t now = millis();
+  if (g_batch && now - g_lastRssiMs < LINK_RSSI_PERIOD_MS) return;
+  g_lastRssiMs = now;
+  if (WiFi.status() == WL_CONNECTED) {
+    float rssi = (float)WiFi.RSSI();
+    if (!g_rssiSampled) { g_rssi = rssi; g_rssiSampled = true; }
+    else ewma(g_rssi, rssi);
+  }
+  decide();
+}
+
+void linkReportUpload(size_t bytes, uint8_t readings, uint32_t latencyMs, bool ok) {
+  ewma(g_failRate, ok ? 0.0f : 1.0f);
+  if (ok && readings) {
+    float x = (float)bytes, y = (float)latencyMs;
+    if (g_samples == 0) {
+      g_mx = x; g_my = y; g_mxx = x * x; g_mxy = x * y;
+      g_bytesPerReading = x / readings;
+    } else {
+      ewma(g_mx, x); ewma(g_my, y); ewma(g_mxx, x * x); ewma(g_mxy, x * y);
+      ewma(g_bytesPerReading, x / readings);
+    }
+    if (g_samples < UINT16_MAX) g_samples++;
+  }
+  decide();
+}
+
+uint8_t linkBatchSize() {
+  if (!g_batch) decide();
+  return g_batch;
+}
+
+uint32_t linkFlushMs() {
+  if (!g_batch) decide();
+  return g_flushMs;
+}
+
+int8_t linkRssi() { return g_rssiSampled ? (int8_t)lroundf(g_rssi) : 0; }
+
+void linkPrint() {
+  float overheadMs = 0.0f, msPerByte = 0.0f;
+  bool fitted = fit(overheadMs, msPerByte);
+  Serial.printf("[link] rssi %d dBm, %u uploads, fail %.0f%%, %.0f B/reading\n",
+                linkRssi(), g_samples, g_failRate * 100.0f, g_bytesPerReading);
+  if (fitted) Serial.printf("[link] request overhead %.0f ms, %.3f ms/B\n", overheadMs, msPerByte);
+  Serial.printf("[link] batch %u (cfg %u), flush %lu ms (cfg %lu)%s\n", linkBatchSize(), config().batch_size,
+                (unsigned long)linkFlushMs(), (unsigned long)config().flush_ms,
+                config().link_adapt ? "" : "  [link_adapt off]");
+}
@@ -0,0 +1,77 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Link Quality and Adaptive Batching
+* File Name            : linkquality.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Track how expensive uploads currently are and size batches to match.
+*   Inputs to the monitor:
+*     - RSSI, sampled every LINK_RSSI_PERIOD_MS (EWMA, dBm);
+*     - every batched upload: payload bytes, readings, request latency, outcome.
+*   From the uploads it fits latency = overhead + bytes * msPerByte with
+*   exponentially weighted least squares, so the fixed cost of a request
+*   (connect, TLS handshake, ack) is separated from the per-byte cost.
+*   With the smoothed bytes per reading it sizes the batch where the fixed
+*   cost equals the time the readings themselves take on the wire,
+*       overhead / (bytesPerReading * msPerByte) readings,
+*   and scales the configured batch_size / flush_ms by that over batch_size,
+*   times the rssi factor and (1 + 2 * failure rate), clamped to
+*   1/LINK_SCALE_MAX .. LINK_SCALE_MAX. If the fit finds no per-byte cost
+*   (every batch the same size) overhead / LINK_REF_OVERHEAD_MS stands in:
+*     - expensive requests (TLS, weak signal, retries) -> bigger, rarer batches,
+*       so the fixed cost is paid once per many readings;
+*     - cheap requests on a strong link -> small batches, low latency.
+*
+* Inputs:
+*   - linkReportUpload() from the batched transports; WiFi.RSSI().
+*
+* Outputs:
+*   - linkBatchSize(), linkFlushMs(): what the transports should use now.
+*   - "[link]" log line whenever the decision changes; linkPrint() on demand.
+*
+* Example Application:
+*   linkService();                                   // in loop()
+*   if (readingCount() >= linkBatchSize() || ageMs >= linkFlushMs()) upload();
+*   linkReportUpload(bytes, readings, millis() - t0, ok);
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WiFi.h>
+*   - "config.h" (batch_size, flush_ms, link_adapt), "readings.h" (queue size)
+*
+* Usage Notes:
+*   - With "cfg set link_adapt off" the configured values are used unchanged.
+*   - Until LINK_MIN_SAMPLES uploads are seen, only RSSI moves the decision.
+*   - The batch size never exceeds the reading queue (READING_QUEUE_CAP).
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#define LINK_RSSI_PERIOD_MS   2000UL
+#define LINK_EWMA_ALPHA       0.125f    // weight of a new sample
+#define LINK_MIN_SAMPLES      3
+#define LINK_REF_OVERHEAD_MS  400.0f    // request overhead that keeps the configured batch
+#define LINK_RSSI_GOOD        (-65)     // dBm; no penalty at or above
+#define LINK_RSSI_POOR        (-85)     // dBm; factor 2 at or below
+#define LINK_SCALE_MAX        4.0f
+
+// Sample RSSI and refresh the decision. Call from loop().
+void linkService();
+
+// Record one batched upload (bytes on the wire, readings carried, request
+// latency in ms). Failed uploads count toward the failure rate only.
+void linkReportUpload(size_t bytes, uint8_t readings, uint32_t latencyMs, bool ok);
+
+// Readings per batch and max age of a partial batch to use now.
+uint8_t  linkBatchSize();
+uint32_t linkFlushMs();
+
+// Smoothed RSSI (dBm), 0 before the first sample.
+int8_t linkRssi();
+
+// Monitor state and decision on Serial.
+void linkPrint();
@@ -0,0 +1,399 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Live Level Stream
+* File Name            : livestream.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Minimal WebSocket client (handshake, masked binary frames, ping/close) and
+*   the coalescing level ring behind livestream.h.
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WiFi.h>, <WiFiClientSecureBearSSL.h>
+*   - <bearssl/bearssl.h> (SHA-1 for Sec-WebSocket-Accept)
+*   - "config.h", "tls.h", "livestream.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiClientSecureBearSSL.h>
+#include <bearssl/bearssl.h>
+#include <sys/time.h>
+#include "config.h"
+#include "tls.h"
+#include "livestream.h"
+
+#define WS_OP_BINARY   0x2
+#define WS_OP_CLOSE    0x8
+#define WS_OP_PING     0x9
+#define WS_OP_PONG     0xA
+#define WS_HDR_MAX     8          // 2 + 2 (extended length) + 4 (mask); payloads stay < 64 KB
+#define WS_HANDSHAKE_MS 5000
+#define LIVE_MAX_STRIDE 128       // coarsest resolution before old levels are dropped
+
+static const char* WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static LiveStats g_stats = {};
+
+// ----- socket -----
+static WiFiClient                g_tcp;
+static BearSSL::WiFiClientSecure g_tls;
+static Client*                   g_sock = nullptr;   // &g_tcp or &g_tls while connected
+static uint32_t                  g_retryAt = 0;
+static uint32_t                  g_backoffMs = 0;
+static uint8_t  g_out[WS_HDR_MAX + LIVE_FRAME_HDR + 2 * LIVE_RING_CAP];
+
+// ----- level ring: one contiguous run of windows -----
+static uint16_t g_ring[LIVE_RING_CAP];  // centi-dB
+static uint8_t  g_count = 0;            // complete levels in the ring
+static uint8_t  g_stride = 1;           // windows per level
+static uint32_t g_seq0 = 0;             // window number of g_ring[0]
+static uint32_t g_epoch0 = 0;           // wall clock of g_ring[0]
+static uint16_t g_ms0 = 0;
+static float    g_partPow = 0.0f;       // windows merged into the next level so far
+static uint8_t  g_partN = 0;
+
+// ----- window clock -----
+static uint16_t g_periodMs = 0;
+static uint32_t g_startMs = 0;
+static uint32_t g_nextDueMs = 0;
+static uint32_t g_dueSeq = 0;
+
+// ----- summary -----
+static float    g_sumPow = 0.0f;
+static uint32_t g_sumN = 0;
+static uint32_t g_sumStartMs = 0;
+
+const LiveStats& liveStats() { return g_stats; }
+
+static inline float dbToPow(float db) { return powf(10.0f, db * 0.1f); }
+static inline float powToDb(float p)  { return p > 0.0f ? 10.0f * log10f(p) : 0.0f; }
+
+static uint16_t toCentiDb(float db) {
+  if (!(db > 0.0f)) return 0;
+  if (db > 655.0f) return 65500;
+  return (uint16_t)(db * 100.0f + 0.5f);
+}
+
+bool liveActive() {
+  const NodeConfig& cfg = config();
+  return cfg.live_rate_hz > 0 &&
+         (!strncmp(cfg.live_url, "ws://", 5) || !strncmp(cfg.live_url, "wss://", 6));
+}
+
+bool liveWindowDue() {
+  if (!liveActive()) return false;
+  uint16_t period = 1000 / config().live_rate_hz;
+  uint32_t now = millis();
+  if (period != g_periodMs) {          // first call or rate changed: restart the grid
+    g_periodMs = period;
+    g_startMs = g_nextDueMs = now;
+  }
+  if ((long)(now - g_nextDueMs) < 0) return false;
+  // Window number follows the clock, so windows skipped during a blocking
+  // upload appear as a seq gap instead of shifting later levels.
+  g_dueSeq = (now - g_startMs) / g_periodMs;
+  g_nextDueMs = g_startMs + (g_dueSeq + 1) * g_periodMs;
+  return true;
+}
+
+uint16_t liveWindowSamples() {
+  const NodeConfig& cfg = config();
+  // Sample for at most half the period; the rest is left for the network.
+  uint32_t n = cfg.target_fs * (uint32_t)(1000 / max<uint8_t>(cfg.live_rate_hz, 1)) / 2000UL;
+  return (uint16_t)constrain(n, 1UL, (uint32_t)cfg.samples);
+}
+
+// Advance the ring start by 'levels' complete entries.
+static void advanceStart(uint8_t levels) {
+  uint32_t windows = (uint32_t)levels * g_stride;
+  uint32_t ms = g_ms0 + windows * g_periodMs;
+  g_seq0 += windows;
+  if (g_epoch0) { g_epoch0 += ms / 1000; g_ms0 = ms % 1000; }
+  memmove(g_ring, g_ring + levels, (g_count - levels) * sizeof(g_ring[0]));
+  g_count -= levels;
+}
+
+// Ring full: halve the time resolution instead of losing coverage.
+static void coalesce() {
+  if (g_stride >= LIVE_MAX_STRIDE) {
+    // Already at the coarsest step: give up the oldest half.
+    g_stats.dropped += LIVE_RING_CAP / 2;
+    advanceStart(LIVE_RING_CAP / 2);
+    return;
+  }
+  for (uint8_t i = 0; i < LIVE_RING_CAP / 2; i++) {
+    float p = 0.5f * (dbToPow(g_ring[2 * i] * 0.01f) + dbToPow(g_ring[2 * i + 1] * 0.01f));
+    g_ring[i] = toCentiDb(powToDb(p));
+  }
+  g_count = LIVE_RING_CAP / 2;
+  g_stride *= 2;
+  g_stats.coalesced += LIVE_RING_CAP / 2;
+}
+
+// ----- WebSocket framing -----
+// Send g_out[WS_HDR_MAX .. WS_HDR_MAX+len) as one masked frame, one write.
+static bool wsSend(uint8_t opcode, size_t len) {
+  uint8_t* payload = g_out + WS_HDR_MAX;
+  uint32_t maskWord = ESP.random();
+  uint8_t mask[4] = { (uint8_t)(maskWord >> 24), (uint8_t)(maskWord >> 16),
+                      (uint8_t)(maskWord >> 8), (uint8_t)maskWord };
+  for (size_t i = 0; i < len; i++) payload[i] ^= mask[i & 3];
+
+  uint8_t hdr = (len < 126) ? 6 : 8;
+  uint8_t* h = payload - hdr;
+  h[0] = 0x80 | opcode;                     // FIN, no fragmentation
+  if (len < 126) {
+    h[1] = 0x80 | (uint8_t)len;
+  } else {
+    h[1] = 0x80 | 126;
+    h[2] = (uint8_t)(len >> 8); h[3] = (uint8_t)len;
+  }
+  memcpy(h + hdr - 4, mask, 4);
+  return g_sock->write(h, hdr + len) == hdr + len;
+}
+
+static void liveClose() {
+  if (g_sock) g_sock->stop();
+  g_sock = nullptr;
+  g_backoffMs = g_backoffMs ? min<uint32_t>(g_backoffMs * 2, 60000UL) : 1000UL;
+  g_retryAt = millis() + g_backoffMs;
+}
+
+static void base64(const uint8_t* in, size_t n, char* out) {
+  static const char A[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t o = 0;
+  for (size_t i = 0; i < n; i += 3) {
+    uint32_t v = (uint32_t)in[i] << 16;
+    if (i + 1 < n) v |= (uint32_t)in[i + 1] << 8;
+    if (i + 2 < n) v |= in[i + 2];
+    out[o++] = A[(v >> 18) & 63];
+    out[o++] = A[(v >> 12) & 63];
+    out[o++] = (i + 1 < n) ? A[(v >> 6) & 63] : '=';
+    out[o++] = (i + 2 < n) ? A[v & 63] : '=';
+  }
+  out[o] = '\0';
+}
+
+// Split ws[s]://host[:port]/path.
+static bool parseUrl(const char* url, bool& secure, String& host, uint16_t& port, String& path) {
+  String u = url;
+  secure = u.startsWith("wss://");
+  if (!secure && !u.startsWith("ws://")) return false;
+  u = u.substring(secure ? 6 : 5);
+  int slash = u.indexOf('/');
+  path = slash >= 0 ? u.substring(slash) : String("/");
+  String hp = slash >= 0 ? u.substring(0, slash) : u;
+  int colon = hp.indexOf(':');
+  port = secure ? 443 : 80;
+  if (colon >= 0) { port = (uint16_t)hp.substring(colon + 1).toInt(); hp = hp.substring(0, colon); }
+  host = hp;
+  return host.length() > 0 && port > 0;
+}
+
+static bool handshake(Client& s, const String& host, uint16_t port, const String& path) {
+  uint8_t nonce[16];
+  for (uint8_t i = 0; i < 16; i += 4) {
+    uint32_t r = ESP.random();
+    memcpy(nonce + i, &r, 4);
+  }
+  char key[25];
+  base64(nonce, sizeof(nonce), key);
+
+  String req;
+  req.reserve(200);
+  req += "GET "; req += path; req += " HTTP/1.1\r\nHost: "; req += host;
+  if (port != 80 && port != 443) { req += ':'; req += port; }
+  req += "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: ";
+  req += key;
+  req += "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+  s.write((const uint8_t*)req.c_str(), req.length());
+
+  // Expected Sec-WebSocket-Accept: base64(SHA-1(key + GUID)).
+  br_sha1_context sha;
+  uint8_t digest[20];
+  char accept[29];
+  br_sha1_init(&sha);
+  br_sha1_update(&sha, key, strlen(key));
+  br_sha1_update(&sha, WS_GUID, strlen(WS_GUID));
+  br_sha1_out(&sha, digest);
+  base64(digest, sizeof(digest), accept);
+
+  s.setTimeout(WS_HANDSHAKE_MS);
+  String line = s.readStringUntil('\n');
+  if (!line.startsWith("HTTP/1.1 101")) {
+    Serial.printf("[live] upgrade refused: %s\n", line.c_str());
+    return false;
+  }
+  bool accepted = false;
+  for (;;) {
+    line = s.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0) break;
+    int colon = line.indexOf(':');
+    if (colon < 0) continue;
+    String name = line.substring(0, colon);
+    name.toLowerCase();
+    if (name == "sec-websocket-accept") {
+      String v = line.substring(colon + 1);
+      v.trim();
+      accepted = (v == accept);
+    }
+  }
+  if (!accepted) Serial.println(F("[live] bad Sec-WebSocket-Accept"));
+  return accepted;
+}
+
+static bool liveConnect() {
+  bool secure; String host, path; uint16_t port;
+  if (!parseUrl(config().live_url, secure, host, port, path)) return false;
+
+  Client* s = nullptr;
+  if (secure) {
+    // Same trust policy as the HTTPS uploads (tls.h).
+    for (uint8_t a = 0; a < tlsAttempts(); a++) {
+      if (!tlsApply(g_tls, a)) break;
+      if (g_tls.connect(host.c_str(), port)) { tlsMarkGood(a); s = &g_tls; break; }
+      if (!tlsVerifyFailed(g_tls)) break;     // unreachable, not a pin mismatch
+    }
+  } else if (g_tcp.connect(host.c_str(), port)) {
+    s = &g_tcp;
+  }
+  if (!s) { Serial.printf("[live] connect %s:%u failed\n", host.c_str(), port); return false; }
+
+  if (!handshake(*s, host, port, path)) { s->stop(); return false; }
+  if (secure) g_tls.setNoDelay(true); else g_tcp.setNoDelay(true);
+  s->setTimeout(200);                  // control frames arrive whole
+  g_sock = s;
+  g_backoffMs = 0;
+  g_stats.reconnects++;
+  Serial.printf("[live] streaming to %s\n", config().live_url);
+  return true;
+}
+
+// Answer pings and close; skip anything else the server sends.
+static void liveRead() {
+  while (g_sock && g_sock->available() >= 2) {
+    uint8_t h[2];
+    if (g_sock->readBytes(h, 2) != 2) { liveClose(); return; }
+    uint8_t opcode = h[0] & 0x0F;
+    uint64_t len = h[1] & 0x7F;
+    if (len >= 126) {
+      uint8_t ext[8];
+      uint8_t n = (len == 126) ? 2 : 8;
+      if (g_sock->readBytes(ext, n) != n) { liveClose(); return; }
+      len = 0;
+      for (uint8_t i = 0; i < n; i++) len = (len << 8) | ext[i];
+    }
+    if (h[1] & 0x80) { uint8_t m[4]; g_sock->readBytes(m, 4); }   // servers must not mask
+    if (opcode == WS_OP_PING && len <= 125) {
+      size_t n = g_sock->readBytes(g_out + WS_HDR_MAX, (size_t)len);
+      wsSend(WS_OP_PONG, n);
+    } else if (opcode == WS_OP_CLOSE) {
+      Serial.println(F("[live] server closed the stream"));
+      wsSend(WS_OP_CLOSE, 0);
+      liveClose();
+      return;
+    } else {
+      for (uint64_t i = 0; i < len; i++) if (g_sock->read() < 0) break;
+    }
+  }
+}
+
+// Send as many complete levels as the socket has room for.
+static void liveFlush() {
+  if (!g_sock || g_count == 0) return;
+  int room = g_sock->availableForWrite();
+  int fit = (room - WS_HDR_MAX - LIVE_FRAME_HDR) / 2;
+  if (fit <= 0) return;                       // backpressure: keep (and coalesce) levels
+  uint8_t n = (uint8_t)min<int>(fit, g_count);
+
+  uint8_t* p = g_out + WS_HDR_MAX;
+  p[0] = 'L';
+  p[1] = g_stride;
+  p[2] = 0; p[3] = n;
+  p[4] = g_seq0 >> 24;   p[5] = g_seq0 >> 16;   p[6] = g_seq0 >> 8;   p[7] = g_seq0;
+  p[8] = g_epoch0 >> 24; p[9] = g_epoch0 >> 16; p[10] = g_epoch0 >> 8; p[11] = g_epoch0;
+  p[12] = g_ms0 >> 8;    p[13] = g_ms0;
+  p[14] = g_periodMs >> 8; p[15] = g_periodMs;
+  for (uint8_t i = 0; i < n; i++) {
+    p[LIVE_FRAME_HDR + 2 * i]     = g_ring[i] >> 8;
+    p[LIVE_FRAME_HDR + 2 * i + 1] = g_ring[i];
+  }
+  if (!wsSend(WS_OP_BINARY, LIVE_FRAME_HDR + 2 * n)) { liveClose(); return; }
+  g_stats.frames++;
+  g_stats.sent += n;
+  advanceStart(n);
+}
+
+void livePush(float db) {
+  g_stats.windows++;
+  float pw = dbToPow(db);
+
+  // Summary for the durable path.
+  if (g_sumN == 0) g_sumStartMs = millis();
+  g_sumPow += pw;
+  g_sumN++;
+
+  // Not contiguous with the run in the ring: send what we have, drop the rest.
+  uint32_t expect = g_seq0 + (uint32_t)g_count * g_stride + g_partN;
+  if ((g_count || g_partN) && g_dueSeq != expect) {
+    liveFlush();
+    if (g_count || g_partN) {
+      g_stats.dropped += g_count + (g_partN ? 1 : 0);
+      g_count = 0;
+    }
+    g_partN = 0; g_partPow = 0.0f;
+  }
+  if (g_count == 0 && g_partN == 0) {
+    // New run: restore full resolution and stamp its start.
+    g_seq0 = g_dueSeq;
+    g_stride = 1;
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    bool valid = tv.tv_sec > 1609459200L;     // clock set (after 2021)
+    g_epoch0 = valid ? (uint32_t)tv.tv_sec : 0;
+    g_ms0 = valid ? (uint16_t)(tv.tv_usec / 1000) : 0;
+  }
+
+  g_partPow += pw;
+  if (++g_partN < g_stride) return;
+  g_ring[g_count++] = toCentiDb(powToDb(g_partPow / g_partN));
+  g_partPow = 0.0f;
+  g_partN = 0;
+  if (g_count == LIVE_RING_CAP) {
+    liveFlush();
+    if (g_count == LIVE_RING_CAP) coalesce();
+  }
+}
+
+void liveService() {
+  if (!liveActive()) {
+    if (g_sock) { wsSend(WS_OP_CLOSE, 0); g_sock->stop(); g_sock = nullptr; }
+    return;
+  }
+  if (g_sock && !g_sock->connected()) {
+    Serial.println(F("[live] connection lost"));
+    liveClose();
+  }
+  if (!g_sock) {
+    if ((long)(millis() - g_retryAt) < 0) return;
+    if (WiFi.status() != WL_CONNECTED || !liveConnect()) { liveClose(); return; }
+  }
+  liveRead();
+  liveFlush();
+}
+
+bool liveSummaryDue(float& leqDb) {
+  if (g_sumN == 0 || millis() - g_sumStartMs < (uint32_t)config().summary_s * 1000UL) return false;
+  leqDb = powToDb(g_sumPow / g_sumN);
+  Serial.printf("[live] Leq %.1f dB over %lu windows (%lu frames, %lu merged, %lu dropped)\n",
+                leqDb, (unsigned long)g_sumN, (unsigned long)g_stats.frames,
+                (unsigned long)g_stats.coalesced, (unsigned long)g_stats.dropped);
+  g_sumPow = 0.0f;
+  g_sumN = 0;
+  return true;
+}
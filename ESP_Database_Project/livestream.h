@@ -0,0 +1,91 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Live Level Stream
+* File Name            : livestream.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Stream sound levels at 10-50 updates/s over one long-lived WebSocket
+*   (RFC 6455) as compact binary frames, instead of one HTTP request per value.
+*   Levels wait in a small RAM ring; when the socket cannot take more bytes the
+*   ring coalesces neighbouring levels (energy mean) rather than dropping them,
+*   so a slow link lowers time resolution instead of losing coverage.
+*   An Leq summary per config().summary_s still goes through the durable upload
+*   path (HTTPS / CoAP / MQTT queue), so the database sees the session even if
+*   every live frame is lost.
+*
+* Inputs:
+*   - config().live_url      ws://host[:port]/path or wss://host[:port]/path
+*   - config().live_rate_hz  level updates per second (0 = off)
+*   - config().summary_s     summary period
+*   - livePush() levels from the sound pipeline
+*
+* Outputs:
+*   - Binary WebSocket messages, big-endian:
+*       0  u8   type        'L' (0x4C)
+*       1  u8   stride      raw windows per level (1, 2, 4, ... after coalescing)
+*       2  u16  count       levels in this message
+*       4  u32  seq         window number of the first level (gaps = missed windows)
+*       8  u32  epoch       wall clock of the first level, seconds (0 = clock unset)
+*      12  u16  ms          milliseconds part of the same instant
+*      14  u16  period_ms   nominal spacing of raw windows
+*      16  u16  level[count] centi-dB, level i covers windows seq + i*stride ...
+*   - liveSummaryDue(): Leq of the last summary period for the durable path.
+*
+* Example Application:
+*   if (liveActive() && liveWindowDue()) livePush(readSoundDbWindow(cfg, liveWindowSamples()));
+*   liveService();
+*   float leq;
+*   if (liveSummaryDue(leq)) ...;   // LiveLeqSensor in main.cpp (sensors.h) polls this
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WiFi.h>, <WiFiClientSecureBearSSL.h>
+*   - BearSSL SHA-1 (handshake accept check)
+*   - "config.h", "tls.h" (wss:// uses the configured verification mode)
+*
+* Usage Notes:
+*   - Reconnects with exponential back-off (1 s .. 60 s); levels keep
+*     accumulating (and coalescing) while the socket is down.
+*   - Server pings are answered; server data frames are ignored.
+*   - A blocking durable upload shows up as a seq gap, not as shifted times.
+*   - server/live_standin.py is a matching receiver for bench tests.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#define LIVE_RING_CAP      64        // levels held while the socket is busy or down
+#define LIVE_FRAME_HDR     16        // bytes before the level array
+
+// True when streaming is configured (rate > 0 and a ws:// or wss:// URL).
+bool liveActive();
+
+// True once per live period; call from loop() and sample one window when set.
+bool liveWindowDue();
+
+// Window length (samples at config().target_fs) that fits the live period.
+uint16_t liveWindowSamples();
+
+// Queue one level (dB) for the window that liveWindowDue() just announced.
+void livePush(float db);
+
+// Connect / reconnect, answer pings and send pending levels when the socket
+// has room. Non-blocking except during the opening handshake.
+void liveService();
+
+// Energy-mean level of the finished summary period; true once per period.
+bool liveSummaryDue(float& leqDb);
+
+// Counters for logs and bench runs.
+struct LiveStats {
+  uint32_t windows;     // levels produced
+  uint32_t sent;        // levels delivered to the socket (after coalescing)
+  uint32_t frames;      // WebSocket messages sent
+  uint32_t coalesced;   // pairwise merges under backpressure
+  uint32_t dropped;     // levels discarded (stream restart after a gap)
+  uint16_t reconnects;
+};
+const LiveStats& liveStats();
@@ -16,11 +16,11 @@
 *   - Pushbutton on D7 selects Sound sample (active LOW, INPUT_PULLUP).                         *
 *   - HC-SR04: TRIG=D5, ECHO=D1.                                                                *
 *   - MAX4466: analog OUT=A0.                                                                   *
-*   - Wi-Fi credentials (WIFI_SSID, WIFI_PASS).                                                 *
+*   - Wi-Fi credentials, endpoint and pins from the config block (config.h).                    *
 *   - Time zone via Serial prompt (IANA string, default "America/Los_Angeles").                 *
 *                                                                                               *
 * Outputs:                                                                                      *
-*   - HTTP POST to SERVER_BASE + POST_PATH with sensor reading, ISO UTC time, and TZ.           *
+*   - HTTP POST to server_base + post_path with sensor reading, ISO UTC time, and TZ.           *
 *   - Serial monitor diagnostics at 9600 baud.                                                  *
 *                                                                                               *
 * Example Application:                                                                          *
@@ -31,12 +31,26 @@
 *   - Arduino core for ESP8266                                                                  *
 *   - <ESP8266WiFi.h>                                                                           *
 *   - "sendRequest.h" providing postToServer() and connectionDetails()                          *
+*   - "config.h" persistent runtime configuration (EEPROM sector)                               *
+*   - "livestream.h" optional WebSocket stream of live sound levels (live_url/live_rate_hz)     *
+*   - "batchcodec.h" text or binary batch payloads (batch_format)                               *
+*   - "endpoints.h" failover between server_base and server_alt0/1                              *
+*   - "linkquality.h" batch size / flush interval adapted to link cost (link_adapt)             *
+*   - "netstats.h" upload bytes / requests / radio time per interval ("net")                    *
+*   - "metrics.h" Prometheus /metrics endpoint on metrics_port                                  *
+*   - "timeweight.h" Fast/Slow/Impulse levels between readings (tw_rate_hz, "lvl")              *
+*   - "adccal.h" ADC linearization table in flash ("adc point <mV>", "adc save")                *
+*   - "bias.h" mic DC bias tracked while sampling, kept in RTC memory / flash ("bias")          *
+*   - "classify.h" on-device acoustic event classifier (cls_period_s, "cls")                    *
+*   - "quality.h" per-window signal quality flags, fault readings dropped (quality_drop, "qual")*
+*   - "ranging.h" ultrasonic profiles, motion-adaptive ranging (range_idle_ms, "range")         *
+*   - "sensors.h" compile-time sensor set: schedule, fields and encoder per sensor              *
 *   - getTimeIsoUtc() implementation (talks to timeapi.io)                                      *
 *                                                                                               *
 * Usage Notes:                                                                                  *
 *   - Buttons are debounced in software (250 ms).                                               *
 *   - Inputs use INPUT_PULLUP; wire buttons to GND.                                             *
-*   - Replace Wi-Fi creds and server endpoint strings with your own.                            *
+*   - Set Wi-Fi creds and endpoint with "cfg set <key> <value>" on Serial.                      *
 *   - The “dB” value is a crude, relative estimate (not calibrated SPL).                        *
 * ------------------------------------------------------------------------------------------------
 */
@@ -44,23 +58,33 @@
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
 #include "sendRequest.h"
+#include "config.h"
+#include "sampling.h"
+#include "sequence.h"
+#include "tls.h"
+#include "readings.h"
+#include "coap.h"
+#include "mqtt.h"
+#include "livestream.h"
+#include "compress.h"
+#include "batchcodec.h"
+#include "endpoints.h"
+#include "linkquality.h"
+#include "netstats.h"
+#include "metrics.h"
+#include "timeweight.h"
+#include "adccal.h"
+#include "bias.h"
+#include "classify.h"
+#include "quality.h"
+#include "ranging.h"
+#include "sensors.h"
 
 // --------- USER SETTINGS ----------
-// Wi-Fi credentials used by the ESP8266 station interface.
-const char* WIFI_SSID = "Mark P";
-const char* WIFI_PASS = "testingwifi";
-
-// REST endpoint configuration.
-// SERVER_BASE is the base URL; POST_PATH is appended for the ingest endpoint.
-const String SERVER_BASE = "https://markpulido.io/api"; // Hostinger /api folder
-const String POST_PATH  = "/ingest.php";                 // endpoint that calls sp_insert_sensor_data
-
-// GPIO assignments for NodeMCU v2 board layout.
-const int PIN_TRIG      = D5;  // HC-SR04 trig
-const int PIN_ECHO      = D1;  // HC-SR04 echo
-const int PIN_BTN_ULTRA = D3;  // pushbutton to GND (INPUT_PULLUP)
-const int PIN_BTN_SOUND = D7;  // pushbutton to GND (INPUT_PULLUP)
-const int PIN_SOUND     = A0;  // MAX4466 analog out
+// Wi-Fi credentials, REST endpoint, GPIO assignments, sampling and calibration
+// values live in the persistent configuration block (config.h). Their
+// compile-time defaults are the CFG_DEFAULT_* macros; change them at runtime
+// over Serial with "cfg set <key> <value>" (see handleConsole()).
 
 // Default IANA time zone used when user presses ENTER at the Serial prompt.
 String tzRegion = "America/Los_Angeles";
@@ -72,11 +96,7 @@ extern bool getTimeIsoUtc(const String& tzRegion, String& outIsoUtc);
 
 // ----- Application state -----
 // Indicates which sensor to sample based on button press.
-enum NodeSel { NODE_NONE=0, NODE_ULTRA=1, NODE_SOUND=2 };
-
-// Identifiers sent to the server so it can distinguish node types.
-String nodeUltraName = "Ultrasonic_Sensor";
-String nodeSoundName = "Sound_Sensor_MAX4466";
+enum NodeSel { NODE_NONE=0, NODE_ULTRA=1, NODE_SOUND=2, NODE_CLASS=3 };
 
 // Simple debounce bookkeeping for each button.
 unsigned long lastUltraMs = 0, lastSoundMs = 0;
@@ -88,8 +108,8 @@ const unsigned long DEBOUNCE = 250;
 // Buttons are active-LOW due to INPUT_PULLUP.
 NodeSel check_switch() {
   // active LOW (INPUT_PULLUP)
-  bool ultraPressed = (digitalRead(PIN_BTN_ULTRA) == LOW);
-  bool soundPressed = (digitalRead(PIN_BTN_SOUND) == LOW);
+  bool ultraPressed = (digitalRead(config().pin_btn_ultra) == LOW);
+  bool soundPressed = (digitalRead(config().pin_btn_sound) == LOW);
 
   unsigned long now = millis();
   if (ultraPressed && (now - lastUltraMs > DEBOUNCE)) {
@@ -111,40 +131,124 @@ bool read_time(String& isoUtcOut) {
 }
 
 // Read HC-SR04 ultrasonic sensor and return distance in centimeters.
-// Uses a 30 ms pulseIn timeout; returns NaN on timeout.
+// The echo timeout, ping spacing and near-field gate follow the configured
+// range profile (ranging.h); with range_pings > 1 the median valid echo wins.
+// Returns NaN without a valid echo, which quality.h flags (QUALITY_NO_ECHO)
+// on the reading. Conversion is folded at compile time (RangePipeline).
 float read_sensor_1() { // Ultrasonic HC-SR04, returns distance in cm
-  digitalWrite(PIN_TRIG, LOW); delayMicroseconds(2);
-  digitalWrite(PIN_TRIG, HIGH); delayMicroseconds(10);
-  digitalWrite(PIN_TRIG, LOW);
-  long duration = pulseIn(PIN_ECHO, HIGH, 30000UL); // 30ms timeout
-  if (duration == 0) return NAN;
-  float cm = duration * 0.0343f / 2.0f;
-  return cm;
+  return readRangeCm(config());
 }
 
 // Sample MAX4466 microphone on A0 and compute a crude, relative “dB-like” level.
 // This is not calibrated SPL; it serves as a simple activity indicator.
+// Window length and spacing come from config().samples / config().target_fs;
+// common pairs run a compile-time specialized loop (see sampling.h).
+// The level is taken around the tracked DC bias (bias.h), restored at boot.
+// The window's clip / stuck / bias / jitter flags go with the reading (quality.h).
 float read_sensor_2() { // MAX4466 sound level, crude relative dB
-  const int N = 200;               // number of samples to average
-  long sum = 0;
-  for (int i=0;i<N;i++) { sum += analogRead(PIN_SOUND); delayMicroseconds(200); }
-  float adc = (float)sum / N;      // ~0..1023
-  float level = fabs(adc - 512.0f);// AC component around mid-rail
-  float db = 20.0f * log10f(max(level, 1.0f)); // relative “dB-like”
-  if (!isfinite(db)) db = 0.0f;
-  return db;
+  return readSoundDb(config());
 }
 
+// ----- Sensors (sensors.h) -----
+// Each reports as one node, fills the fields it declares and runs on its own
+// schedule; loop() services them all through Sensors. A new sensor is one
+// more struct here and one more entry in the list.
+
+// D3 button: one reading with the configured ranging profile.
+struct UltraSensor : Sensor<UltraSensor, OnSwitch<READING_NODE_ULTRA>> {
+  static constexpr uint8_t kNode = READING_NODE_ULTRA;
+  static constexpr uint8_t kFields = READING_FIELD_DIST;
+  typedef float Value;
+  static bool measure(Value& cm) { cm = read_sensor_1(); return true; }
+  static void encode(const Value& cm, Reading& r) { r.distance_cm = cm; }
+};
+
+// D7 button: one sound window.
+struct SoundSensor : Sensor<SoundSensor, OnSwitch<READING_NODE_SOUND>> {
+  static constexpr uint8_t kNode = READING_NODE_SOUND;
+  static constexpr uint8_t kFields = READING_FIELD_SOUND;
+  typedef float Value;
+  static bool measure(Value& db) { db = read_sensor_2(); return true; }
+  static void encode(const Value& db, Reading& r) { r.sound_db = db; }
+};
+
+// Class probabilities once per classifier window (classify.h).
+struct ClassSensor : Sensor<ClassSensor, SelfPaced> {
+  static constexpr uint8_t kNode = READING_NODE_CLASS;
+  static constexpr uint8_t kFields = READING_FIELD_CLASSES;
+  typedef ClsResult Value;
+  static bool measure(Value& res) { return clsService(res); }
+  static void encode(const Value& res, Reading& r) { memcpy(r.cls, res.pct, READING_CLASSES); }
+  static bool busy() { return clsCapturing(); }   // frames must stay contiguous
+};
+
+// Motion-adaptive ranging (ranging.h): every reading while active, with its
+// interval, and the transition event on the readings that change the rate.
+struct AdaptiveRangeSensor : Sensor<AdaptiveRangeSensor, SelfPaced> {
+  static constexpr uint8_t kNode = READING_NODE_ULTRA;
+  static constexpr uint8_t kFields = READING_FIELD_DIST | READING_FIELD_INTERVAL;
+  typedef RangeSample Value;
+  static bool measure(Value& s) { return rangeService(s); }
+  static void encode(const Value& s, Reading& r) {
+    r.distance_cm = s.cm;
+    r.interval_ms = s.intervalMs;
+    r.range_event = s.event;
+    if (s.event) r.fields |= READING_FIELD_EVENT;
+  }
+  static bool busy() { return rangeActive(); }    // fast rate paces the loop
+};
+
+// Live mode Leq summary (livestream.h), once per summary period.
+struct LiveLeqSensor : Sensor<LiveLeqSensor, SelfPaced> {
+  static constexpr uint8_t kNode = READING_NODE_SOUND;
+  static constexpr uint8_t kFields = READING_FIELD_SOUND;
+  typedef float Value;
+  static bool measure(Value& leq) { return liveSummaryDue(leq); }
+  static void encode(const Value& leq, Reading& r) { r.sound_db = leq; }
+};
+
+typedef SensorSet<UltraSensor, SoundSensor, ClassSensor, AdaptiveRangeSensor, LiveLeqSensor> Sensors;
+
 // Package and transmit a reading to the server.
-// Returns true if HTTP status is 2xx.
-bool transmit(NodeSel who, const String& isoUtc, float dist_cm, float sound_db) {
-  int code; String resp;
-  String node = (who == NODE_ULTRA) ? nodeUltraName : nodeSoundName;
-  bool ok = postToServer(SERVER_BASE, POST_PATH, node, isoUtc, tzRegion,
-                         dist_cm, sound_db, code, resp);
-  Serial.printf("POST -> %d\n", code);
-  Serial.println(resp);
-  return ok && code >= 200 && code < 300;
+// Uses the transport selected in config(): HTTPS, or signed plain HTTP
+// to a LAN gateway. Returns true if HTTP status is 2xx.
+// The reading gets one sequence number and keeps it across retries, so a
+// retry after a lost response is dropped by the server instead of stored twice.
+// Each attempt goes to the healthiest endpoint (endpoints.h); a retry that
+// fails over to another endpoint goes out at once, without the back-off delay.
+// 'trace' carries the capture time; its trace ID follows the sequence number.
+// Node name and the fields present in it (schema.h) come from 'r'.
+const uint8_t TRANSMIT_ATTEMPTS = 3;
+
+bool transmit(Reading r, const String& isoUtc, UploadTrace trace) {
+  int code = 0; String resp;
+  const NodeConfig& cfg = config();
+  if (cfg.transport == TRANSPORT_HMAC_HTTP && !nodeKeySet(cfg.node_key, NODE_KEY_LEN)) return false;
+  uint32_t seq = seqNext();
+  if (!seq) return false;              // never send with an unsaved number
+  r.seq = seq;
+  trace.seq = seq;
+  uint8_t lastEp = 0xFF;
+  for (uint8_t attempt = 0; attempt < TRANSMIT_ATTEMPTS; attempt++) {
+    uint8_t ep = endpointPick();
+    if (attempt && ep == lastEp) delay(1000UL << (attempt - 1));   // 1 s, 2 s
+    lastEp = ep;
+    bool ok;
+    uint32_t t0 = millis();
+    if (cfg.transport == TRANSPORT_HMAC_HTTP) {
+      ok = postToServerSigned(endpointBase(ep), cfg.post_path, r, isoUtc, tzRegion,
+                              cfg.node_key, NODE_KEY_LEN, code, resp, &trace);
+      Serial.printf("POST #%u (signed, trace %s) -> %d\n", ep, traceId(seq).c_str(), code);
+    } else {
+      ok = postToServer(endpointBase(ep), cfg.post_path, r, isoUtc, tzRegion, code, resp, &trace);
+      Serial.printf("POST #%u (trace %s) -> %d\n", ep, traceId(seq).c_str(), code);
+    }
+    endpointReport(ep, endpointHttpResult(ok, code), millis() - t0);
+    Serial.println(resp);
+    if (ok && code >= 200 && code < 300) { netReadings(1); return true; }
+    if (ok && code >= 400 && code < 500) return false;   // request itself rejected
+  }
+  return false;
 }
 
 // Log success/failure to Serial.
@@ -152,6 +256,141 @@ void check_error(bool ok) {
   if (!ok) Serial.println("[ERROR] transmit failed");
   else     Serial.println("[OK] data sent");
 }
+
+// True when the configured transport uploads queued batches rather than
+// one POST per reading.
+bool batchedTransport() {
+  return config().transport == TRANSPORT_COAP || config().transport == TRANSPORT_MQTT ||
+         config().transport == TRANSPORT_HTTPS_BATCH;
+}
+
+// Upload one encoded batch over CoAP or HTTPS to endpoint 'ep' (MQTT
+// batches go through mqttService()). Returns true once the server
+// acknowledged it (2.xx).
+bool transmitBatch(uint8_t ep, const BatchPayload& body, uint8_t count) {
+  const NodeConfig& cfg = config();
+  const Reading& first = readingAt(0);   // batches start at the queue front
+  if (cfg.transport == TRANSPORT_HTTPS_BATCH) {
+    int code; String resp;
+    UploadTrace trace = { first.seq, first.epoch, first.ms };
+    uint32_t t0 = millis();
+    bool ok = postBatch(endpointBase(ep), cfg.post_path, body.data(), body.length(), body.contentType(),
+                        cfg.compress, code, resp, &trace);
+    uint32_t ms = millis() - t0;
+    endpointReport(ep, endpointHttpResult(ok, code), ms);
+    linkReportUpload(body.length(), count, ms, ok && code >= 200 && code < 300);
+    Serial.printf("POST #%u batch %u readings, %u B, trace %s -> %d (%lu ms)\n", ep, count, (unsigned)body.length(),
+                  traceId(first.seq).c_str(), code, (unsigned long)ms);
+    return ok && code >= 200 && code < 300;
+  }
+  String host; uint16_t port;
+  if (!coapParseBase(endpointBase(ep), host, port)) return false;
+  uint32_t t0 = millis();
+  int code = coapPost(host.c_str(), port, cfg.post_path, body.data(), body.length(),
+                      body.binary() ? COAP_FMT_BATCH : COAP_FMT_TEXT);
+  uint32_t ms = millis() - t0;
+  if (code != COAP_ERR_TOO_LARGE) {   // local limit, not the link's or endpoint's fault
+    endpointReport(ep, code < 0 ? ENDPOINT_UNREACHABLE : code >= 500 ? ENDPOINT_FAILED : ENDPOINT_OK, ms);
+    linkReportUpload(body.length(), count, ms, code >= 200 && code < 300);
+  }
+  Serial.printf("CoAP POST #%u %u readings, %u B, trace %s -> %d.%02d (%lu ms)\n", ep, count,
+                (unsigned)body.length(), traceId(first.seq).c_str(), code / 100, code % 100, (unsigned long)ms);
+  return code >= 200 && code < 300;
+}
+
+// Flush queued readings once a full batch is waiting or the oldest reading
+// has waited flush_ms. Failed uploads stay queued and are retried after a
+// back-off, so a dead link does not stall sampling.
+void serviceBatch() {
+  static unsigned long retryAt = 0;
+  static unsigned long backoffMs = 0;
+  const NodeConfig& cfg = config();
+
+  uint8_t n = readingCount();
+  uint32_t ageMs = n ? (uint32_t)(time(nullptr) - (time_t)readingAt(0).epoch) * 1000UL : 0;
+
+  // MQTT keeps its own connection, window and retries; service it every pass
+  // so keep-alives and PUBACKs are handled even with an empty queue.
+  if (cfg.transport == TRANSPORT_MQTT) { mqttService(tzRegion, ageMs >= linkFlushMs()); return; }
+
+  if (n == 0 || !batchedTransport()) return;
+  if (backoffMs && (long)(millis() - retryAt) < 0) return;
+
+  uint8_t want = linkBatchSize();
+  if (n < want && ageMs < linkFlushMs()) return;
+  want = readingSequenced(want);       // 0: sequence bound not saved, retry later
+
+  BatchPayload body;
+  uint8_t count = batchPayload(0, want, tzRegion, body);
+  uint8_t ep = endpointPick();
+  bool ok = count && body.length() && transmitBatch(ep, body, count);
+  check_error(ok);
+  if (ok) {
+    readingDrop(count);
+    netReadings(count);
+    backoffMs = 0;
+  } else if (endpointPick() != ep) {
+    retryAt = millis();   // failed over: try the new endpoint on the next pass
+  } else {
+    backoffMs = backoffMs ? min(backoffMs * 2, 300000UL) : 5000UL;
+    retryAt = millis() + backoffMs;
+  }
+}
+
+// Hand one reading from any sensor (sensors.h) to the durable upload path:
+// queue it for a batched transport, otherwise timestamp it and POST it now.
+// Returns false if it could not be queued or sent, or if its quality flags
+// (quality.h) are in config().quality_drop and it was suppressed.
+bool submitReading(Reading r) {
+  String isoUtc;
+  metricsReading(r.node);
+  r.quality = qualityTake(r.node);
+  if (r.quality & config().quality_drop) { qualityDropped(r.quality); return false; }
+  if (r.quality) r.fields |= READING_FIELD_QUALITY;
+
+  // Batched transports: stamp the reading from the system clock and queue it.
+  // SNTP is only consulted when the clock has never been set.
+  if (batchedTransport()) {
+    if (!captureTime(r.epoch, r.ms) && !(read_time(isoUtc) && captureTime(r.epoch, r.ms))) {
+      Serial.println("[ERROR] clock not set");
+      return false;
+    }
+    PushResult pushed = readingPush(r);
+    if (pushed == PUSH_REJECTED) {
+      Serial.println("[WARN] queue full and in flight, new reading dropped");
+      return false;
+    }
+    if (pushed == PUSH_EVICTED) Serial.println("[WARN] queue full, oldest reading dropped");
+    Serial.printf("queued (%u pending)\n", readingCount());
+    return true;
+  }
+
+  // Capture time for tracing, taken before the SNTP round trip (or right
+  // after it, when that is what first sets the clock).
+  UploadTrace trace = { 0, 0, 0 };
+  bool captured = captureTime(trace.captureSec, trace.captureMs);
+
+  // Resolve timestamp for the current time zone selection.
+  if (!read_time(isoUtc)) {
+    Serial.println("[ERROR] timeapi.io fetch failed");
+    return false;
+  }
+  Serial.print("ISO UTC: "); Serial.println(isoUtc);
+  if (!captured) captureTime(trace.captureSec, trace.captureMs);
+
+  // Transmit payload and report result.
+  bool sent = transmit(r, isoUtc, trace);
+  check_error(sent);
+  return sent;
+}
+
+// Live mode: one short sound window per live period onto the WebSocket
+// stream (the Leq summary reading is LiveLeqSensor).
+void serviceLive() {
+  const NodeConfig& cfg = config();
+  if (liveWindowDue()) livePush(readSoundDbWindow(cfg, liveWindowSamples()));
+  liveService();
+}
 // =====================================
 
 // Prompt the user once at boot for an IANA time zone.
@@ -175,58 +414,150 @@ void promptTimeZone() {
   Serial.print("Using TZ: "); Serial.println(tzRegion);
 }
 
+// Close the upload statistics interval when due; over MQTT the record is
+// also published to <mqtt_topic>/<nodeId>/net.
+void serviceNetStats() {
+  NetRecord rec;
+  uint8_t wire[NET_WIRE_SIZE];
+  if (netService(rec) && config().transport == TRANSPORT_MQTT)
+    mqttPublishAux("net", wire, netEncode(rec, wire));
+}
+
+// Minimal Serial console for the configuration store:
+//   cfg                  print current settings
+//   cfg set <key> <val>  change one setting (RAM; committed after a quiet period)
+//   cfg save             commit pending changes now
+//   cfg reset            restore compile-time defaults
+//   ep                   upload endpoint health (endpoints.h)
+//   link                 link quality and adaptive batch decision (linkquality.h)
+//   net                  upload bytes, requests and radio time (netstats.h)
+//   lvl                  Fast/Slow/Impulse level history (timeweight.h)
+//   adc [point <mV>|save|reset]  ADC calibration table (adccal.h)
+//   bias                 tracked mic DC bias and its stored copies (bias.h)
+//   cls                  latest class probabilities and classifier cost (classify.h)
+//   qual                 last window's signal quality and flag counters (quality.h)
+//   range                ranging profile timing and ping counters (ranging.h)
+// Pin and Wi-Fi changes take effect after the next reboot.
+void handleConsole() {
+  static char line[128];
+  static uint8_t len = 0;
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c != '\r' && c != '\n') {
+      if (len < sizeof(line) - 1) line[len++] = c;
+      continue;
+    }
+    if (len == 0) continue;
+    line[len] = '\0';
+    len = 0;
+
+    char* cmd = strtok(line, " ");
+    if (cmd && !strcmp(cmd, "ep")) { endpointPrint(); continue; }
+    if (cmd && !strcmp(cmd, "link")) { linkPrint(); continue; }
+    if (cmd && !strcmp(cmd, "net")) { netPrint(); continue; }
+    if (cmd && !strcmp(cmd, "lvl")) { twPrint(); continue; }
+    if (cmd && !strcmp(cmd, "bias")) { biasPrint(); continue; }
+    if (cmd && !strcmp(cmd, "cls")) { clsPrint(); continue; }
+    if (cmd && !strcmp(cmd, "qual")) { qualityPrint(); continue; }
+    if (cmd && !strcmp(cmd, "range")) { rangePrint(); continue; }
+    if (cmd && !strcmp(cmd, "adc")) {
+      char* sub = strtok(nullptr, " ");
+      char* mv = strtok(nullptr, " ");
+      if (!sub) adcCalPrint();
+      else if (!strcmp(sub, "point") && mv) adcCalPoint(config().pin_sound, atof(mv));
+      else if (!strcmp(sub, "save")) adcCalSave();
+      else if (!strcmp(sub, "reset")) adcCalReset();
+      else Serial.println(F("[adc] usage: adc [point <mV> | save | reset]"));
+      continue;
+    }
+    if (!cmd || strcmp(cmd, "cfg") != 0) { Serial.println(F("[cfg] unknown command")); continue; }
+    char* sub = strtok(nullptr, " ");
+    if (!sub) { configPrint(); continue; }
+    if (!strcmp(sub, "save"))  { configFlush(); continue; }
+    if (!strcmp(sub, "reset")) { configReset(); configPrint(); continue; }
+    if (!strcmp(sub, "set")) {
+      char* key = strtok(nullptr, " ");
+      char* val = strtok(nullptr, "");   // rest of line (SSIDs may contain spaces)
+      if (key && val && configSetField(key, val)) Serial.println(F("[cfg] ok"));
+      else Serial.println(F("[cfg] rejected"));
+      continue;
+    }
+    Serial.println(F("[cfg] usage: cfg [set <key> <value> | save | reset]"));
+  }
+}
+
 void setup() {
   Serial.begin(9600);
   delay(300);
 
+  // Load persistent settings before anything that depends on them.
+  configBegin();
+  seqBegin();
+  adcCalBegin();
+  biasBegin();
+  const NodeConfig& cfg = config();
+
   // Configure GPIOs.
-  pinMode(PIN_TRIG, OUTPUT);
-  pinMode(PIN_ECHO, INPUT);
-  pinMode(PIN_BTN_ULTRA, INPUT_PULLUP);
-  pinMode(PIN_BTN_SOUND, INPUT_PULLUP);
+  pinMode(cfg.pin_trig, OUTPUT);
+  pinMode(cfg.pin_echo, INPUT);
+  pinMode(cfg.pin_btn_ultra, INPUT_PULLUP);
+  pinMode(cfg.pin_btn_sound, INPUT_PULLUP);
 
   Serial.println("\nBooting...");
+#ifdef SAMPLING_BENCH
+  runSamplingBench();
+#endif
+#ifdef COMPRESS_BENCH
+  runCompressBench();
+  runBatchCodecBench();
+#endif
   promptTimeZone();
 
   // Bring up Wi-Fi in station mode and connect to the configured network.
   WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASS);
+  WiFi.begin(cfg.wifi_ssid, cfg.wifi_pass);
   Serial.print("Connecting to WiFi");
   while (WiFi.status() != WL_CONNECTED) { delay(500); Serial.print("."); }
   Serial.println();
   connectionDetails();  // from sendRequest.h: prints IP, RSSI, etc.
+  metricsBegin();
+#ifdef TLS_BENCH
+  {
+    // Host part of server_base, e.g. "markpulido.io" from "https://markpulido.io/api".
+    String host = cfg.server_base;
+    int s = host.indexOf("//");
+    if (s >= 0) host = host.substring(s + 2);
+    int e = host.indexOf('/');
+    if (e >= 0) host = host.substring(0, e);
+    runTlsBench(host.c_str());
+  }
+#endif
 }
 
 void loop() {
-  // Poll buttons and decide which sensor to sample.
-  NodeSel who = check_switch();
-  if (who == NODE_NONE) { delay(25); return; }
-
-  float dist_cm = 0.0f;
-  float sound_db = 0.0f;
-
-  // Read only the chosen sensor; send 0 for the other field.
-  if (who == NODE_ULTRA) {
-    dist_cm = read_sensor_1();
-    sound_db = 0.0f;                  // send only ultrasonic
-  } else { // NODE_SOUND
-    sound_db = read_sensor_2();
-    dist_cm = 0.0f;                   // send only microphone
-  }
-  Serial.printf("dist=%.2f cm, sound=%.2f dB\n", dist_cm, sound_db);
+  // Service the config console and any batched flash commit.
+  metricsLoopTick();
+  handleConsole();
+  configService();
+  endpointService();
+  linkService();
+  serviceBatch();
+  serviceLive();
+  twService();
+  biasService();
 
-  // Resolve timestamp for the current time zone selection.
-  String isoUtc;
-  if (!read_time(isoUtc)) {
-    Serial.println("[ERROR] timeapi.io fetch failed");
-    return;
-  }
-  Serial.print("ISO UTC: "); Serial.println(isoUtc);
-
-  // Transmit payload and report result.
-  bool sent = transmit(who, isoUtc, dist_cm, sound_db);
-  check_error(sent);
+  // Poll buttons, then every sensor on its own schedule; each reading goes
+  // up the same path whatever its node and fields.
+  NodeSel who = check_switch();
+  SensorTick tick = { (uint32_t)millis(), (uint8_t)who };
+  Sensors::service(tick, [](const Reading& r) { submitReading(r); });
+  serviceNetStats();
+  metricsService();
 
   // Simple guard against repeats when a button is held down.
-  delay(500);
+  // (No idle delay while streaming, time weighting or while a sensor is
+  // mid-measurement: their sample clocks pace the loop.)
+  if (who != NODE_NONE) delay(500);
+  else if (!liveActive() && !twActive() && !Sensors::busy()) delay(25);
+  else yield();
 }
@@ -0,0 +1,230 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Prometheus Metrics Endpoint
+* File Name            : metrics.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Loop / sensor counters, the /metrics page renderer and its HTTP server
+*   (see metrics.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WebServer.h>
+*   - "metrics.h", "config.h", "readings.h", "netstats.h", "livestream.h",
+*     "linkquality.h", "oversample.h", "timeweight.h", "classify.h", "quality.h",
+*     "ranging.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+#include <stdarg.h>
+#include "config.h"
+#include "readings.h"
+#include "netstats.h"
+#include "livestream.h"
+#include "linkquality.h"
+#include "oversample.h"
+#include "timeweight.h"
+#include "classify.h"
+#include "quality.h"
+#include "ranging.h"
+#include "metrics.h"
+
+static ESP8266WebServer* g_server = nullptr;
+static char g_chunk[METRICS_CHUNK];
+
+static const uint16_t LOOP_BOUNDS[METRICS_LOOP_BUCKETS] = METRICS_LOOP_BOUNDS_MS;
+static uint32_t g_loopBucket[METRICS_LOOP_BUCKETS + 1];   // per bucket; last = above all bounds
+static uint32_t g_loopSumMs = 0;
+static uint32_t g_loopMaxMs = 0;                           // since the last scrape
+static uint32_t g_lastTickMs = 0;
+static uint32_t g_captured[3] = { 0, 0, 0 };               // ultrasonic, sound, classifier
+
+void metricsLoopTick() {
+  uint32_t now = millis();
+  if (g_lastTickMs) {
+    uint32_t ms = now - g_lastTickMs;
+    uint8_t b = 0;
+    while (b < METRICS_LOOP_BUCKETS && ms > LOOP_BOUNDS[b]) b++;
+    g_loopBucket[b]++;
+    g_loopSumMs += ms;
+    if (ms > g_loopMaxMs) g_loopMaxMs = ms;
+  }
+  g_lastTickMs = now;
+}
+
+void metricsReading(uint8_t node) {
+  if (node == READING_NODE_ULTRA) g_captured[0]++;
+  else if (node == READING_NODE_SOUND) g_captured[1]++;
+  else if (node == READING_NODE_CLASS) g_captured[2]++;
+}
+
+// Collects output in g_chunk and hands it to the sink whenever the next
+// piece would not fit, so only whole printf() pieces are ever sent.
+struct Page {
+  MetricsSink sink; void* ctx; size_t len; size_t total; bool dropped;
+
+  void flush() {
+    if (!len) return;
+    sink(g_chunk, len, ctx);
+    total += len;
+    len = 0;
+  }
+
+  void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    for (;;) {
+      va_list ap;
+      va_start(ap, fmt);
+      int n = vsnprintf(g_chunk + len, sizeof(g_chunk) - len, fmt, ap);
+      va_end(ap);
+      if (n >= 0 && (size_t)n < sizeof(g_chunk) - len) { len += n; return; }
+      if (n < 0 || !len) { dropped = true; g_chunk[len] = '\0'; return; }   // longer than a chunk
+      flush();
+    }
+  }
+
+  void head(const char* name, const char* type, const char* help) {
+    printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+  }
+
+  void gauge(const char* name, const char* help, double v) {
+    head(name, "gauge", help);
+    printf("%s %.10g\n", name, v);
+  }
+
+  void counter(const char* name, const char* help, double v) {
+    head(name, "counter", help);
+    printf("%s %.10g\n", name, v);
+  }
+
+  // Histogram from per-bucket counts (converted to cumulative), bounds in ms.
+  void histogram(const char* name, const char* help, const uint16_t* boundsMs, const uint32_t* bucket,
+                 uint8_t n, uint32_t sumMs) {
+    head(name, "histogram", help);
+    uint32_t cum = 0;
+    for (uint8_t i = 0; i < n; i++) {
+      cum += bucket[i];
+      printf("%s_bucket{le=\"%g\"} %lu\n", name, boundsMs[i] / 1000.0, (unsigned long)cum);
+    }
+    cum += bucket[n];
+    printf("%s_bucket{le=\"+Inf\"} %lu\n%s_sum %.3f\n%s_count %lu\n",
+           name, (unsigned long)cum, name, sumMs / 1000.0, name, (unsigned long)cum);
+  }
+};
+
+size_t metricsRender(MetricsSink sink, void* ctx) {
+  static const uint16_t LATENCY_BOUNDS[NET_LATENCY_BUCKETS] = NET_LATENCY_BOUNDS_MS;
+  static const char* const TRANSPORT_NAMES[] = { "https", "hmac_http", "coap", "mqtt", "https_batch" };
+  Page p = { sink, ctx, 0, 0, false };
+  const NetTotals& t = netTotals();
+
+  p.head("ee570_node_info", "gauge", "Node identity and configured transport.");
+  p.printf("ee570_node_info{node=\"%08lx\",transport=\"%s\"} 1\n",
+           (unsigned long)ESP.getChipId(), TRANSPORT_NAMES[config().transport]);
+  p.gauge("ee570_uptime_seconds", "Time since boot.", millis() / 1000.0);
+  p.gauge("ee570_heap_free_bytes", "Free heap.", ESP.getFreeHeap());
+  p.gauge("ee570_heap_max_block_bytes", "Largest free heap block.", ESP.getMaxFreeBlockSize());
+  p.gauge("ee570_heap_fragmentation_percent", "Heap fragmentation.", ESP.getHeapFragmentation());
+  p.gauge("ee570_wifi_rssi_dbm", "Smoothed Wi-Fi RSSI (0 = no sample yet).", linkRssi());
+
+  p.gauge("ee570_queue_readings", "Readings waiting for upload.", readingCount());
+  p.gauge("ee570_queue_capacity_readings", "Reading queue capacity.", READING_QUEUE_CAP);
+  p.counter("ee570_queue_overflows_total", "Readings lost to a full queue.", readingOverflows());
+  p.gauge("ee570_batch_size_readings", "Readings per batch in use (linkquality.h).", linkBatchSize());
+
+  p.head("ee570_readings_captured_total", "counter", "Readings taken, per sensor.");
+  p.printf("ee570_readings_captured_total{sensor=\"%s\"} %lu\n", READING_NAME_ULTRA, (unsigned long)g_captured[0]);
+  p.printf("ee570_readings_captured_total{sensor=\"%s\"} %lu\n", READING_NAME_SOUND, (unsigned long)g_captured[1]);
+  p.printf("ee570_readings_captured_total{sensor=\"%s\"} %lu\n", READING_NAME_CLASS, (unsigned long)g_captured[2]);
+  p.counter("ee570_live_levels_total", "Live stream sound levels produced.", liveStats().windows);
+  const OversampleStats& os = oversampleStats();
+  p.gauge("ee570_adc_oversample_ratio", "ADC samples per sound sample in the last oversampled window (0 = none).", os.ratio);
+  p.gauge("ee570_adc_burst_rate_hz", "Achieved ADC rate in the last oversampled window.", os.inputHz);
+  p.counter("ee570_adc_late_samples_total", "Oversampled ADC reads taken after their slot.", os.late);
+  if (twActive()) {
+    const TwLevel& l = twLatest();
+    p.head("ee570_sound_level_db", "gauge", "Time-weighted sound level, Z-weighted (timeweight.h).");
+    p.printf("ee570_sound_level_db{weighting=\"fast\"} %.2f\n", l.fast_cdb / 100.0);
+    p.printf("ee570_sound_level_db{weighting=\"slow\"} %.2f\n", l.slow_cdb / 100.0);
+    p.printf("ee570_sound_level_db{weighting=\"impulse\"} %.2f\n", l.imp_cdb / 100.0);
+    p.printf("ee570_sound_level_db{weighting=\"fast_max\"} %.2f\n", l.fmax_cdb / 100.0);
+    p.printf("ee570_sound_level_db{weighting=\"peak\"} %.2f\n", l.peak_cdb / 100.0);
+    p.counter("ee570_sound_samples_weighted_total", "Samples through the time-weighting stage.", twStats().samples);
+    p.counter("ee570_sound_slots_missed_total", "Sample slots missed while loop() was busy.", twStats().missed);
+  }
+  if (clsActive()) {
+    const ClsResult& r = clsLatest();
+    p.head("ee570_sound_class_probability", "gauge", "Latest acoustic class probabilities (classify.h).");
+    for (uint8_t c = 0; c < CLS_CLASSES; c++)
+      p.printf("ee570_sound_class_probability{class=\"%s\"} %.2f\n", CLS_NAMES[c], r.pct[c] / 100.0);
+    p.counter("ee570_sound_class_windows_total", "Windows classified.", clsStats().windows);
+    p.gauge("ee570_sound_class_frame_cycles", "CPU cycles of the last classifier frame (ADC excluded).", clsStats().frameCycles);
+  }
+
+  const QualityStats& qs = qualityStats();
+  p.head("ee570_quality_flagged_total", "counter", "Sound windows / distance readings per quality flag (quality.h).");
+  for (uint8_t b = 0; b < QUALITY_FLAG_COUNT; b++)
+    p.printf("ee570_quality_flagged_total{flag=\"%s\"} %lu\n", QUALITY_NAMES[b], (unsigned long)qs.flagged[b]);
+  p.counter("ee570_quality_dropped_total", "Readings suppressed by quality_drop.", qs.dropped);
+  p.gauge("ee570_quality_echo_timeouts_recent", "Echo timeouts among the last 16 pings.", qs.echoRecent);
+  if (config().range_idle_ms) {
+    const RangeMotion& rm = rangeMotion();
+    p.gauge("ee570_range_interval_ms", "Adaptive ranging interval (ranging.h).", rm.intervalMs);
+    p.gauge("ee570_range_active", "1 while motion keeps ranging faster than idle.", rm.active ? 1 : 0);
+    p.counter("ee570_range_transitions_total", "Idle <-> active ranging rate transitions.", rm.transitions);
+    p.counter("ee570_range_readings_total", "Adaptive ranging readings.", rm.readings);
+  }
+
+  p.counter("ee570_readings_uploaded_total", "Readings acknowledged by the server.", t.readings);
+  p.counter("ee570_upload_requests_total", "Upload exchanges, retries included.", t.requests);
+  p.counter("ee570_upload_failures_total", "Upload exchanges not acknowledged.", t.failures);
+  p.counter("ee570_tls_handshakes_total", "Completed TLS handshakes.", t.handshakes);
+  p.head("ee570_upload_bytes_total", "counter", "Upload bytes; estimated = HTTP headers and TLS, not measurable.");
+  p.printf("ee570_upload_bytes_total{dir=\"tx\",kind=\"measured\"} %lu\n", (unsigned long)t.txBytes);
+  p.printf("ee570_upload_bytes_total{dir=\"rx\",kind=\"measured\"} %lu\n", (unsigned long)t.rxBytes);
+  p.printf("ee570_upload_bytes_total{dir=\"tx\",kind=\"estimated\"} %lu\n", (unsigned long)t.ovhTxEst);
+  p.printf("ee570_upload_bytes_total{dir=\"rx\",kind=\"estimated\"} %lu\n", (unsigned long)t.ovhRxEst);
+  p.counter("ee570_radio_seconds_total", "Time with upload traffic outstanding.", t.radioMs / 1000.0);
+  p.histogram("ee570_upload_latency_seconds", "Upload request to response.",
+              LATENCY_BOUNDS, t.latencyBucket, NET_LATENCY_BUCKETS, t.latencySumMs);
+
+  p.histogram("ee570_loop_period_seconds", "Time between loop() passes.",
+              LOOP_BOUNDS, g_loopBucket, METRICS_LOOP_BUCKETS, g_loopSumMs);
+  p.gauge("ee570_loop_period_max_seconds", "Longest loop() pass since the previous scrape.", g_loopMaxMs / 1000.0);
+
+  p.gauge("ee570_metrics_truncated", "1 if a line longer than METRICS_CHUNK was dropped from this page.",
+          p.dropped ? 1 : 0);
+  p.flush();
+  return p.total;
+}
+
+static void sendChunk(const char* data, size_t len, void*) { g_server->sendContent(data, len); }
+
+static void handleMetrics() {
+  g_server->setContentLength(CONTENT_LENGTH_UNKNOWN);   // chunked
+  g_server->send(200, "text/plain; version=0.0.4", "");
+  metricsRender(sendChunk, nullptr);
+  g_server->sendContent("");                            // last chunk
+  g_loopMaxMs = 0;
+}
+
+static void handleNotFound() {
+  g_server->send(404, "text/plain", "not found\n");
+}
+
+void metricsBegin() {
+  uint16_t port = config().metrics_port;
+  if (!port || g_server) return;
+  g_server = new ESP8266WebServer(port);
+  g_server->on("/metrics", handleMetrics);
+  g_server->onNotFound(handleNotFound);
+  g_server->begin();
+  Serial.printf("[metrics] http://%s:%u/metrics\n", WiFi.localIP().toString().c_str(), port);
+}
+
+void metricsService() {
+  if (g_server) g_server->handleClient();
+}
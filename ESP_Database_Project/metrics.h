@@ -0,0 +1,79 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Prometheus Metrics Endpoint
+* File Name            : metrics.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Serve GET /metrics in the Prometheus text format (version 0.0.4) so a fleet
+*   can be scraped instead of read off Serial. Exported:
+*     - node info, uptime, heap (free, largest block, fragmentation), RSSI;
+*     - reading queue depth / capacity / overflows, readings captured per
+*       sensor, live levels produced;
+*     - ADC oversampling ratio, achieved burst rate and late samples
+*       (oversample.h);
+*     - Fast/Slow/Impulse/Fmax/peak levels and sampling coverage when the
+*       time-weighting stage is on (timeweight.h);
+*     - upload counters since boot (netstats.h): readings acknowledged,
+*       requests, failures, TLS handshakes, bytes measured and estimated,
+*       radio time, and an upload latency histogram;
+*     - a loop period histogram and the longest pass since the last scrape,
+*       which is what shows a blocking upload or handshake starving sampling.
+*
+* Inputs:
+*   - config().metrics_port; counters from readings.h, netstats.h,
+*     livestream.h, linkquality.h, oversample.h, timeweight.h;
+*     metricsLoopTick() / metricsReading().
+*
+* Outputs:
+*   - HTTP server on metrics_port: /metrics (200, text/plain), anything else 404.
+*
+* Example Application:
+*   metricsBegin();                 // in setup(), once Wi-Fi is up
+*   metricsLoopTick();              // first thing in loop()
+*   metricsService();               // in loop()
+*   // scrape: curl http://<node-ip>:9100/metrics
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WebServer.h>
+*   - "config.h", "readings.h", "netstats.h", "livestream.h", "linkquality.h",
+*     "oversample.h", "timeweight.h"
+*
+* Usage Notes:
+*   - The page is streamed as a chunked response through one static
+*     METRICS_CHUNK buffer, so adding metrics costs flash, not DRAM; nothing
+*     is allocated per scrape. A single line longer than the chunk is
+*     dropped and ee570_metrics_truncated is set to 1.
+*   - metricsService() handles at most one request per loop pass, between
+*     samples, so a scrape never interrupts a sound window or a ping.
+*   - "cfg set metrics_port 0" disables the server (after the next reboot).
+*   - Host test of the page format: test/test_metrics (pio test -e native).
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#define METRICS_CHUNK           512
+#define METRICS_LOOP_BUCKETS    8
+#define METRICS_LOOP_BOUNDS_MS  { 5, 10, 25, 50, 100, 250, 1000, 5000 }
+
+// Start the HTTP server if config().metrics_port is set.
+void metricsBegin();
+
+// Answer a pending scrape. Call from loop().
+void metricsService();
+
+// Record the time since the previous call as one loop period.
+void metricsLoopTick();
+
+// Count one captured reading for node READING_NODE_*.
+void metricsReading(uint8_t node);
+
+// Receives the page in pieces of at most METRICS_CHUNK bytes.
+typedef void (*MetricsSink)(const char* data, size_t len, void* ctx);
+
+// Render the page to 'sink'; returns its total length.
+size_t metricsRender(MetricsSink sink, void* ctx);
@@ -0,0 +1,337 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - MQTT Transport
+* File Name            : mqtt.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Minimal MQTT 3.1.1 client: CONNECT (persistent session), QoS1 PUBLISH with
+*   an in-flight window, PUBACK handling, keep-alive (see mqtt.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WiFi.h>
+*   - "config.h", "readings.h", "sendRequest.h", "batchcodec.h", "endpoints.h",
+*     "linkquality.h", "netstats.h", "mqtt.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include "config.h"
+#include "readings.h"
+#include "sendRequest.h"
+#include "batchcodec.h"
+#include "endpoints.h"
+#include "linkquality.h"
+#include "netstats.h"
+#include "mqtt.h"
+
+// Control packet types (upper nibble of the fixed header).
+#define MQTT_CONNECT    0x10
+#define MQTT_CONNACK    0x20
+#define MQTT_PUBLISH    0x30
+#define MQTT_PUBACK     0x40
+#define MQTT_PINGREQ    0xC0
+#define MQTT_PINGRESP   0xD0
+#define MQTT_DISCONNECT 0xE0
+
+// One in-flight batch: the next 'count' readings after the previous slots.
+struct Inflight {
+  uint16_t pid;
+  uint8_t  count;
+  bool     acked;
+  uint32_t sentMs;
+  uint16_t bytes;        // payload size, for link quality accounting
+};
+
+static WiFiClient g_tcp;
+static Inflight   g_win[MQTT_MAX_INFLIGHT];
+static uint8_t    g_winLen = 0;           // slots in use, oldest first
+static uint16_t   g_nextPid = 1;
+static uint32_t   g_lastTxMs = 0;
+static uint32_t   g_pingSentMs = 0;
+static uint32_t   g_retryAt = 0;
+static uint32_t   g_backoffMs = 0;
+static bool       g_connected = false;
+static uint8_t    g_ep = 0;               // endpoint of the current connection (endpoints.h)
+static uint32_t   g_busySince = 0;        // millis() the window became non-empty, 0 = idle
+
+uint8_t mqttInflight() { return g_winLen; }
+
+uint8_t mqttInflightReadings() {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < g_winLen; i++) n += g_win[i].count;
+  return n;
+}
+
+// ----- encoding helpers -----
+static size_t putRemLen(uint8_t* p, uint32_t len) {
+  size_t o = 0;
+  do {
+    uint8_t b = len & 0x7F;
+    len >>= 7;
+    p[o++] = len ? (b | 0x80) : b;
+  } while (len);
+  return o;
+}
+
+// All writes go through here so netstats sees every byte sent.
+static size_t put(const uint8_t* p, size_t n) {
+  size_t w = g_tcp.write(p, n);
+  netTx(w);
+  return w;
+}
+
+static void writeStr(const char* s) {
+  uint16_t n = strlen(s);
+  uint8_t h[2] = { (uint8_t)(n >> 8), (uint8_t)(n & 0xFF) };
+  put(h, 2);
+  put((const uint8_t*)s, n);
+}
+
+static String topic() {
+  return String(config().mqtt_topic) + "/" + nodeId();
+}
+
+// Read one whole packet (small packets only; larger bodies are discarded).
+// Returns the fixed-header byte, or 0 if nothing complete is available.
+static uint8_t readPacket(uint8_t* body, size_t cap, uint32_t& len) {
+  if (g_tcp.available() < 2) return 0;
+  uint8_t hdr = g_tcp.read();
+  len = 0;
+  for (uint8_t shift = 0; shift < 28; shift += 7) {
+    int b = -1;
+    uint32_t t0 = millis();
+    while ((b = g_tcp.read()) < 0 && millis() - t0 < 1000) delay(1);
+    if (b < 0) return 0;
+    len |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) break;
+  }
+  uint32_t got = 0;
+  uint32_t t0 = millis();
+  while (got < len && millis() - t0 < 2000) {
+    int b = g_tcp.read();
+    if (b < 0) { delay(1); continue; }
+    if (got < cap) body[got] = (uint8_t)b;
+    got++;
+  }
+  netRx(2 + got);   // fixed header (remaining length >= 128 is never sent to us)
+  return got == len ? hdr : 0;
+}
+
+// ----- packets -----
+static bool sendConnect() {
+  String id = "ee570-" + nodeId();
+  uint8_t fixed[5];
+  uint32_t rem = 10 + 2 + id.length();    // variable header + client ID
+  fixed[0] = MQTT_CONNECT;
+  size_t n = 1 + putRemLen(fixed + 1, rem);
+  put(fixed, n);
+  static const uint8_t vh[10] = { 0, 4, 'M', 'Q', 'T', 'T', 4,  // protocol level 3.1.1
+                                  0x00,                         // flags: CleanSession = 0
+                                  0, MQTT_KEEPALIVE_S };
+  put(vh, sizeof(vh));
+  writeStr(id.c_str());
+  g_lastTxMs = millis();
+
+  uint8_t body[4];
+  uint32_t len;
+  uint32_t t0 = millis();
+  uint8_t hdr = 0;
+  while (!(hdr = readPacket(body, sizeof(body), len)) && millis() - t0 < 5000) delay(5);
+  if ((hdr & 0xF0) != MQTT_CONNACK || len != 2 || body[1] != 0) {
+    Serial.printf("[mqtt] CONNACK failed (hdr %02x rc %d)\n", hdr, len == 2 ? body[1] : -1);
+    return false;
+  }
+  Serial.printf("[mqtt] connected, session present=%u\n", body[0] & 1);
+  return true;
+}
+
+// Publish readings [offset, offset+count) with QoS1.
+// Returns the packet size, or 0 if it could not be written.
+static size_t sendPublish(uint16_t pid, uint8_t offset, uint8_t count, bool dup, const String& tz) {
+  BatchPayload payload;
+  if (!batchPayload(offset, count, tz, payload) || !payload.length()) return 0;
+  String t = topic();
+  uint8_t fixed[5];
+  fixed[0] = MQTT_PUBLISH | (dup ? 0x08 : 0) | 0x02;      // QoS1
+  size_t n = 1 + putRemLen(fixed + 1, 2 + t.length() + 2 + payload.length());
+  put(fixed, n);
+  writeStr(t.c_str());
+  uint8_t id[2] = { (uint8_t)(pid >> 8), (uint8_t)(pid & 0xFF) };
+  put(id, 2);
+  size_t w = put(payload.data(), payload.length());
+  g_lastTxMs = millis();
+  return w == payload.length() ? n + 2 + t.length() + 2 + w : 0;
+}
+
+// Close the connection and charge 'result' to its endpoint. If that moves
+// uploads to another endpoint, reconnect there without the back-off.
+static void dropConnection(const char* why, EndpointResult result) {
+  if (g_connected) Serial.printf("[mqtt] disconnect: %s\n", why);
+  g_tcp.stop();
+  if (g_busySince) { netRadio(millis() - g_busySince); g_busySince = 0; }
+  g_connected = false;
+  if (result != ENDPOINT_OK) endpointReport(g_ep, result, 0);
+  if (endpointPick() != g_ep) {
+    g_backoffMs = 0;
+    g_retryAt = millis();
+    return;
+  }
+  g_backoffMs = g_backoffMs ? min<uint32_t>(g_backoffMs * 2, 60000UL) : 1000UL;
+  g_retryAt = millis() + g_backoffMs;
+}
+
+static bool ensureConnected(const String& tz) {
+  if (g_connected && g_tcp.connected()) return true;
+  if (g_connected) dropConnection("socket closed", ENDPOINT_FAILED);
+  if ((long)(millis() - g_retryAt) < 0) return false;
+
+  g_ep = endpointPick();
+  String host; uint16_t port;
+  if (!endpointHostPort(endpointBase(g_ep), host, port)) return false;
+
+  uint32_t t0 = millis();
+  bool tcpOk = g_tcp.connect(host.c_str(), port);
+  if (tcpOk) g_tcp.setNoDelay(true);
+  bool ok = tcpOk && sendConnect();
+  netRadio(millis() - t0);
+  if (!tcpOk) { dropConnection("connect failed", ENDPOINT_UNREACHABLE); return false; }
+  if (!ok) { dropConnection("CONNECT rejected", ENDPOINT_FAILED); return false; }
+  endpointReport(g_ep, ENDPOINT_OK, millis() - t0);
+  Serial.printf("[mqtt] broker #%u %s\n", g_ep, endpointBase(g_ep));
+  g_connected = true;
+  g_backoffMs = 0;
+  g_pingSentMs = 0;
+
+  // Persistent session: re-send everything not yet acknowledged, same IDs, DUP set.
+  uint8_t offset = 0;
+  for (uint8_t i = 0; i < g_winLen; i++) {
+    if (!g_win[i].acked) {
+      g_win[i].bytes = (uint16_t)sendPublish(g_win[i].pid, offset, g_win[i].count, true, tz);
+      g_win[i].sentMs = millis();
+    }
+    offset += g_win[i].count;
+  }
+  if (g_winLen) g_busySince = millis();
+  return true;
+}
+
+// Drop acknowledged batches from the window front (and their readings).
+static void retireAcked() {
+  uint8_t k = 0;
+  while (k < g_winLen && g_win[k].acked) {
+    readingDrop(g_win[k].count);
+    netReadings(g_win[k].count);
+    k++;
+  }
+  if (!k) return;
+  memmove(g_win, g_win + k, (g_winLen - k) * sizeof(Inflight));
+  g_winLen -= k;
+  readingPin(mqttInflightReadings());
+  if (g_winLen == 0 && g_busySince) { netRadio(millis() - g_busySince); g_busySince = 0; }
+}
+
+static void pollIncoming() {
+  uint8_t body[4];
+  uint32_t len;
+  uint8_t hdr;
+  while ((hdr = readPacket(body, sizeof(body), len)) != 0) {
+    switch (hdr & 0xF0) {
+      case MQTT_PUBACK: {
+        if (len < 2) break;
+        uint16_t pid = ((uint16_t)body[0] << 8) | body[1];
+        for (uint8_t i = 0; i < g_winLen; i++) {
+          if (g_win[i].pid != pid || g_win[i].acked) continue;
+          g_win[i].acked = true;
+          uint32_t rtt = millis() - g_win[i].sentMs;
+          endpointReport(g_ep, ENDPOINT_OK, rtt);
+          linkReportUpload(g_win[i].bytes, g_win[i].count, rtt, true);
+          netRequest(true, rtt);
+        }
+        break;
+      }
+      case MQTT_PINGRESP:
+        g_pingSentMs = 0;
+        break;
+      default:
+        break;   // nothing subscribed; ignore anything else
+    }
+  }
+  retireAcked();
+}
+
+void mqttService(const String& tz, bool flushPartial) {
+  if (!ensureConnected(tz)) return;
+  pollIncoming();
+
+  uint32_t now = millis();
+  // A missing PUBACK means the connection is suspect: reconnect and resend.
+  for (uint8_t i = 0; i < g_winLen; i++) {
+    if (!g_win[i].acked && now - g_win[i].sentMs > MQTT_ACK_TIMEOUT_MS) {
+      linkReportUpload(g_win[i].bytes, g_win[i].count, now - g_win[i].sentMs, false);
+      netRequest(false, now - g_win[i].sentMs);
+      dropConnection("PUBACK timeout", ENDPOINT_FAILED);
+      return;
+    }
+  }
+  if (g_pingSentMs && now - g_pingSentMs > MQTT_KEEPALIVE_S * 1000UL) {
+    dropConnection("PINGRESP timeout", ENDPOINT_FAILED);
+    return;
+  }
+
+  // Another broker became the better endpoint: move once nothing is in flight
+  // here (a persistent session does not follow us to a different broker).
+  if (g_winLen == 0 && endpointPick() != g_ep) {
+    dropConnection("switching endpoint", ENDPOINT_OK);
+    return;
+  }
+
+  // Fill the window from readings not yet in flight.
+  const uint8_t batch = linkBatchSize();
+  while (g_winLen < MQTT_MAX_INFLIGHT) {
+    uint8_t offset = mqttInflightReadings();
+    uint8_t pending = readingCount() - offset;
+    if (pending == 0 || (pending < batch && !flushPartial)) break;
+    uint8_t count = min(pending, batch);
+    uint8_t ready = readingSequenced(offset + count);   // sequence bound not saved yet
+    if (ready <= offset) break;
+    count = ready - offset;
+
+    Inflight& f = g_win[g_winLen];
+    f.pid = g_nextPid++;
+    if (g_nextPid == 0) g_nextPid = 1;    // packet ID 0 is reserved
+    f.count = count;
+    f.acked = false;
+    f.sentMs = millis();
+    if (g_winLen == 0) g_busySince = f.sentMs;
+    g_winLen++;
+    readingPin(mqttInflightReadings());
+    f.bytes = (uint16_t)sendPublish(f.pid, offset, count, false, tz);
+    if (!f.bytes) { dropConnection("write failed", ENDPOINT_FAILED); return; }
+    Serial.printf("[mqtt] publish pid %u: %u readings, trace %s (%u in flight)\n", f.pid, count,
+                  traceId(readingAt(offset).seq).c_str(), g_winLen);
+  }
+
+  // Keep-alive: ping when idle for half the interval.
+  if (!g_pingSentMs && now - g_lastTxMs > MQTT_KEEPALIVE_S * 500UL) {
+    uint8_t ping[2] = { MQTT_PINGREQ, 0 };
+    put(ping, 2);
+    g_lastTxMs = g_pingSentMs = now;
+  }
+}
+
+bool mqttPublishAux(const char* suffix, const uint8_t* data, size_t len) {
+  if (!g_connected || !g_tcp.connected()) return false;
+  String t = topic() + "/" + suffix;
+  uint8_t fixed[5];
+  fixed[0] = MQTT_PUBLISH;                                 // QoS0, no packet ID
+  size_t n = 1 + putRemLen(fixed + 1, 2 + t.length() + len);
+  put(fixed, n);
+  writeStr(t.c_str());
+  bool ok = put(data, len) == len;
+  g_lastTxMs = millis();
+  return ok;
+}
@@ -0,0 +1,65 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - MQTT Transport
+* File Name            : mqtt.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Publish queued readings to an MQTT 3.1.1 broker over one long-lived TCP
+*   connection. Batches go out as QoS1 PUBLISHes to <mqtt_topic>/<nodeId> with up
+*   to MQTT_MAX_INFLIGHT unacknowledged at once, so throughput is not bounded by
+*   one round trip per batch. The session is persistent (CleanSession = 0):
+*   after a reconnect every unacknowledged batch is re-sent with DUP set.
+*
+* Inputs:
+*   - Reading queue (readings.h); config().server_base = "mqtt://host[:port]"
+*     (plus optional server_alt0/1 brokers, chosen by endpoints.h).
+*
+* Outputs:
+*   - PUBLISH packets; readings are dropped from the queue only once PUBACKed.
+*   - mqttPublishAux(): QoS0 side-channel records to <mqtt_topic>/<nodeId>/<suffix>
+*     (e.g. "net" upload statistics, netstats.h).
+*
+* Example Application:
+*   // in loop(), when config().transport == TRANSPORT_MQTT
+*   mqttService(tzRegion, oldestReadingIsDue);
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <ESP8266WiFi.h>
+*   - "config.h", "readings.h", "sendRequest.h" (nodeId)
+*
+* Usage Notes:
+*   - In-flight batches are not copied: they reference the front of the reading
+*     queue and are re-encoded on resend, so the window costs a few bytes of RAM.
+*   - A batch without PUBACK after MQTT_ACK_TIMEOUT_MS forces a reconnect, which
+*     triggers the resend (MQTT 3.1.1 only allows resending on a new connection).
+*   - Payloads follow batch_format (batchcodec.h); a binary payload starts with
+*     BATCH_MAGIC, which can never begin a form body.
+*   - In-flight readings are pinned in the queue (readingPin) so an overflow
+*     discards unsent readings instead of ones the broker may already hold.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#define MQTT_DEFAULT_PORT    1883
+#define MQTT_MAX_INFLIGHT    4         // QoS1 window (batches)
+#define MQTT_KEEPALIVE_S     60
+#define MQTT_ACK_TIMEOUT_MS  10000UL
+
+// Keep the connection alive, process PUBACKs and publish ready batches.
+// flushPartial: also publish a batch smaller than linkBatchSize() (oldest is due).
+void mqttService(const String& tzRegion, bool flushPartial);
+
+// Batches currently waiting for PUBACK.
+uint8_t mqttInflight();
+
+// Readings covered by in-flight batches (they sit at the queue front).
+uint8_t mqttInflightReadings();
+
+// Publish 'data' once with QoS0 to <mqtt_topic>/<nodeId>/<suffix> if the
+// connection is up. Fire-and-forget: nothing is queued or retried.
+bool mqttPublishAux(const char* suffix, const uint8_t* data, size_t len);
@@ -0,0 +1,178 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Upload Bandwidth and Radio-Time Accounting
+* File Name            : netstats.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Per-interval upload counters, the history ring and their Serial report
+*   (see netstats.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "netstats.h", "config.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <time.h>
+#include "config.h"
+#include "netstats.h"
+
+static NetRecord g_cur;                   // running interval
+static uint32_t  g_startMs;
+static bool      g_started = false;
+static NetRecord g_hist[NET_HISTORY];     // closed intervals, oldest first
+static uint8_t   g_histLen = 0;
+static NetTotals g_tot;                   // since boot
+static const uint16_t LATENCY_BOUNDS[NET_LATENCY_BUCKETS] = NET_LATENCY_BOUNDS_MS;
+
+// Saturating add for the 16-bit counters.
+static inline uint16_t sat16(uint16_t c, uint32_t n) { return (uint16_t)min<uint32_t>((uint32_t)c + n, UINT16_MAX); }
+
+static void start() {
+  memset(&g_cur, 0, sizeof(g_cur));
+  time_t now = time(nullptr);
+  g_cur.startEpoch = now > 1000000000 ? (uint32_t)now : 0;   // 0 until SNTP has set the clock
+  g_startMs = millis();
+  g_started = true;
+}
+
+static NetRecord& cur() {
+  if (!g_started) start();
+  return g_cur;
+}
+
+void netTx(size_t bytes) { cur().txBytes += bytes; g_tot.txBytes += bytes; }
+void netRx(size_t bytes) { cur().rxBytes += bytes; g_tot.rxBytes += bytes; }
+
+void netEstimate(size_t txBytes, size_t rxBytes) {
+  cur().ovhTxEst += txBytes;
+  g_cur.ovhRxEst += rxBytes;
+  g_tot.ovhTxEst += txBytes;
+  g_tot.ovhRxEst += rxBytes;
+}
+
+void netRequest(bool ok, uint32_t latencyMs) {
+  NetRecord& r = cur();
+  r.requests = sat16(r.requests, 1);
+  g_tot.requests++;
+  if (!ok) { r.failures = sat16(r.failures, 1); g_tot.failures++; }
+  uint8_t b = 0;
+  while (b < NET_LATENCY_BUCKETS && latencyMs > LATENCY_BOUNDS[b]) b++;
+  g_tot.latencyBucket[b]++;
+  g_tot.latencySumMs += latencyMs;
+}
+
+void netRadio(uint32_t ms) { cur().radioMs += ms; g_tot.radioMs += ms; }
+
+void netHandshake() {
+  NetRecord& r = cur();
+  r.handshakes = sat16(r.handshakes, 1);
+  g_tot.handshakes++;
+  netEstimate(NET_TLS_HS_TX_EST, NET_TLS_HS_RX_EST);
+}
+
+void netHttp(size_t txBody, size_t rxBody, bool tls, bool handshake, int httpCode, uint32_t ms) {
+  bool answered = httpCode > 0;
+  netTx(txBody);
+  netRx(rxBody);
+  size_t tx = NET_HTTP_REQ_HDR_EST + txBody;
+  size_t rx = answered ? NET_HTTP_RESP_HDR_EST + rxBody : 0;
+  netEstimate(NET_HTTP_REQ_HDR_EST, answered ? NET_HTTP_RESP_HDR_EST : 0);
+  if (tls) {
+    // Output goes out in records of at most NET_TLS_RECORD_TX bytes; the
+    // response usually fits one record (plus the close_notify alert).
+    netEstimate((tx + NET_TLS_RECORD_TX - 1) / NET_TLS_RECORD_TX * NET_TLS_RECORD_EST,
+                rx ? 2 * NET_TLS_RECORD_EST : 0);
+    if (handshake) netHandshake();
+  }
+  netRequest(httpCode >= 200 && httpCode < 300, ms);
+  netRadio(ms);
+}
+
+void netReadings(uint16_t n) {
+  NetRecord& r = cur();
+  r.readings = sat16(r.readings, n);
+  g_tot.readings += n;
+}
+
+const NetTotals& netTotals() { return g_tot; }
+
+NetRecord netCurrent() {
+  NetRecord r = cur();
+  r.transport = config().transport;
+  r.seconds = (uint16_t)min<uint32_t>((millis() - g_startMs) / 1000, UINT16_MAX);
+  return r;
+}
+
+// "[net] 300 s: 30 readings, 4 req (0 failed, 4 TLS), 2210/1040 B + ~1950/13500 B est, radio 3120 ms"
+static void logRecord(const char* label, const NetRecord& r) {
+  Serial.printf("[net] %s %u s: %u readings, %u req (%u failed, %u TLS), %lu/%lu B + ~%lu/%lu B est, radio %lu ms\n",
+                label, r.seconds, r.readings, r.requests, r.failures, r.handshakes,
+                (unsigned long)r.txBytes, (unsigned long)r.rxBytes,
+                (unsigned long)r.ovhTxEst, (unsigned long)r.ovhRxEst, (unsigned long)r.radioMs);
+  if (r.readings)
+    Serial.printf("[net]   per reading: %.1f B (%.1f B incl. est), %.2f req, %.0f ms radio\n",
+                  (float)(r.txBytes + r.rxBytes) / r.readings,
+                  (float)(r.txBytes + r.rxBytes + r.ovhTxEst + r.ovhRxEst) / r.readings,
+                  (float)r.requests / r.readings, (float)r.radioMs / r.readings);
+}
+
+bool netService(NetRecord& closed) {
+  cur();
+  if (millis() - g_startMs < NET_INTERVAL_MS) return false;
+  closed = netCurrent();
+  if (g_histLen == NET_HISTORY) {
+    memmove(g_hist, g_hist + 1, (NET_HISTORY - 1) * sizeof(NetRecord));
+    g_histLen--;
+  }
+  g_hist[g_histLen++] = closed;
+  logRecord("interval", closed);
+  start();
+  return true;
+}
+
+static uint8_t* put16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  return p + 2;
+}
+
+static uint8_t* put32(uint8_t* p, uint32_t v) {
+  for (uint8_t i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+  return p + 4;
+}
+
+size_t netEncode(const NetRecord& r, uint8_t* out) {
+  uint8_t* p = out;
+  *p++ = NET_RECORD_VERSION;
+  *p++ = r.transport;
+  p = put16(p, r.seconds);
+  p = put32(p, r.startEpoch);
+  p = put16(p, r.readings);
+  p = put16(p, r.requests);
+  p = put16(p, r.failures);
+  p = put16(p, r.handshakes);
+  p = put32(p, r.txBytes);
+  p = put32(p, r.rxBytes);
+  p = put32(p, r.ovhTxEst);
+  p = put32(p, r.ovhRxEst);
+  p = put32(p, r.radioMs);
+  return p - out;
+}
+
+void netPrint() {
+  logRecord("running", netCurrent());
+  if (!g_histLen) return;
+  Serial.println(F("[net] start      s  rdg  req fail tls    tx B    rx B  est tx  est rx  radio ms"));
+  for (uint8_t i = 0; i < g_histLen; i++) {
+    const NetRecord& r = g_hist[i];
+    Serial.printf("      %10lu %4u %4u %4u %4u %3u %7lu %7lu %7lu %7lu %9lu\n",
+                  (unsigned long)r.startEpoch, r.seconds, r.readings, r.requests, r.failures, r.handshakes,
+                  (unsigned long)r.txBytes, (unsigned long)r.rxBytes,
+                  (unsigned long)r.ovhTxEst, (unsigned long)r.ovhRxEst, (unsigned long)r.radioMs);
+  }
+}
@@ -0,0 +1,158 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Upload Bandwidth and Radio-Time Accounting
+* File Name            : netstats.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Count what uploads cost and report it per interval (NET_INTERVAL_MS):
+*     - txBytes / rxBytes: bytes the firmware itself wrote and read, exact
+*       (HTTP bodies, whole CoAP datagrams incl. retransmits, whole MQTT packets);
+*     - ovhTxEst / ovhRxEst: what the stack adds out of our sight, estimated
+*       (HTTP request/response headers, TLS handshakes and record framing);
+*     - requests / failures: upload exchanges (HTTP POSTs, CoAP POSTs, MQTT
+*       publishes) and those that were not acknowledged;
+*     - handshakes: completed TLS handshakes (no session resumption here, so
+*       every HTTPS request pays one);
+*     - readings: readings the server acknowledged;
+*     - radioMs: time with upload traffic outstanding (request start to
+*       response; MQTT: connecting, or publishes waiting for PUBACK).
+*   From these: bytes per reading, requests per reading, radio ms per reading.
+*
+* Inputs:
+*   - netTx/netRx/netEstimate/netRequest/netRadio/netHandshake from the
+*     transports (sendRequest.cpp, coap.cpp, mqtt.cpp), netReadings() from the
+*     code that drops acknowledged readings.
+*
+* Outputs:
+*   - NetRecord: counters of one closed interval, kept in a RAM ring of
+*     NET_HISTORY; one "[net]" log line per interval.
+*   - netEncode(): a NetRecord as the NET_WIRE_SIZE-byte wire record below.
+*   - NetTotals: the same counters since boot plus an upload latency
+*     histogram (NET_LATENCY_BOUNDS_MS), for the /metrics page (metrics.h).
+*   - netPrint(): running interval and history on Serial.
+*
+* Example Application:
+*   NetRecord rec;
+*   uint8_t wire[NET_WIRE_SIZE];
+*   if (netService(rec)) mqttPublishAux("net", wire, netEncode(rec, wire));
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "config.h" (transport)
+*
+* Usage Notes:
+*   - BearSSL and lwIP expose no per-socket byte counters, so header and TLS
+*     bytes use the NET_*_EST constants below; they are kept apart from the
+*     measured counters so the estimate never hides in the exact numbers.
+*   - radioMs is a proxy: the modem also wakes for beacons and DHCP/ARP, which
+*     are not uploads and are not counted.
+*   - "net" on the Serial console prints the counters.
+*   - Wire record, version 1 (NET_RECORD_VERSION), 36 bytes, every field
+*     little-endian and written one by one, so it does not depend on the
+*     struct's layout or the compiler's padding:
+*       off  size  field
+*        0    1    version (1)
+*        1    1    transport (TRANSPORT_*, config.h)
+*        2    2    seconds
+*        4    4    startEpoch
+*        8    2    readings
+*       10    2    requests
+*       12    2    failures
+*       14    2    handshakes
+*       16    4    txBytes
+*       20    4    rxBytes
+*       24    4    ovhTxEst
+*       28    4    ovhRxEst
+*       32    4    radioMs
+*     A new field means a new version; readers reject versions they do not
+*     know (server/mqtt_standin.py).
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#define NET_INTERVAL_MS          300000UL   // one record per 5 minutes
+#define NET_HISTORY              12         // closed records kept in RAM (1 h)
+#define NET_RECORD_VERSION       1          // first byte of the wire record
+#define NET_WIRE_SIZE            36         // bytes netEncode() writes
+
+// Estimates for bytes the stack sends on our behalf.
+#define NET_HTTP_REQ_HDR_EST     220        // request line, Host, User-Agent, Content-*, Connection
+#define NET_HTTP_RESP_HDR_EST    180        // status line and a typical PHP/nginx header set
+#define NET_TLS_HS_TX_EST        330        // ClientHello (SNI) + key exchange + Finished
+#define NET_TLS_HS_RX_EST        3300       // ServerHello + certificate chain + Finished
+#define NET_TLS_RECORD_EST       29         // header + explicit nonce + GCM tag per record
+#define NET_TLS_RECORD_TX        512        // BearSSL client output buffer = records of <= 512 B
+
+// Upload latency histogram: upper bounds (ms) of the finite buckets.
+#define NET_LATENCY_BUCKETS      8
+#define NET_LATENCY_BOUNDS_MS    { 100, 250, 500, 1000, 2500, 5000, 10000, 30000 }
+
+struct NetRecord {
+  uint8_t  transport;     // config().transport when the interval closed
+  uint16_t seconds;       // interval length
+  uint32_t startEpoch;    // UTC start, 0 if the clock was not set
+  uint16_t readings;      // readings acknowledged by the server
+  uint16_t requests;      // upload exchanges, retries included
+  uint16_t failures;      // exchanges not acknowledged
+  uint16_t handshakes;    // completed TLS handshakes
+  uint32_t txBytes;       // measured: bytes written by the firmware
+  uint32_t rxBytes;       // measured: bytes read by the firmware
+  uint32_t ovhTxEst;      // estimated: header / TLS bytes sent
+  uint32_t ovhRxEst;      // estimated: header / TLS bytes received
+  uint32_t radioMs;       // time with upload traffic outstanding
+};
+
+// Counters since boot (never reset; 32-bit, so they wrap like any counter).
+struct NetTotals {
+  uint32_t readings, requests, failures, handshakes;
+  uint32_t txBytes, rxBytes, ovhTxEst, ovhRxEst;
+  uint32_t radioMs;
+  uint32_t latencyBucket[NET_LATENCY_BUCKETS + 1];   // per bucket (not cumulative); last = above all bounds
+  uint32_t latencySumMs;
+};
+
+// Measured application bytes.
+void netTx(size_t bytes);
+void netRx(size_t bytes);
+
+// Estimated bytes added by the stack.
+void netEstimate(size_t txBytes, size_t rxBytes);
+
+// One upload exchange finished; ok = acknowledged by the server.
+// latencyMs: request to response (or to giving up).
+void netRequest(bool ok, uint32_t latencyMs);
+
+// Time spent with upload traffic outstanding.
+void netRadio(uint32_t ms);
+
+// One full TLS handshake (counts it and adds its estimated bytes).
+void netHandshake();
+
+// Account one HTTP(S) exchange: measured bodies plus estimated headers, TLS
+// record framing and, if 'handshake', a handshake. Also counts the request
+// (ok = 2xx) and its radio time.
+void netHttp(size_t txBody, size_t rxBody, bool tls, bool handshake, int httpCode, uint32_t ms);
+
+// Readings acknowledged by the server.
+void netReadings(uint16_t n);
+
+// Close the interval when it is due. Returns true with the closed record.
+// Call from loop().
+bool netService(NetRecord& closed);
+
+// Counters of the running interval (seconds = elapsed so far).
+NetRecord netCurrent();
+
+// Counters since boot.
+const NetTotals& netTotals();
+
+// Serialize r into out (NET_WIRE_SIZE bytes, layout above). Returns NET_WIRE_SIZE.
+size_t netEncode(const NetRecord& r, uint8_t* out);
+
+// Running interval and history on Serial.
+void netPrint();
@@ -0,0 +1,128 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Oversampling CIC Front End
+* File Name            : oversample.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Paced burst sampling, CIC + FIR decimation per window and the
+*   compensation tap table (see oversample.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "oversample.h", "sampling.h" (AdcScaleMic), "config.h", "adccal.h"
+*   - "bias.h" (windows are centred on the tracked bias and update it)
+*   - "timeweight.h" (decimated samples feed the F/S/I stage)
+*   - "quality.h" (raw samples feed the window's clip / stuck / jitter checks)
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include "config.h"
+#include "sampling.h"
+#include "oversample.h"
+#include "timeweight.h"
+#include "adccal.h"
+#include "bias.h"
+#include "quality.h"
+
+const int16_t COMP_TAPS_Q15[OVERSAMPLE_MAX_LOG2][4] = {
+  { 23996, 9105, -5965, 1246 },   // R = 2
+  { 24738, 9112, -6501, 1404 },   // R = 4
+  { 24926, 9114, -6638, 1445 },   // R = 8
+  { 24976, 9114, -6673, 1455 },   // R = 16
+};
+
+static OversampleStats g_stats;
+
+// Q13 volts per nominal ADC count, to report crude dB in count units.
+static const float Q13_PER_COUNT = AdcScaleMic::kVoltsPerCount * (1 << ADC_VOLTS_FRAC);
+
+template <uint8_t LogR>
+static OversampleAcc window(uint8_t pin, uint16_t n, uint32_t fs) {
+  CicDecimator<LogR> cic;
+  CicCompensator fir;
+  cic.reset();
+  fir.reset(LogR);
+  OversampleAcc a = { 0, 0, 0, n };
+
+  const uint32_t inputHz = fs << LogR;
+  const uint32_t gap = ESP.getCpuFreqMHz() * 1000000UL / inputHz;   // cycles per input
+  uint32_t late = 0;
+  uint16_t skip = OVERSAMPLE_WARMUP;
+  uint32_t startUs = micros();
+  uint32_t next = ESP.getCycleCount();
+  const int32_t mid = biasVoltsQ13();
+  TimeWeighter* tw = twWindow();
+  QualityAcc q;
+  qualityBegin(q);
+  for (uint16_t got = 0; got < n;) {
+    while ((int32_t)(ESP.getCycleCount() - next) < 0) {}
+    uint16_t raw = analogRead(pin);
+    qualitySample(q, raw);
+    biasTrack(raw);
+    int32_t x = adcVoltsQ13(raw) - mid;
+    uint32_t now = ESP.getCycleCount();
+    next += gap;
+    if ((int32_t)(now - next) > 0) { late++; next = now; }   // behind: run back to back
+    int32_t y;
+    if (!cic.push(x, y)) continue;
+    y = fir.step(y);
+    if (skip) { skip--; continue; }
+    twPush(tw, y + mid);                // same offset as raw samples
+    a.sum += y;
+    a.absSum += (uint32_t)abs(y);
+    a.sumSq += (uint64_t)((int64_t)y * y);
+    got++;
+  }
+  twWindowEnd(tw, n);
+  qualitySoundWindow(q);
+  uint32_t us = max<uint32_t>(micros() - startUs, 1);
+  uint32_t inputs = ((uint32_t)n + OVERSAMPLE_WARMUP) << LogR;
+  uint32_t achieved = (uint32_t)((uint64_t)inputs * 1000000ULL / us);
+
+  if (g_stats.ratio != (1 << LogR) || g_stats.requestedHz != inputHz)
+    Serial.printf("[adc] oversample x%u: %lu S/s requested, %lu S/s achieved\n",
+                  1 << LogR, (unsigned long)inputHz, (unsigned long)achieved);
+  g_stats.ratio = 1 << LogR;
+  g_stats.requestedHz = inputHz;
+  g_stats.inputHz = achieved;
+  g_stats.late += late;
+  g_stats.windows++;
+  return a;
+}
+
+OversampleAcc oversampleWindow(uint8_t pin, uint16_t n, uint32_t fs, uint8_t logR) {
+  switch (logR) {
+    case 1:  return window<1>(pin, n, fs);
+    case 2:  return window<2>(pin, n, fs);
+    case 3:  return window<3>(pin, n, fs);
+    default: return window<4>(pin, n, fs);
+  }
+}
+
+float oversampleCrudeDb(const OversampleAcc& a) {
+  float level = (float)a.absSum / ((float)a.n * Q13_PER_COUNT);
+  float db = 20.0f * log10f(max(level, 1.0f));
+  if (!isfinite(db)) db = 0.0f;
+  return db;
+}
+
+float oversampleRmsVolts(const OversampleAcc& a) {
+  // var = (n*sumSq - sum^2) / n^2, in Q26 volts^2
+  int64_t sum = a.sum;
+  uint64_t nSq = (uint64_t)a.n * a.sumSq;
+  uint64_t sq  = (uint64_t)(sum * sum);
+  uint64_t d   = nSq > sq ? nSq - sq : 0;
+  return sqrtf((float)d) / a.n / (1 << ADC_VOLTS_FRAC);
+}
+
+float readSoundDbOversampled(const NodeConfig& cfg, uint16_t n) {
+  uint8_t logR = 0;
+  while ((1u << (logR + 1)) <= cfg.oversample && logR < OVERSAMPLE_MAX_LOG2) logR++;
+  return oversampleCrudeDb(oversampleWindow(cfg.pin_sound, n, cfg.target_fs, logR));
+}
+
+const OversampleStats& oversampleStats() { return g_stats; }
@@ -0,0 +1,145 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Oversampling CIC Front End
+* File Name            : oversample.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Sample A0 at R x target_fs (R = config().oversample) and decimate back to
+*   target_fs through a 3-stage CIC filter and a 7-tap compensation FIR. The
+*   MAX4466 only reaches A0 through the 100k/47k divider, so small signals
+*   span a handful of ADC counts; averaging R samples per output adds up to
+*   log2(R)/2 effective bits, and the CIC nulls at multiples of target_fs
+*   reject what the plain paced loop would alias into the band.
+*     - CIC: integer adds only (3 per input, 3 per output), modulo-2^32
+*       arithmetic, gain R^3 removed by a shift. Each input is looked up in
+*       the ADC table (adccal.h) first, so the filters run on calibrated Q13
+*       volts (~1/26 ADC step) and the extra resolution survives.
+*     - FIR: symmetric, Q15 taps fitted per R to the inverse of the CIC droop;
+*       flat to +/-0.21 dB up to 0.2 x target_fs, -22 dB at target_fs / 2.
+*
+* Inputs:
+*   - config().pin_sound, target_fs, oversample; window length n.
+*
+* Outputs:
+*   - OversampleAcc: sum, sum of |y| and sum of squares of n decimated samples (Q13
+*     volts, centred on the tracked bias, bias.h), turned into the same crude dB / RMS volts
+*     values as SoundPipeline (sampling.h).
+*   - oversampleStats(): achieved input rate and late samples of the last window.
+*
+* Example Application:
+*   // cfg set oversample 8
+*   float db = readSoundDbOversampled(config(), config().samples);
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "config.h", "adccal.h"
+*
+* Usage Notes:
+*   - Filter cost is fixed per input sample (see the CIC/FIR rows of the
+*     sampling benchmark); the ADC read itself dominates.
+*   - A window takes R times as long as the plain loop. analogRead() tops out
+*     near 10 kS/s with Wi-Fi up, so a burst asked to run faster falls behind:
+*     samples are then taken back to back, the output rate drops to the
+*     achieved rate / R and the shortfall shows up in oversampleStats() and on
+*     /metrics. Pick R so that R x target_fs stays within what the ADC delivers.
+*   - oversample = 1 keeps the original paced loop (sampling.h) bit for bit.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "adccal.h"
+
+#define OVERSAMPLE_MAX_LOG2   4        // R up to 16
+#define CIC_STAGES            3
+#define COMP_TAPS             7
+#define OVERSAMPLE_WARMUP     (CIC_STAGES + COMP_TAPS)   // outputs dropped while the filters fill
+
+// Compensation FIR taps h0 (centre), h1, h2, h3 in Q15 for R = 2, 4, 8, 16.
+// Least-squares fit of 1 / CIC droop over 0..0.2 fs_out with a light
+// 0.35..0.5 fs_out stopband weight; DC gain exactly 1.
+extern const int16_t COMP_TAPS_Q15[OVERSAMPLE_MAX_LOG2][4];
+
+// ================== CIC decimator ==================
+// LogR: log2 of the decimation ratio (1..OVERSAMPLE_MAX_LOG2).
+template <uint8_t LogR>
+struct CicDecimator {
+  static_assert(LogR >= 1 && LogR <= OVERSAMPLE_MAX_LOG2, "decimation ratio out of range");
+  static constexpr uint8_t kRatio = 1 << LogR;
+  // R^3 gain removed by a rounding shift of 3*log2(R).
+  static constexpr int kDown = CIC_STAGES * LogR;
+
+  uint32_t integ[CIC_STAGES];
+  uint32_t comb[CIC_STAGES];
+  uint8_t  phase;
+
+  void reset() { memset(this, 0, sizeof(*this)); }
+
+  static inline int32_t scale(int32_t v) { return (v + (1 << (kDown - 1))) >> kDown; }
+
+  // Feed one centred Q13 sample; every kRatio-th call returns true with the
+  // decimated sample (Q13) in 'out'. Wrap-around in the integrators is
+  // harmless: the combs take differences modulo 2^32.
+  inline bool push(int32_t x, int32_t& out) {
+    uint32_t v = (uint32_t)x;
+    for (uint8_t s = 0; s < CIC_STAGES; s++) { integ[s] += v; v = integ[s]; }
+    if (++phase < kRatio) return false;
+    phase = 0;
+    for (uint8_t s = 0; s < CIC_STAGES; s++) { uint32_t d = v - comb[s]; comb[s] = v; v = d; }
+    out = scale((int32_t)v);
+    return true;
+  }
+};
+
+// ================== Compensation FIR ==================
+struct CicCompensator {
+  const int16_t* h;              // COMP_TAPS_Q15[LogR - 1]
+  int32_t x[COMP_TAPS];          // newest first
+
+  void reset(uint8_t logR) { memset(x, 0, sizeof(x)); h = COMP_TAPS_Q15[logR - 1]; }
+
+  // One Q13 sample in, one Q13 sample out (3-sample group delay). The sum
+  // is 64-bit: a calibrated table may reach 8 V, past 32 bits with Q15 taps.
+  inline int32_t step(int32_t in) {
+    memmove(x + 1, x, (COMP_TAPS - 1) * sizeof(x[0]));
+    x[0] = in;
+    int64_t acc = (int64_t)h[0] * x[3] + (int64_t)h[1] * (x[2] + x[4]) +
+                  (int64_t)h[2] * (x[1] + x[5]) + (int64_t)h[3] * (x[0] + x[6]);
+    return (int32_t)((acc + (1 << 14)) >> 15);
+  }
+};
+
+// ================== Window ==================
+struct OversampleAcc {
+  int32_t  sum;      // Q13 volts, centred on biasVoltsQ13() at window start
+  uint32_t absSum;   // sum of |y|, Q13 volts
+  uint64_t sumSq;    // Q26
+  uint16_t n;
+};
+
+struct OversampleStats {
+  uint8_t  ratio;        // R of the last window (0 = none yet)
+  uint32_t inputHz;      // achieved ADC rate
+  uint32_t requestedHz;  // R x target_fs
+  uint32_t late;         // samples taken after their slot (ADC or interrupts too slow), since boot
+  uint32_t windows;      // oversampled windows since boot
+};
+
+// One window of n decimated samples from 'pin' at fs, oversampled by 2^logR.
+OversampleAcc oversampleWindow(uint8_t pin, uint16_t n, uint32_t fs, uint8_t logR);
+
+// read_sensor_2() semantics on the decimated stream: mean |y| around the
+// tracked bias, in counts -> 20*log10, floor at 0 dB.
+float oversampleCrudeDb(const OversampleAcc& a);
+
+// AC RMS of the decimated stream in mic-side volts.
+float oversampleRmsVolts(const OversampleAcc& a);
+
+// Crude dB over an n-sample window using config().oversample.
+float readSoundDbOversampled(const NodeConfig& cfg, uint16_t n);
+
+const OversampleStats& oversampleStats();
@@ -0,0 +1,105 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Signal Quality Monitor
+* File Name            : quality.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Per-window flag evaluation, echo history and counters (see quality.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "quality.h", "config.h", "readings.h", "bias.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include "config.h"
+#include "readings.h"
+#include "bias.h"
+#include "quality.h"
+
+const char* const QUALITY_NAMES[QUALITY_FLAG_COUNT] = {
+  "clip", "stuck", "bias", "jitter", "no_echo", "echo_rate", "near"
+};
+
+static QualityWindow g_latest = {};
+static QualityStats  g_stats = {};
+static uint16_t      g_echoBits = 0;     // last 16 pings, 1 = timed out
+static uint8_t       g_pingsSeen = 0;    // up to 16
+static uint8_t       g_pendingSound = 0, g_pendingUltra = 0;
+
+static void count(uint8_t flags) {
+  for (uint8_t b = 0; b < QUALITY_FLAG_COUNT; b++)
+    if (flags & (1 << b)) g_stats.flagged[b]++;
+}
+
+uint8_t qualitySoundWindow(const QualityAcc& q) {
+  QualityWindow w = {};
+  w.samples = q.n;
+  w.clipped = q.clip;
+  w.maxRun = q.maxRun + (q.n ? 1 : 0);
+  w.biasDrift = (int16_t)((g_biasQ16 + (1 << 15)) >> 16) - BIAS_NOMINAL;
+
+  uint8_t f = 0;
+  if ((uint32_t)q.clip * 1000UL > (uint32_t)q.n * QUALITY_CLIP_PERMILLE) f |= QUALITY_CLIP;
+  if (q.n > 1 && w.maxRun >= min<uint16_t>(QUALITY_STUCK_RUN, q.n)) f |= QUALITY_STUCK;
+  if (abs(w.biasDrift) > QUALITY_BIAS_MAX) f |= QUALITY_BIAS;
+  if (q.n > 2) {
+    uint32_t mean = (q.prev - q.first) / (q.n - 1);
+    uint32_t dev = max(q.maxGap - mean, mean - q.minGap);
+    w.jitterUs = (uint16_t)min<uint32_t>(dev / ESP.getCpuFreqMHz(), UINT16_MAX);
+    if (dev * 100UL > mean * QUALITY_JITTER_PCT) f |= QUALITY_JITTER;
+  }
+  w.flags = f;
+  g_latest = w;
+  g_stats.soundWindows++;
+  count(f);
+  g_pendingSound |= f;
+  return f;
+}
+
+void qualityEcho(bool timedOut) {
+  g_echoBits = (uint16_t)(g_echoBits << 1) | (timedOut ? 1 : 0);
+  if (g_pingsSeen < 16) g_pingsSeen++;
+  g_stats.pings++;
+  if (timedOut) g_stats.echoTimeouts++;
+  g_stats.echoRecent = (uint8_t)__builtin_popcount(g_echoBits);
+}
+
+uint8_t qualityRangeReading(uint8_t flags) {
+  if (g_pingsSeen >= QUALITY_ECHO_BAD && g_stats.echoRecent >= QUALITY_ECHO_BAD) flags |= QUALITY_ECHO_RATE;
+  count(flags);
+  g_pendingUltra |= flags;
+  return flags;
+}
+
+uint8_t qualityTake(uint8_t node) {
+  uint8_t f = 0;
+  if (node == READING_NODE_SOUND) { f = g_pendingSound; g_pendingSound = 0; }
+  else if (node == READING_NODE_ULTRA) { f = g_pendingUltra; g_pendingUltra = 0; }
+  return f;
+}
+
+void qualityDropped(uint8_t flags) {
+  g_stats.dropped++;
+  Serial.printf("[quality] reading dropped (flags 0x%02x)\n", flags);
+}
+
+const QualityWindow& qualityLatest() { return g_latest; }
+const QualityStats& qualityStats() { return g_stats; }
+
+void qualityPrint() {
+  const QualityWindow& w = g_latest;
+  Serial.printf("[quality] last sound window: %u samples, %u clipped, run %u, bias %+d counts, jitter %u us, flags 0x%02x\n",
+                w.samples, w.clipped, w.maxRun, w.biasDrift, w.jitterUs, w.flags);
+  Serial.printf("[quality] echo: %lu pings, %lu timeouts, %u of the last %u\n",
+                (unsigned long)g_stats.pings, (unsigned long)g_stats.echoTimeouts,
+                g_stats.echoRecent, g_pingsSeen);
+  Serial.print(F("[quality] flagged:"));
+  for (uint8_t b = 0; b < QUALITY_FLAG_COUNT; b++)
+    Serial.printf(" %s=%lu", QUALITY_NAMES[b], (unsigned long)g_stats.flagged[b]);
+  Serial.printf("; %lu dropped (quality_drop=0x%02x)\n", (unsigned long)g_stats.dropped, config().quality_drop);
+}
@@ -0,0 +1,164 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Signal Quality Monitor
+* File Name            : quality.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Tell a real reading from a sensor fault at the source. A saturated or
+*   disconnected MAX4466 still yields a plausible crude dB value, and a missed
+*   echo goes out as NaN; both used to be filtered downstream, if at all.
+*   The sound loops feed every raw sample to a QualityAcc next to their own
+*   sum / sum-of-squares, and the ranging path reports each ping, giving per
+*   window:
+*     - clip count   : samples at 0 or full scale (1023);
+*     - stuck run    : longest run of identical consecutive samples;
+*     - bias drift   : tracked bias (bias.h) away from the nominal 512;
+*     - jitter       : worst sample spacing against the window's mean spacing;
+*     - echo timeouts: no valid echo for the reading, the share of the last
+*       16 pings, and echoes gated as near-field ringing (ranging.h).
+*   Each window closes into QUALITY_* flags. The flags seen since a node's
+*   last reading travel with it (form field q, binary field 4; schema.h), and
+*   readings with a flag in config().quality_drop are not uploaded at all.
+*
+* Inputs:
+*   - qualitySample() per raw ADC sample, qualitySoundWindow() per window
+*     (sampling.h, oversample.cpp); qualityEcho() per ping and
+*     qualityRangeReading() per distance reading (ranging.cpp).
+*   - config().quality_drop (flags that suppress a reading).
+*
+* Outputs:
+*   - qualityTake(node): flags for the reading being submitted.
+*   - qualityLatest() / qualityStats(): last window's figures and per-flag
+*     counters ("qual" on the console, /metrics).
+*
+* Example Application:
+*   QualityAcc q; qualityBegin(q);
+*   for (...) { uint16_t x = analogRead(A0); qualitySample(q, x); ... }
+*   qualitySoundWindow(q);
+*   uint8_t flags = qualityTake(READING_NODE_SOUND);
+*   if (flags & config().quality_drop) return;          // suppressed at source
+*
+* Dependencies:
+*   - Arduino core for ESP8266 (ESP.getCycleCount)
+*   - "config.h" (quality_drop), "readings.h" (node IDs), "bias.h"
+*
+* Usage Notes:
+*   - Per-sample cost is a cycle-counter read, two compares and a few adds;
+*     everything else happens once per window.
+*   - Clipping alone is flagged but not dropped by default: a loud event does
+*     clip and is still worth reporting. Stuck samples and bias drift point
+*     at a dead or disconnected mic and are dropped by default.
+*   - Thresholds are compile-time (QUALITY_* below); override with -D.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+// ----- Flags (uploaded as-is; server/ingest_standin.py keeps them in column q) -----
+#define QUALITY_CLIP       0x01   // more than QUALITY_CLIP_PERMILLE of the window at a rail
+#define QUALITY_STUCK      0x02   // QUALITY_STUCK_RUN identical samples in a row
+#define QUALITY_BIAS       0x04   // tracked bias more than QUALITY_BIAS_MAX counts from 512
+#define QUALITY_JITTER     0x08   // a sample gap off the mean by more than QUALITY_JITTER_PCT
+#define QUALITY_NO_ECHO    0x10   // no valid echo for the reading (distance is NaN)
+#define QUALITY_ECHO_RATE  0x20   // at least QUALITY_ECHO_BAD of the last 16 pings timed out
+#define QUALITY_NEAR       0x40   // an echo inside range_min_cm was gated out
+#define QUALITY_FLAG_COUNT 7
+
+#ifndef QUALITY_CLIP_PERMILLE
+#define QUALITY_CLIP_PERMILLE 10
+#endif
+#ifndef QUALITY_STUCK_RUN
+#define QUALITY_STUCK_RUN     64          // or the whole window, if shorter
+#endif
+#ifndef QUALITY_BIAS_MAX
+#define QUALITY_BIAS_MAX      64          // counts (~0.2 V)
+#endif
+#ifndef QUALITY_JITTER_PCT
+#define QUALITY_JITTER_PCT    25
+#endif
+#ifndef QUALITY_ECHO_BAD
+#define QUALITY_ECHO_BAD      8
+#endif
+#define QUALITY_ADC_MAX       1023
+
+// Short names for the console, metrics labels and logs (bit order).
+extern const char* const QUALITY_NAMES[QUALITY_FLAG_COUNT];
+
+// Per-window accumulator, updated inline by the sampling loops.
+struct QualityAcc {
+  uint16_t n;
+  uint16_t clip;
+  uint16_t run, maxRun;     // identical samples after the first of a run
+  uint16_t last;
+  uint32_t first, prev;     // cycle counts of the first and previous sample
+  uint32_t minGap, maxGap;  // cycles between consecutive samples
+};
+
+static inline void qualityBegin(QualityAcc& q) {
+  q.n = q.clip = q.run = q.maxRun = 0;
+  q.last = 0;
+  q.first = q.prev = 0;
+  q.minGap = UINT32_MAX;
+  q.maxGap = 0;
+}
+
+static inline void qualitySample(QualityAcc& q, uint16_t raw) {
+  uint32_t now = ESP.getCycleCount();
+  if (q.n) {
+    uint32_t gap = now - q.prev;
+    if (gap < q.minGap) q.minGap = gap;
+    if (gap > q.maxGap) q.maxGap = gap;
+    q.run = (raw == q.last) ? q.run + 1 : 0;
+    if (q.run > q.maxRun) q.maxRun = q.run;
+  } else {
+    q.first = now;
+  }
+  q.prev = now;
+  q.last = raw;
+  if (raw == 0 || raw >= QUALITY_ADC_MAX) q.clip++;
+  q.n++;
+}
+
+// Last sound window and ranging history, as reported by "qual" and /metrics.
+struct QualityWindow {
+  uint16_t samples;
+  uint16_t clipped;
+  uint16_t maxRun;          // longest run of identical samples
+  int16_t  biasDrift;       // tracked bias - 512, counts
+  uint16_t jitterUs;        // worst gap deviation from the mean gap
+  uint8_t  flags;
+};
+
+struct QualityStats {
+  uint32_t flagged[QUALITY_FLAG_COUNT];   // sound windows / distance readings per flag
+  uint32_t soundWindows;
+  uint32_t pings, echoTimeouts;
+  uint32_t dropped;                       // readings suppressed by quality_drop
+  uint8_t  echoRecent;                    // timeouts among the last 16 pings
+};
+
+// Close a sound window: flags for it are added to the sound node's pending set.
+uint8_t qualitySoundWindow(const QualityAcc& q);
+
+// Report one ping to the echo timeout history.
+void qualityEcho(bool timedOut);
+
+// Close a distance reading with its QUALITY_NO_ECHO / QUALITY_NEAR flags;
+// QUALITY_ECHO_RATE is added from the history. Returns the reading's flags.
+uint8_t qualityRangeReading(uint8_t flags);
+
+// Flags gathered for 'node' (READING_NODE_*) since its last reading; clears them.
+uint8_t qualityTake(uint8_t node);
+
+// A reading with these flags was suppressed (counted for metrics).
+void qualityDropped(uint8_t flags);
+
+const QualityWindow& qualityLatest();
+const QualityStats& qualityStats();
+
+// "[quality] ..." summary on Serial.
+void qualityPrint();
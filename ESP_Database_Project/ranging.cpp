@@ -0,0 +1,184 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Ultrasonic Ranging Profiles
+* File Name            : ranging.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Profile timing, ping pacing, near-field gating, the median reading and
+*   the motion-adaptive reading rate (see ranging.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "ranging.h", "config.h", "sampling.h", "quality.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include "config.h"
+#include "sampling.h"
+#include "quality.h"
+#include "ranging.h"
+
+static RangeStats g_stats = {};
+static uint32_t   g_lastPingUs = 0;
+static bool       g_pinged = false;
+
+static RangeMotion g_motion = { 0, false, 0, 0, NAN };
+static float      g_histCm[RANGE_HISTORY];     // valid readings, ring, newest at g_histPos - 1
+static uint32_t   g_histMs[RANGE_HISTORY];
+static uint8_t    g_histN = 0, g_histPos = 0;
+static uint8_t    g_quiet = 0;
+static uint32_t   g_dueMs = 0;
+
+RangeProfile rangeProfile(const NodeConfig& cfg) {
+  RangeProfile p;
+  uint32_t maxUs = RangeDefault::echoUs(cfg.range_max_cm);
+  p.timeoutUs = RANGE_LEAD_US + maxUs + maxUs / 8;
+  p.minEchoUs = RangeDefault::echoUs(cfg.range_min_cm);
+  p.spacingUs = 2 * p.timeoutUs;
+  return p;
+}
+
+static void waitUs(uint32_t us) {
+  if (us >= 1000) delay(us / 1000);
+  delayMicroseconds(us % 1000);
+}
+
+// One ping, paced against the previous one; echo time in us, 0 on timeout.
+static uint32_t ping(const NodeConfig& cfg, const RangeProfile& p) {
+  if (g_pinged) {
+    uint32_t since = micros() - g_lastPingUs;
+    if (since < p.spacingUs) waitUs(p.spacingUs - since);
+  }
+  uint32_t t0 = micros();
+  while (digitalRead(cfg.pin_echo) == HIGH) {
+    if (micros() - t0 > RANGE_BUSY_MAX_US) { g_stats.busyWaits++; break; }
+    yield();
+  }
+  g_lastPingUs = micros();
+  g_pinged = true;
+  uint32_t us = RangeDefault::ping(cfg.pin_trig, cfg.pin_echo, p.timeoutUs);
+  g_stats.pings++;
+  if (!us) g_stats.timeouts++;
+  qualityEcho(us == 0);
+  return us;
+}
+
+float rangeRead(const NodeConfig& cfg) {
+  const RangeProfile p = rangeProfile(cfg);
+  uint32_t echoes[RANGE_PINGS_MAX];
+  uint8_t valid = 0;
+  uint8_t flags = 0;
+  for (uint8_t i = 0; i < min<uint8_t>(cfg.range_pings, RANGE_PINGS_MAX); i++) {
+    uint32_t us = ping(cfg, p);
+    if (!us) continue;
+    if (us < p.minEchoUs) { g_stats.gated++; flags |= QUALITY_NEAR; continue; }
+    uint8_t j = valid++;                          // insertion sort, at most 9 entries
+    while (j && echoes[j - 1] > us) { echoes[j] = echoes[j - 1]; j--; }
+    echoes[j] = us;
+  }
+  if (!valid) flags |= QUALITY_NO_ECHO;
+  qualityRangeReading(flags);
+  if (!valid) return NAN;
+  return RangeDefault::toCentiCm(echoes[(valid - 1) / 2]) * 0.01f;
+}
+
+const RangeStats& rangeStats() { return g_stats; }
+
+static uint32_t fastMs(const NodeConfig& cfg) {
+  return max<uint32_t>(1, (rangeProfile(cfg).spacingUs * cfg.range_pings + 999) / 1000);
+}
+
+static inline uint8_t histAt(uint8_t back) {   // 0 = newest
+  return (g_histPos + RANGE_HISTORY - 1 - back) % RANGE_HISTORY;
+}
+
+// Motion test for a new reading: speed against the newest reading at least
+// RANGE_SPEED_SPAN_MS old (or the oldest kept, over that span; a step over a
+// longer idle interval counts as if taken in 1 s), spread of the
+// last RANGE_MOTION_WINDOW readings, or an echo appearing / vanishing.
+static bool moved(float cm, uint32_t now, float threshold) {
+  bool was = !isnan(g_motion.lastCm), is = !isnan(cm);
+  if (was != is) { g_histN = g_histPos = 0; return g_motion.readings > 0; }
+  if (!is) return false;
+  bool m = false;
+
+  if (g_histN) {
+    uint8_t back = 0;
+    while (back + 1 < g_histN && now - g_histMs[histAt(back)] < RANGE_SPEED_SPAN_MS) back++;
+    uint8_t i = histAt(back);
+    uint32_t span = constrain(now - g_histMs[i], (uint32_t)RANGE_SPEED_SPAN_MS, 1000UL);   // slow idle: per step
+    if (fabsf(cm - g_histCm[i]) * 1000.0f >= threshold * span) m = true;
+  }
+
+  g_histCm[g_histPos] = cm;
+  g_histMs[g_histPos] = now;
+  g_histPos = (g_histPos + 1) % RANGE_HISTORY;
+  if (g_histN < RANGE_HISTORY) g_histN++;
+
+  uint8_t n = min<uint8_t>(g_histN, RANGE_MOTION_WINDOW);
+  if (n >= 4) {
+    float sum = 0.0f, sumSq = 0.0f;
+    for (uint8_t k = 0; k < n; k++) { float v = g_histCm[histAt(k)]; sum += v; sumSq += v * v; }
+    float var = (sumSq - sum * sum / n) / (n - 1);
+    if (var >= threshold * threshold) m = true;
+  }
+  return m;
+}
+
+bool rangeService(RangeSample& s) {
+  const NodeConfig& cfg = config();
+  if (!cfg.range_idle_ms) { g_motion.active = false; g_motion.intervalMs = 0; return false; }
+  uint32_t now = millis();
+  if (g_motion.readings && (int32_t)(now - g_dueMs) < 0) return false;
+
+  float cm = rangeRead(cfg);
+  now = millis();
+  bool m = moved(cm, now, cfg.range_motion_cm);
+  g_motion.lastCm = cm;
+  g_motion.readings++;
+
+  // Jump to the fastest rate on motion; after a quiet hold, double back to idle.
+  const uint32_t fast = min<uint32_t>(fastMs(cfg), cfg.range_idle_ms);
+  uint32_t interval = g_motion.intervalMs ? g_motion.intervalMs : cfg.range_idle_ms;
+  if (m) { interval = fast; g_quiet = 0; }
+  else if (interval < cfg.range_idle_ms && ++g_quiet > RANGE_HOLD_READINGS)
+    interval = min<uint32_t>(interval * 2, cfg.range_idle_ms);
+  interval = max(interval, fast);
+  g_motion.intervalMs = min<uint32_t>(interval, cfg.range_idle_ms);
+  g_dueMs = now + g_motion.intervalMs;
+
+  bool active = g_motion.intervalMs < cfg.range_idle_ms;
+  s.cm = cm;
+  s.intervalMs = g_motion.intervalMs;
+  s.event = RANGE_EVENT_NONE;
+  if (active == g_motion.active) return active;
+  g_motion.active = active;
+  g_motion.transitions++;
+  s.event = active ? RANGE_EVENT_MOTION : RANGE_EVENT_STATIC;
+  Serial.printf("[range] %s: reading every %lu ms (%.1f cm)\n", active ? "motion" : "static",
+                (unsigned long)g_motion.intervalMs, cm);
+  return true;
+}
+
+bool rangeActive() { return g_motion.active; }
+const RangeMotion& rangeMotion() { return g_motion; }
+
+void rangePrint() {
+  const NodeConfig& cfg = config();
+  RangeProfile p = rangeProfile(cfg);
+  Serial.printf("[range] %u..%u cm, %u ping(s): timeout %lu us, gate %lu us, spacing %lu us\n",
+                cfg.range_min_cm, cfg.range_max_cm, cfg.range_pings,
+                (unsigned long)p.timeoutUs, (unsigned long)p.minEchoUs, (unsigned long)p.spacingUs);
+  Serial.printf("[range] %lu pings, %lu timeouts, %lu gated, %lu busy waits\n",
+                (unsigned long)g_stats.pings, (unsigned long)g_stats.timeouts,
+                (unsigned long)g_stats.gated, (unsigned long)g_stats.busyWaits);
+  if (!cfg.range_idle_ms) { Serial.println(F("[range] adaptive off (cfg set range_idle_ms <ms>)")); return; }
+  Serial.printf("[range] adaptive: %s, every %lu ms (idle %u, fastest %lu), %lu readings, %lu transitions\n",
+                g_motion.active ? "active" : "idle", (unsigned long)g_motion.intervalMs, cfg.range_idle_ms,
+                (unsigned long)min<uint32_t>(fastMs(cfg), cfg.range_idle_ms),
+                (unsigned long)g_motion.readings, (unsigned long)g_motion.transitions);
+}
@@ -0,0 +1,139 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Ultrasonic Ranging Profiles
+* File Name            : ranging.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Fit the HC-SR04 timing to the installation instead of always waiting
+*   30 ms for an echo and accepting any echo however short. A profile is a
+*   min / max range and a ping count (config.h); everything else follows
+*   from it:
+*     - echo timeout : lead-in + round trip to range_max_cm + 1/8 margin;
+*                      a farther target reads as "no echo", as before;
+*     - ping spacing : two timeouts, so echoes of the previous burst from up
+*                      to twice the max range have died away;
+*     - near gate    : echoes shorter than the round trip to range_min_cm
+*                      are transducer ringing and are discarded.
+*   A reading is the median of the valid echoes of range_pings pings.
+*   Presets: "cfg set range_profile near|room|full" (3..100 cm, 3..300 cm,
+*   and the old 2..450 cm single ping).
+*
+*   Adaptive ranging (range_idle_ms > 0): rangeService() takes readings on
+*   its own, every range_idle_ms while the scene is static. A speed above
+*   range_motion_cm per second (measured over at least RANGE_SPEED_SPAN_MS,
+*   so echo noise at the fast rate is not mistaken for motion, and at most
+*   1 s, so a long idle interval does not dilute a step), a spread
+*   (std deviation of the last RANGE_MOTION_WINDOW readings) above
+*   range_motion_cm, or a target appearing / vanishing switches to the
+*   fastest interval the profile allows
+*   (ping spacing x range_pings). After RANGE_HOLD_READINGS quiet readings the
+*   interval doubles per quiet reading back to range_idle_ms. Every reading
+*   taken while active is uploaded with the interval in force (interval_ms);
+*   the readings at each idle <-> active transition also carry the event
+*   (range_ev, RANGE_EVENT_*), and transitions are logged and counted.
+*
+* Inputs:
+*   - config().pin_trig / pin_echo, range_min_cm, range_max_cm, range_pings,
+*     range_idle_ms, range_motion_cm.
+*
+* Outputs:
+*   - rangeRead(): distance in cm, NaN without a valid echo; read_sensor_1()
+*     calls it through readRangeCm() (sampling.h).
+*   - QUALITY_NO_ECHO / QUALITY_NEAR on the reading, each ping in the echo
+*     timeout history (quality.h); "range" on the console.
+*   - rangeService(): true with a RangeSample for each active reading and
+*     each transition; RangeMotion for /metrics (interval, state, transitions).
+*
+* Example Application:
+*   // cfg set range_profile near     -> 7 ms timeout, 14 ms between pings
+*   float cm = rangeRead(config());
+*   // cfg set range_idle_ms 1000     -> 1 reading/s static, ~23/s on motion
+*   //                                   (3 pings x 14 ms = ~43 ms per reading)
+*   RangeSample s;
+*   if (rangeService(s)) ...;    // AdaptiveRangeSensor in main.cpp (sensors.h) polls this
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "config.h", "sampling.h" (RangePipeline conversion and ping), "quality.h"
+*
+* Usage Notes:
+*   - With the full profile (450 cm) the timeout is the old 30 ms and the
+*     spacing the datasheet's 60 ms; the near profile pings ~4x faster.
+*   - A module that heard nothing holds ECHO high for its own timeout
+*     (~38 ms, longer on some clones); the next ping waits for ECHO to drop,
+*     up to RANGE_BUSY_MAX_US, so a short spacing cannot trigger into it.
+*   - Idle readings stay on the node (only button presses upload then); they
+*     cost one reading per interval and feed the quality flags of the next
+*     uploaded distance. Active readings fill the queue at the fast rate, so
+*     batched transports are the better fit for adaptive ranging.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+#define RANGE_LEAD_US      500        // trigger to ECHO high (burst + module latency)
+#define RANGE_BUSY_MAX_US  40000UL    // longest wait for a previous ECHO to end
+#define RANGE_PINGS_MAX    9
+#define RANGE_MOTION_WINDOW 8         // readings in the spread estimate
+#define RANGE_HISTORY       32        // readings kept for the speed baseline
+#define RANGE_SPEED_SPAN_MS 250       // shortest baseline for the speed estimate
+#define RANGE_HOLD_READINGS 8         // quiet readings at the fast rate before decaying
+
+#define RANGE_EVENT_NONE    0         // no transition at this reading
+#define RANGE_EVENT_MOTION  1         // idle -> active: switched to the fast interval
+#define RANGE_EVENT_STATIC  2         // active -> idle: back to range_idle_ms
+
+// Timing derived from one configured profile.
+struct RangeProfile {
+  uint32_t timeoutUs;    // pulseIn() timeout, trigger to end of echo
+  uint32_t minEchoUs;    // shorter echoes are gated out
+  uint32_t spacingUs;    // minimum trigger-to-trigger time
+};
+
+struct RangeStats {
+  uint32_t pings;
+  uint32_t timeouts;     // no echo within timeoutUs
+  uint32_t gated;        // echo inside range_min_cm
+  uint32_t busyWaits;    // ECHO still high from the previous ping at RANGE_BUSY_MAX_US
+};
+
+// Adaptive controller state (range_idle_ms > 0).
+struct RangeMotion {
+  uint32_t intervalMs;   // current reading interval
+  bool     active;       // faster than idle
+  uint32_t transitions;  // idle <-> active changes since boot
+  uint32_t readings;     // readings taken by rangeService()
+  float    lastCm;       // NaN without an echo
+};
+
+// Timeout, near gate and spacing for cfg's range_min_cm / range_max_cm.
+RangeProfile rangeProfile(const NodeConfig& cfg);
+
+// One reading: median of the valid echoes of range_pings pings, in cm; NaN if none.
+float rangeRead(const NodeConfig& cfg);
+
+const RangeStats& rangeStats();
+
+// One adaptive reading for upload.
+struct RangeSample {
+  float    cm;           // NaN without an echo
+  uint32_t intervalMs;   // interval in force after this reading
+  uint8_t  event;        // RANGE_EVENT_*
+};
+
+// Take an adaptive reading when due. True when it should be uploaded: every
+// reading while active, and the one that returns to idle.
+bool rangeService(RangeSample& s);
+
+// True while the controller runs faster than idle (loop() should not sleep then).
+bool rangeActive();
+
+const RangeMotion& rangeMotion();
+
+// Profile timing, ping counters and controller state on Serial.
+void rangePrint();
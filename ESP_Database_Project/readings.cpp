@@ -0,0 +1,76 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Reading Queue
+* File Name            : readings.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Ring buffer of captured readings (see readings.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "readings.h", "sequence.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include "readings.h"
+#include "sequence.h"
+
+static Reading g_ring[READING_QUEUE_CAP];
+static uint8_t g_head = 0;    // index of the oldest reading
+static uint8_t g_count = 0;
+static uint8_t g_pinned = 0;  // oldest entries that must not be overwritten
+static uint32_t g_overflows = 0;
+
+void readingPin(uint8_t n) { g_pinned = min<uint8_t>(n, g_count); }
+
+PushResult readingPush(const Reading& r) {
+  PushResult res = PUSH_KEPT;
+  if (g_count == READING_QUEUE_CAP) {
+    g_overflows++;
+    if (g_pinned >= g_count) return PUSH_REJECTED;   // everything is in flight
+    // Remove the oldest unpinned entry by sliding the pinned ones up one slot.
+    for (uint8_t i = g_pinned; i > 0; i--)
+      g_ring[(g_head + i) % READING_QUEUE_CAP] = g_ring[(g_head + i - 1) % READING_QUEUE_CAP];
+    g_head = (g_head + 1) % READING_QUEUE_CAP;
+    g_count--;
+    res = PUSH_EVICTED;
+  }
+  Reading& slot = g_ring[(g_head + g_count) % READING_QUEUE_CAP];
+  slot = r;
+  slot.seq = seqNext();
+  g_count++;
+  return res;
+}
+
+uint8_t readingSequenced(uint8_t n) {
+  if (n > g_count) n = g_count;
+  for (uint8_t i = 0; i < n; i++) {
+    Reading& r = g_ring[(g_head + i) % READING_QUEUE_CAP];
+    if (!r.seq && !(r.seq = seqNext())) return i;
+  }
+  return n;
+}
+
+uint8_t readingCount() { return g_count; }
+
+uint32_t readingOverflows() { return g_overflows; }
+
+const Reading& readingAt(uint8_t i) {
+  return g_ring[(g_head + i) % READING_QUEUE_CAP];
+}
+
+void readingDrop(uint8_t n) {
+  if (n > g_count) n = g_count;
+  g_head = (g_head + n) % READING_QUEUE_CAP;
+  g_count -= n;
+  g_pinned = g_pinned > n ? g_pinned - n : 0;
+}
+
+const char* readingNodeName(uint8_t node) {
+  return node == READING_NODE_ULTRA ? READING_NAME_ULTRA :
+         node == READING_NODE_CLASS ? READING_NAME_CLASS : READING_NAME_SOUND;
+}
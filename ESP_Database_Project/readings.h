@@ -0,0 +1,119 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Reading Queue
+* File Name            : readings.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Hold captured readings until a batching transport uploads them. Each entry
+*   keeps its own capture time, so batched rows carry when they were measured,
+*   not when they were sent.
+*
+* Inputs:
+*   - readingPush() from the sampling path.
+*
+* Outputs:
+*   - readingAt()/readingCount() for transports; readingDrop() once acknowledged.
+*     batchPayload() (batchcodec.h) encodes queued readings as text records
+*     or the compact binary layout, per batch_format.
+*
+* Example Application:
+*   Reading r = {};
+*   r.epoch = sec; r.ms = ms; r.node = READING_NODE_SOUND;
+*   r.sound_db = db; r.fields = READING_FIELD_SOUND;      // seq filled in by readingPush()
+*   readingPush(r);
+*   ...
+*   BatchPayload body; uint8_t n = batchPayload(0, 8, tzRegion, body);
+*   if (upload(body.data(), body.length())) readingDrop(n);
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "sequence.h", getTImeAPI.cpp (isoFromEpoch)
+*
+* Usage Notes:
+*   - Fixed-size ring, no heap. When full the oldest reading is overwritten
+*     (newest data is the most useful after an outage), except readings a
+*     transport has pinned because they are in flight.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <time.h>
+
+#ifndef READING_QUEUE_CAP
+#define READING_QUEUE_CAP 32
+#endif
+
+// Logical node identifiers (match NodeSel in main.cpp).
+#define READING_NODE_ULTRA 1
+#define READING_NODE_SOUND 2
+#define READING_NODE_CLASS 3     // acoustic class probabilities (classify.h)
+
+#define READING_NAME_ULTRA "Ultrasonic_Sensor"
+#define READING_NAME_SOUND "Sound_Sensor_MAX4466"
+#define READING_NAME_CLASS "Sound_Classifier"
+
+#define READING_CLASSES    5     // probabilities carried by READING_NODE_CLASS readings
+
+// Presence bits of Reading::fields; a sensor declares the ones it fills
+// (sensors.h kFields) and the registry in schema.h maps them to the wire.
+#define READING_FIELD_DIST    0x01   // distance_cm
+#define READING_FIELD_SOUND   0x02   // sound_db
+#define READING_FIELD_CLASSES 0x04   // cls[]
+#define READING_FIELD_QUALITY 0x08   // quality (set when non-zero)
+#define READING_FIELD_INTERVAL 0x10  // interval_ms (adaptive ranging, ranging.h)
+#define READING_FIELD_EVENT   0x20   // range_event (set when non-zero)
+
+struct Reading {
+  uint32_t epoch;        // capture time, UTC seconds
+  uint16_t ms;           // capture time, milliseconds within 'epoch'
+  uint8_t  node;         // READING_NODE_*
+  float    distance_cm;
+  float    sound_db;
+  uint32_t seq;          // per-node sequence number, assigned by readingPush()
+  uint8_t  cls[READING_CLASSES];   // class probabilities, percent (READING_NODE_CLASS only)
+  uint8_t  quality;      // QUALITY_* flags seen since the node's previous reading (quality.h)
+  float    interval_ms;  // adaptive ranging interval in force after this reading
+  uint8_t  range_event;  // RANGE_EVENT_* (ranging.h)
+  uint8_t  fields;       // READING_FIELD_* present; absent members are not uploaded
+};
+
+enum PushResult : uint8_t {
+  PUSH_KEPT     = 0,   // queued, nothing lost
+  PUSH_EVICTED  = 1,   // queued; the oldest unpinned reading was overwritten
+  PUSH_REJECTED = 2,   // not queued: every queued reading is pinned
+};
+
+// Queue a reading, tagging it with the next sequence number (seqNext()) so
+// every later upload or replay of it is recognisable to the server. If no
+// number can be saved it is queued with seq 0 and numbered by readingSequenced().
+PushResult readingPush(const Reading& r);
+
+// Number the first n queued readings that still have seq 0. Returns how many
+// leading readings carry a number; only those may be uploaded.
+uint8_t readingSequenced(uint8_t n);
+
+// Protect the n oldest readings from overwrite (e.g., awaiting acknowledgement).
+void readingPin(uint8_t n);
+
+// Number of queued readings.
+uint8_t readingCount();
+
+// Readings lost to a full queue since boot.
+uint32_t readingOverflows();
+
+// i-th oldest queued reading (i < readingCount()).
+const Reading& readingAt(uint8_t i);
+
+// Remove the n oldest readings (after a successful upload).
+void readingDrop(uint8_t n);
+
+// Server-side name of a node ID.
+const char* readingNodeName(uint8_t node);
+
+// Implemented in getTImeAPI.cpp.
+extern void isoFromEpoch(time_t epoch, String& outIso);
+extern bool captureTime(uint32_t& sec, uint16_t& ms);
@@ -0,0 +1,262 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Compile-Time Sampling Pipelines
+* File Name            : sampling.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Template versions of the sound (MAX4466) and ranging (HC-SR04) pipelines.
+*   Window size, sample rate and scaling constants are template parameters, so
+*   the compiler folds them: "/ N" becomes a shift (power-of-two N) or a
+*   multiply-high, the sample spacing is an immediate, and float scale factors
+*   become one integer multiply + shift per window instead of a float multiply
+*   and divide per sample.
+*
+* Inputs:
+*   - Template parameters (see each pipeline below).
+*   - GPIO/ADC pin numbers at call time (pins stay runtime-configurable).
+*
+* Outputs:
+*   - SoundPipeline<...>::crudeDb()  : read_sensor_2()'s value, with the mean
+*                                      deviation from the tracked bias as
+*                                      the level instead of |mean - 512|.
+*   - SoundPipeline<...>::rmsVolts() : single-pass AC RMS at the mic side (V).
+*   - RangePipeline<...>::readCm()   : one fixed-timeout ping, the original
+*                                      read_sensor_1() value.
+*   - readRangeCm()                  : the configured ranging profile (ranging.h).
+*   - readSoundDb()                  : dispatch from config() to a specialization,
+*                                      falling back to the generic runtime loop;
+*                                      config().oversample > 1 routes sound
+*                                      windows through oversample.h instead.
+*
+* Example Application:
+*   float db = SoundPipeline<256, 5000, AdcScaleMic>::crudeDb(A0);
+*   float cm = readRangeCm(cfg);   // picks the folded variant for cfg
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "config.h" (runtime values used to pick a specialization)
+*   - "oversample.h" (CIC front end when oversampling is on)
+*   - "timeweight.h" (every sample is also fed to the F/S/I stage)
+*   - "adccal.h" (table volts for the F/S/I stage)
+*   - "bias.h" (tracked DC bias; every sample updates it)
+*   - "quality.h" (clip / stuck / jitter per window)
+*   - "ranging.h" (profile-driven ranging behind readRangeCm())
+*
+* Usage Notes:
+*   - Header-only: templates must be visible at the call site to be folded.
+*   - Add a specialization to SOUND_SPECIALIZATIONS when a new window/rate pair
+*     becomes common in the field; everything else still works via the generic path.
+*   - Build the "bench" environment (-DSAMPLING_BENCH) to print cycles/sample for
+*     every specialization against the generic loop (see runSamplingBench()).
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "oversample.h"
+#include "timeweight.h"
+#include "adccal.h"
+#include "bias.h"
+#include "quality.h"
+#include "ranging.h"
+
+// ================== ADC scaling ==================
+// Mic-side volts per ADC count as an exact rational FullScaleMv / MaxCount.
+// kUvPerCountQ16 is the same factor in microvolts, Q16 fixed point, so a
+// conversion is one integer multiply and one shift.
+template <uint32_t FullScaleMv, uint32_t MaxCount>
+struct AdcScale {
+  static_assert(MaxCount > 0, "MaxCount must be > 0");
+  static constexpr uint32_t kFullScaleMv = FullScaleMv;
+  static constexpr uint32_t kMaxCount    = MaxCount;
+  static constexpr uint32_t kUvPerCountQ16 =
+      (uint32_t)(((uint64_t)FullScaleMv * 1000ULL << 16) / MaxCount);
+  static constexpr float    kVoltsPerCount = (float)FullScaleMv / 1000.0f / (float)MaxCount;
+
+  // raw count -> mic-side microvolts (integer; exact to < 1 uV).
+  static inline uint32_t toMicrovolts(uint16_t raw) {
+    return (uint32_t)(((uint64_t)raw * kUvPerCountQ16) >> 16);
+  }
+};
+
+// MAX4466 behind the 100k/47k divider: 0..1023 maps back to 0..3.3 V mic side.
+typedef AdcScale<3300, 1023> AdcScaleMic;
+
+// ================== Sound pipeline ==================
+// N  : samples per window
+// FS : target sample rate in Hz (spacing = 1e6/FS us, folded to an immediate)
+// S  : AdcScale<> used for volt conversion
+template <uint16_t N, uint32_t FS, class S = AdcScaleMic>
+struct SoundPipeline {
+  static_assert(N > 0, "window must hold at least one sample");
+  static_assert(FS > 0 && FS <= 100000UL, "sample rate out of range");
+  // sum of N 10-bit samples and of their squares must fit in 32 bits
+  // (absDev, at most N * 1023 * 16, then fits too)
+  static_assert((uint64_t)N * 1023ULL * 1023ULL <= 0xFFFFFFFFULL, "window too large for 32-bit accumulators");
+
+  static constexpr uint16_t kSamples = N;
+  static constexpr uint32_t kRateHz  = FS;
+  static constexpr uint32_t kGapUs   = 1000000UL / FS;
+
+  struct Acc { uint32_t sum; uint32_t sumSq; uint32_t absDev; };   // absDev: sum |x - bias|, Q4 counts
+
+  // Pure accumulation kernel over a captured buffer (benchmarked separately).
+  // Integer add / multiply-accumulate only; N is a constant trip count.
+  static inline Acc accumulate(const uint16_t* buf) {
+    Acc a = {0, 0, 0};
+    const int32_t mid = biasQ4();
+    for (uint16_t i = 0; i < N; i++) {
+      uint32_t x = buf[i];
+      a.sum += x;
+      a.sumSq += x * x;
+      a.absDev += abs(((int32_t)x << 4) - mid);
+    }
+    return a;
+  }
+
+  // Sample the ADC for one window, paced at FS; quality closes with the window.
+  static inline Acc sample(uint8_t pin) {
+    Acc a = {0, 0, 0};
+    const int32_t mid = biasQ4();               // bias at window start
+    TimeWeighter* tw = twWindow();
+    QualityAcc q;
+    qualityBegin(q);
+    for (uint16_t i = 0; i < N; i++) {
+      uint32_t x = analogRead(pin);
+      a.sum += x;
+      a.sumSq += x * x;
+      a.absDev += abs(((int32_t)x << 4) - mid);
+      qualitySample(q, x);
+      biasTrack(x);
+      twPush(tw, adcVoltsQ13(x));
+      delayMicroseconds(kGapUs);
+    }
+    twWindowEnd(tw, N);
+    qualitySoundWindow(q);
+    return a;
+  }
+
+  // read_sensor_2() semantics: level in counts -> 20*log10, floor at 0 dB.
+  // The level is the mean |x - bias| around the tracked bias (bias.h) rather
+  // than |mean - 512|: the tracker converges to the mean, so only the AC part
+  // is left to measure.
+  static float crudeDbFrom(const Acc& a) {
+    float level = (float)a.absDev / (16.0f * N);   // one constant-divisor op per window
+    float db = 20.0f * log10f(max(level, 1.0f));
+    if (!isfinite(db)) db = 0.0f;
+    return db;
+  }
+  static float crudeDb(uint8_t pin) { return crudeDbFrom(sample(pin)); }
+
+  // AC RMS around the window mean in mic-side volts, from one pass:
+  //   var = (N*sumSq - sum^2) / N^2   (counts^2), then scale once.
+  static float rmsVoltsFrom(const Acc& a) {
+    uint64_t nSq = (uint64_t)N * a.sumSq;
+    uint64_t sq  = (uint64_t)a.sum * a.sum;
+    uint64_t d   = nSq > sq ? nSq - sq : 0;    // guards rounding at silence
+    float rmsCounts = sqrtf((float)d) / N;
+    return rmsCounts * S::kVoltsPerCount;
+  }
+  static float rmsVolts(uint8_t pin) { return rmsVoltsFrom(sample(pin)); }
+};
+
+// ================== Ranging pipeline ==================
+// TimeoutUs : pulseIn() echo timeout of readCm()
+// CmPerUsQ16: round-trip-corrected cm per microsecond of echo, Q16
+//             (0.0343 cm/us / 2 = 0.01715 -> 1124 in Q16)
+template <uint32_t TimeoutUs, uint32_t CmPerUsQ16 = 1124>
+struct RangePipeline {
+  static_assert(TimeoutUs > 0, "timeout must be > 0");
+  static constexpr uint32_t kTimeoutUs = TimeoutUs;
+
+  // echo time (us) -> distance in hundredths of a cm, integer only.
+  static inline uint32_t toCentiCm(uint32_t durationUs) {
+    return (uint32_t)(((uint64_t)durationUs * CmPerUsQ16 * 100ULL) >> 16);
+  }
+
+  // distance in cm -> echo time (us), the inverse of toCentiCm().
+  static constexpr uint32_t echoUs(uint32_t cm) {
+    return (uint32_t)(((uint64_t)cm << 16) / CmPerUsQ16);
+  }
+
+  // Trigger one ping; echo time in us, 0 if none within timeoutUs.
+  static uint32_t ping(uint8_t trig, uint8_t echo, uint32_t timeoutUs) {
+    digitalWrite(trig, LOW); delayMicroseconds(2);
+    digitalWrite(trig, HIGH); delayMicroseconds(10);
+    digitalWrite(trig, LOW);
+    return pulseIn(echo, HIGH, timeoutUs);
+  }
+
+  // Original read_sensor_1() semantics: NaN on timeout, no gating.
+  static float readCm(uint8_t trig, uint8_t echo) {
+    uint32_t duration = ping(trig, echo, TimeoutUs);
+    if (duration == 0) return NAN;
+    return toCentiCm(duration) * 0.01f;
+  }
+};
+
+typedef RangePipeline<30000UL> RangeDefault;   // 30 ms timeout (~5 m)
+
+// ================== Runtime dispatch ==================
+// Window/rate pairs with a folded specialization. Keep this list short:
+// every entry costs flash for its own copy of the loops.
+#define SOUND_SPECIALIZATIONS(X) \
+  X(200, 5000)                   \
+  X(256, 5000)                   \
+  X(128, 5000)                   \
+  X(64,  5000)                   \
+  X(20,  5000)
+
+// Generic fallback: the original runtime-valued loop.
+inline float readSoundDbGeneric(uint8_t pin, uint16_t n, uint32_t fs) {
+  const unsigned int gapUs = 1000000UL / fs;
+  uint32_t absDev = 0;                  // sum |x - bias|, Q4 counts
+  const int32_t mid = biasQ4();
+  TimeWeighter* tw = twWindow();
+  QualityAcc q;
+  qualityBegin(q);
+  for (uint16_t i = 0; i < n; i++) {
+    int x = analogRead(pin);
+    absDev += abs((x << 4) - mid);
+    qualitySample(q, x);
+    biasTrack(x);
+    twPush(tw, adcVoltsQ13(x));
+    delayMicroseconds(gapUs);
+  }
+  twWindowEnd(tw, n);
+  qualitySoundWindow(q);
+  float level = (float)absDev / (16.0f * n);
+  float db = 20.0f * log10f(max(level, 1.0f));
+  if (!isfinite(db)) db = 0.0f;
+  return db;
+}
+
+// Crude relative level over an n-sample window at config().target_fs.
+inline float readSoundDbWindow(const NodeConfig& cfg, uint16_t n) {
+  if (cfg.oversample > 1) return readSoundDbOversampled(cfg, n);
+#define SOUND_CASE(sn, fs) \
+  if (n == (sn) && cfg.target_fs == (fs)) return SoundPipeline<(sn), (fs)>::crudeDb(cfg.pin_sound);
+  SOUND_SPECIALIZATIONS(SOUND_CASE)
+#undef SOUND_CASE
+  return readSoundDbGeneric(cfg.pin_sound, n, cfg.target_fs);
+}
+
+// Crude relative level for config().samples / config().target_fs.
+inline float readSoundDb(const NodeConfig& cfg) {
+  return readSoundDbWindow(cfg, cfg.samples);
+}
+
+// Distance with cfg's ranging profile: computed timeout, near gate, median of pings.
+inline float readRangeCm(const NodeConfig& cfg) {
+  return rangeRead(cfg);
+}
+
+#ifdef SAMPLING_BENCH
+// Print CPU cycles per sample of the accumulation kernel for each
+// specialization versus the generic runtime-N loop (ADC and pacing excluded).
+void runSamplingBench();
+#endif
@@ -0,0 +1,187 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Sampling Pipeline Benchmark
+* File Name            : sampling_bench.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Measure the per-sample CPU cost of each SoundPipeline specialization against
+*   the generic runtime-valued loop, the float adcToVolts() style used by the
+*   standalone sound meter sketch and its table replacement (adccal.h), of the CIC + FIR decimator per
+*   oversampling ratio, of the Fast/Slow/Impulse time-weighting kernel, and of the
+*   acoustic classifier per frame and per inference (classify.h).
+*
+* Outputs:
+*   - Serial table: variant, window, cycles/sample, ns/sample at the current CPU clock.
+*     Decimator rows are per ADC input sample; classifier rows are cycles per call
+*     (feed them to server/classifier_tool.py eval --frame-cycles / --infer-cycles).
+*
+* Usage Notes:
+*   - Only compiled with -DSAMPLING_BENCH (see [env:nodemcuv2_bench] in platformio.ini).
+*   - ADC reads and pacing delays are excluded: the kernels run over a captured
+*     buffer so the numbers reflect arithmetic only.
+*   - Recording results: pio run -e nodemcuv2_bench -t upload, then
+*     pio device monitor at 9600 and copy the table into the commit that
+*     changes a kernel, with the board and CPU clock (80 / 160 MHz). Only
+*     ESP8266 figures count; a host build of this file runs but its cycle
+*     counts say nothing about the Xtensa core.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#ifdef SAMPLING_BENCH
+
+#include <Arduino.h>
+#include "sampling.h"
+#include "oversample.h"
+#include "timeweight.h"
+#include "adccal.h"
+#include "classify.h"
+
+static const uint16_t BENCH_MAX_N = 256;
+static const uint8_t  BENCH_REPS  = 32;
+static uint16_t g_buf[BENCH_MAX_N];
+static volatile uint32_t g_sink;       // defeats dead-code elimination
+static volatile uint16_t g_runtimeN;   // hides N from the optimizer
+
+static void fillBuffer() {
+  for (uint16_t i = 0; i < BENCH_MAX_N; i++) {
+    // mid-rail bias plus a small deterministic "signal"
+    g_buf[i] = 512 + (int16_t)((i * 37) % 61) - 30;
+  }
+}
+
+static void report(const char* name, uint16_t n, uint32_t cycles) {
+  float perSample = (float)cycles / ((float)n * BENCH_REPS);
+  Serial.printf("  %-22s N=%-4u %7.2f cyc/sample  %7.1f ns/sample\n",
+                name, n, perSample, perSample * 1000.0f / ESP.getCpuFreqMHz());
+}
+
+// Generic: trip count and divisor only known at run time.
+static void benchGeneric(uint16_t n) {
+  g_runtimeN = n;
+  uint32_t t0 = ESP.getCycleCount();
+  for (uint8_t r = 0; r < BENCH_REPS; r++) {
+    uint16_t rn = g_runtimeN;
+    int32_t mid = biasQ4();
+    uint32_t sum = 0, sumSq = 0, absDev = 0;
+    for (uint16_t i = 0; i < rn; i++) {
+      uint32_t x = g_buf[i]; sum += x; sumSq += x * x; absDev += abs(((int32_t)x << 4) - mid);
+    }
+    g_sink = sum / rn + sumSq / rn + absDev / rn;
+  }
+  report("generic", n, ESP.getCycleCount() - t0);
+}
+
+// Sketch style: float scale and divide every sample.
+static void benchFloatVolts(uint16_t n) {
+  g_runtimeN = n;
+  uint32_t t0 = ESP.getCycleCount();
+  for (uint8_t r = 0; r < BENCH_REPS; r++) {
+    uint16_t rn = g_runtimeN;
+    double sumV = 0.0;
+    for (uint16_t i = 0; i < rn; i++) sumV += (3.3f * (float)g_buf[i] / 1023.0f);
+    g_sink = (uint32_t)(sumV * 1000.0);
+  }
+  report("float adcToVolts", n, ESP.getCycleCount() - t0);
+}
+
+// Table lookup (adccal.h): one load per sample, integer sum.
+static void benchLutVolts(uint16_t n) {
+  g_runtimeN = n;
+  uint32_t t0 = ESP.getCycleCount();
+  for (uint8_t r = 0; r < BENCH_REPS; r++) {
+    uint16_t rn = g_runtimeN;
+    uint32_t sumV = 0;
+    for (uint16_t i = 0; i < rn; i++) sumV += adcVoltsQ13(g_buf[i]);
+    g_sink = sumV;
+  }
+  report("adcVoltsQ13 table", n, ESP.getCycleCount() - t0);
+}
+
+template <uint16_t N>
+static void benchSpecialized() {
+  typedef SoundPipeline<N, 5000> P;
+  uint32_t t0 = ESP.getCycleCount();
+  for (uint8_t r = 0; r < BENCH_REPS; r++) {
+    typename P::Acc a = P::accumulate(g_buf);
+    g_sink = a.sum / N + a.sumSq / N + a.absDev / N;
+  }
+  report("SoundPipeline<N,5000>", N, ESP.getCycleCount() - t0);
+}
+
+// CIC + compensation FIR over the captured buffer, cost per input sample.
+template <uint8_t LogR>
+static void benchDecimator() {
+  CicDecimator<LogR> cic;
+  CicCompensator fir;
+  cic.reset();
+  fir.reset(LogR);
+  uint32_t t0 = ESP.getCycleCount();
+  for (uint8_t r = 0; r < BENCH_REPS; r++) {
+    int32_t acc = 0, y;
+    for (uint16_t i = 0; i < BENCH_MAX_N; i++)
+      if (cic.push(adcVoltsQ13(g_buf[i]) - adcMidQ13(), y)) acc += fir.step(y);
+    g_sink = acc;
+  }
+  char name[24];
+  snprintf(name, sizeof(name), "CIC+FIR R=%u", 1u << LogR);
+  report(name, BENCH_MAX_N, ESP.getCycleCount() - t0);
+}
+
+// Time-weighting kernel (timeweight.h) per sample, interval bookkeeping included.
+static void benchTimeWeighting() {
+  static TimeWeighter tw;
+  tw.begin(5000, 625);
+  uint32_t t0 = ESP.getCycleCount();
+  for (uint8_t r = 0; r < BENCH_REPS; r++) {
+    uint32_t closed = 0;
+    for (uint16_t i = 0; i < BENCH_MAX_N; i++)
+      if (tw.push(adcVoltsQ13(g_buf[i]))) { closed++; tw.count = 0; }
+    g_sink = closed + (uint32_t)(tw.fast >> 30);
+  }
+  report("TimeWeighter F/S/I", BENCH_MAX_N, ESP.getCycleCount() - t0);
+}
+
+// Classifier front end (window, FFT, mel, log) per frame and the network per window.
+static void benchClassifier() {
+  static uint16_t logs[CLS_FRAMES][CLS_MELS];
+  clsTables(5000);
+  uint32_t t0 = ESP.getCycleCount();
+  for (uint8_t r = 0; r < BENCH_REPS; r++) clsFrame(g_buf, adcMidQ13(), logs[r % CLS_FRAMES]);
+  uint32_t tFrame = ESP.getCycleCount() - t0;
+  uint8_t pct[CLS_CLASSES];
+  t0 = ESP.getCycleCount();
+  for (uint8_t r = 0; r < BENCH_REPS; r++) g_sink = clsInfer(logs, pct);
+  uint32_t tInfer = ESP.getCycleCount() - t0;
+  Serial.printf("  classifier frame N=%u %lu cyc, inference %lu cyc\n", CLS_FFT_N,
+                (unsigned long)(tFrame / BENCH_REPS), (unsigned long)(tInfer / BENCH_REPS));
+}
+
+void runSamplingBench() {
+  fillBuffer();
+  Serial.println(F("\n[bench] sound accumulation kernel (ADC excluded)"));
+#define BENCH_CASE(n, fs) benchSpecialized<(n)>(); benchGeneric(n); benchFloatVolts(n); benchLutVolts(n);
+  SOUND_SPECIALIZATIONS(BENCH_CASE)
+#undef BENCH_CASE
+
+  Serial.println(F("[bench] oversampling decimator, per ADC sample (ADC excluded)"));
+  benchDecimator<1>(); benchDecimator<2>(); benchDecimator<3>(); benchDecimator<4>();
+  Serial.println(F("[bench] time weighting, per sample"));
+  benchTimeWeighting();
+  Serial.println(F("[bench] acoustic classifier, per call"));
+  benchClassifier();
+
+  // Ranging: one conversion per ping, shown for completeness.
+  uint32_t t0 = ESP.getCycleCount();
+  for (uint16_t i = 0; i < 1000; i++) g_sink = RangeDefault::toCentiCm(g_buf[i & 0xFF] * 10U);
+  uint32_t tInt = ESP.getCycleCount() - t0;
+  t0 = ESP.getCycleCount();
+  for (uint16_t i = 0; i < 1000; i++) g_sink = (uint32_t)(g_buf[i & 0xFF] * 10U * 0.0343f / 2.0f * 100.0f);
+  uint32_t tFlt = ESP.getCycleCount() - t0;
+  Serial.printf("[bench] range conversion: integer %.1f cyc, float %.1f cyc\n",
+                tInt / 1000.0f, tFlt / 1000.0f);
+}
+
+#endif // SAMPLING_BENCH
@@ -0,0 +1,88 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Reading Field Schema
+* File Name            : schema.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   The field registry and its form / console formatting (see schema.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "schema.h", "readings.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <stddef.h>
+#include "readings.h"
+#include "schema.h"
+
+static_assert(BATCH_DIST_DECIMALS <= 3 && BATCH_SOUND_DECIMALS <= 3, "batchcodec.cpp scales by at most 10^3");
+static_assert(sizeof(Reading::distance_cm) == sizeof(float) && sizeof(Reading::sound_db) == sizeof(float) &&
+              sizeof(Reading::interval_ms) == sizeof(float), "scaled fields are float members");
+
+constexpr FieldDef SCHEMA_FIELDS[SCHEMA_FIELD_COUNT] = {
+  { FIELD_ID_DIST,    READING_FIELD_DIST,    FIELD_WIRE_SCALED, BATCH_DIST_DECIMALS,
+    offsetof(Reading, distance_cm), true,  "distance_cm", "cm" },
+  { FIELD_ID_SOUND,   READING_FIELD_SOUND,   FIELD_WIRE_SCALED, BATCH_SOUND_DECIMALS,
+    offsetof(Reading, sound_db),    true,  "sound_db",    "dB" },
+  { FIELD_ID_CLASSES, READING_FIELD_CLASSES, FIELD_WIRE_BYTES,  READING_CLASSES,
+    offsetof(Reading, cls),         false, "cls",         "%" },
+  { FIELD_ID_QUALITY, READING_FIELD_QUALITY, FIELD_WIRE_BYTES,  1,
+    offsetof(Reading, quality),     false, "q",           "" },
+  { FIELD_ID_INTERVAL, READING_FIELD_INTERVAL, FIELD_WIRE_SCALED, 0,
+    offsetof(Reading, interval_ms), false, "interval_ms", "ms" },
+  { FIELD_ID_EVENT,   READING_FIELD_EVENT,   FIELD_WIRE_BYTES,  1,
+    offsetof(Reading, range_event), false, "range_ev",    "" },
+};
+
+static constexpr size_t valuesMax(uint8_t i = 0) {
+  return i == SCHEMA_FIELD_COUNT ? 0 :
+         (SCHEMA_FIELDS[i].wire == FIELD_WIRE_SCALED ? 5 : SCHEMA_FIELDS[i].param) + valuesMax(i + 1);
+}
+static_assert(valuesMax() <= SCHEMA_VALUES_MAX, "SCHEMA_VALUES_MAX too small for the registry");
+
+const FieldDef* schemaField(uint8_t id) {
+  for (uint8_t i = 0; i < SCHEMA_FIELD_COUNT; i++)
+    if (SCHEMA_FIELDS[i].id == id) return &SCHEMA_FIELDS[i];
+  return nullptr;
+}
+
+// Scaled: decimal with FIELD_FORM_DECIMALS. Bytes: one number, or a comma list.
+static void appendValue(const Reading& r, const FieldDef& f, bool present, String& out) {
+  if (f.wire == FIELD_WIRE_SCALED) { out += String(present ? fieldValue(r, f) : 0.0f, FIELD_FORM_DECIMALS); return; }
+  const uint8_t* b = fieldBytes(r, f);
+  for (uint8_t i = 0; i < f.param; i++) {
+    if (i) out += ',';
+    out += String(present ? b[i] : 0);
+  }
+}
+
+void schemaForm(const Reading& r, String& body) {
+  for (uint8_t i = 0; i < SCHEMA_FIELD_COUNT; i++) {
+    const FieldDef& f = SCHEMA_FIELDS[i];
+    bool present = r.fields & f.bit;
+    if (!present && !f.always) continue;
+    body += '&';
+    body += f.key;
+    body += '=';
+    appendValue(r, f, present, body);
+  }
+}
+
+void schemaPrint(const Reading& r) {
+  String line;
+  for (uint8_t i = 0; i < SCHEMA_FIELD_COUNT; i++) {
+    const FieldDef& f = SCHEMA_FIELDS[i];
+    if (!(r.fields & f.bit)) continue;
+    line += ' ';
+    line += f.key;
+    line += '=';
+    appendValue(r, f, true, line);
+    if (*f.unit) { line += ' '; line += f.unit; }
+  }
+  Serial.print(line);
+}
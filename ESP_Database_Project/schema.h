@@ -0,0 +1,115 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Reading Field Schema
+* File Name            : schema.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   One registry for every measurement a Reading can carry, so a new metric is
+*   one row here plus its Reading member, not a signature change in every
+*   upload function. Each field has:
+*     - id    : stable wire ID (never reused);
+*     - bit   : its READING_FIELD_* presence bit in Reading::fields;
+*     - wire  : FIELD_WIRE_SCALED (float sent as a scaled integer) or
+*               FIELD_WIRE_BYTES (fixed count of raw bytes);
+*     - param : decimals of the scale factor (scaled) or byte count (bytes);
+*     - key   : form field name and stand-in CSV column.
+*   Encoders walk the registry and emit only the fields present in a reading:
+*   formBody() as key=value pairs, the binary batch (batchcodec.h) as values
+*   behind a per-reading presence bitmap. The binary header repeats every
+*   field's id / wire / param, so a decoder that meets an unknown id still
+*   knows how many bytes to skip.
+*
+* Inputs:
+*   - Reading::fields and the members the registry points at.
+*
+* Outputs:
+*   - SCHEMA_FIELDS[] for the encoders and decoders.
+*   - schemaForm(): the field part of a form body.
+*   - schemaPrint(): " key=value unit" for the present fields.
+*
+* Example Application:
+*   for (uint8_t i = 0; i < SCHEMA_FIELD_COUNT; i++) {
+*     const FieldDef& f = SCHEMA_FIELDS[i];
+*     if (r.fields & f.bit) ...   // fieldValue(r, f) or fieldBytes(r, f)
+*   }
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "readings.h" (Reading, READING_FIELD_*)
+*
+* Usage Notes:
+*   - Adding a field: a Reading member, a READING_FIELD_* bit, a FIELD_ID_*
+*     and a row in SCHEMA_FIELDS (schema.cpp); then the sensor that fills it
+*     lists the bit in its kFields (sensors.h). server/ingest_standin.py
+*     stores it once its SCHEMA gains the id; until then it is skipped.
+*   - distance_cm and sound_db are always in form bodies (0.00 when absent):
+*     the hosted ingest.php requires both.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include "readings.h"
+
+// Wire IDs (binary batch header; server/ingest_standin.py SCHEMA).
+#define FIELD_ID_DIST      1      // distance_cm
+#define FIELD_ID_SOUND     2      // sound_db
+#define FIELD_ID_CLASSES   3      // cls[], percent (classify.h order)
+#define FIELD_ID_QUALITY   4      // QUALITY_* flags (quality.h)
+#define FIELD_ID_INTERVAL  5      // interval_ms, adaptive ranging (ranging.h)
+#define FIELD_ID_EVENT     6      // range_event, RANGE_EVENT_* (ranging.h)
+
+#define FIELD_WIRE_SCALED  0      // round(value * 10^param), zigzag delta, 0 = NaN
+#define FIELD_WIRE_BYTES   1      // param raw bytes
+
+#ifndef BATCH_DIST_DECIMALS
+#define BATCH_DIST_DECIMALS   1
+#endif
+#ifndef BATCH_SOUND_DECIMALS
+#define BATCH_SOUND_DECIMALS  1
+#endif
+#define FIELD_FORM_DECIMALS   2   // scaled fields in form bodies, as before the schema
+
+struct FieldDef {
+  uint8_t     id;        // FIELD_ID_*
+  uint8_t     bit;       // READING_FIELD_*
+  uint8_t     wire;      // FIELD_WIRE_*
+  uint8_t     param;     // decimals (scaled) or byte count (bytes)
+  uint8_t     offset;    // offsetof(Reading, member)
+  bool        always;    // sent in form bodies even when absent
+  const char* key;       // form field / CSV column
+  const char* unit;      // for schemaPrint()
+};
+
+#define SCHEMA_FIELD_COUNT 6
+// Largest binary encoding of all fields: 5 per scaled field (32-bit zigzag
+// varint), param per bytes field. Checked against the table in schema.cpp.
+#define SCHEMA_VALUES_MAX  (5 + 5 + READING_CLASSES + 1 + 5 + 1)
+
+extern const FieldDef SCHEMA_FIELDS[SCHEMA_FIELD_COUNT];
+
+// Registry row for a wire ID, or nullptr.
+const FieldDef* schemaField(uint8_t id);
+
+// Value of a FIELD_WIRE_SCALED field.
+static inline float fieldValue(const Reading& r, const FieldDef& f) {
+  float v;
+  memcpy(&v, (const uint8_t*)&r + f.offset, sizeof(v));
+  return v;
+}
+static inline void fieldSetValue(Reading& r, const FieldDef& f, float v) {
+  memcpy((uint8_t*)&r + f.offset, &v, sizeof(v));
+}
+
+// Bytes of a FIELD_WIRE_BYTES field (f.param of them).
+static inline const uint8_t* fieldBytes(const Reading& r, const FieldDef& f) { return (const uint8_t*)&r + f.offset; }
+static inline uint8_t* fieldBytes(Reading& r, const FieldDef& f) { return (uint8_t*)&r + f.offset; }
+
+// Append "&key=value" for each present field (and each 'always' one) to body.
+void schemaForm(const Reading& r, String& body);
+
+// " key=value unit" for each present field on Serial.
+void schemaPrint(const Reading& r);
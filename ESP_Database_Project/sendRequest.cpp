@@ -10,17 +10,16 @@
 *   Provide helper routines for the ESP8266 sketch:                                              *
 *   - connectionDetails(): print current Wi-Fi connection info to Serial.                        *
 *   - postToServer(): perform an HTTPS POST (URL-encoded form) to a backend API.                 *
+*   - postToServerSigned(): plain-HTTP POST with an HMAC-SHA256 header (LAN gateways).          *
 *                                                                                               *
 * Inputs:                                                                                        *
 *   connectionDetails(): none (reads current Wi-Fi state).                                       *
 *   postToServer():                                                                              *
 *     - baseUrl   : Base URL (e.g., "https://example.com/api").                                  *
 *     - path      : Path appended to baseUrl (e.g., "/ingest.php").                              *
-*     - nodeName  : Logical node identifier string.                                              *
+*     - r         : Reading (node, seq, fields present per schema.h).                            *
 *     - isoUtc    : ISO-8601 UTC timestamp string.                                               *
 *     - tzRegion  : IANA time zone string (e.g., "America/Los_Angeles").                         *
-*     - distance_cm : Distance reading in centimeters.                                           *
-*     - sound_db    : Relative sound level reading.                                              *
 *     - httpCodeOut : (out) HTTP status code returned by server.                                 *
 *     - bodyOut     : (out) Response payload as a String.                                        *
 *                                                                                               *
@@ -36,13 +35,17 @@
 * Dependencies:                                                                                  *
 *   - Arduino core for ESP8266                                                                   *
 *   - <ESP8266WiFi.h>, <WiFiClientSecureBearSSL.h>, <ESP8266HTTPClient.h>                        *
+*   - <bearssl/bearssl.h> (HMAC-SHA256 for postToServerSigned)                                   *
+*   - "compress.h" (batch body compression for postBatch)                                        *
+*   - "readings.h", "schema.h" (Reading and its field registry for the form body)                *
+*   - "netstats.h" (bytes / requests / radio time of every POST)                                 *
+*   - "readings.h" (captureTime() for the X-Trace-Sent header)                                   *
 *   - "sendRequest.h" (declarations for these functions)                                         *
 *                                                                                               *
 * Usage Notes:                                                                                   *
-*   - TLS is set to "insecure" (certificate not validated). For production, configure proper     *
-*     certificate validation (fingerprint or CA cert).                                           *
+*   - TLS verification follows config().tls_mode: insecure (default), pinned public key /        *
+*     certificate fingerprint, or full CA validation (see tls.h).                                *
 *   - Body fields are URL-encoded to be safe for form submission.                                *
-*   - Keep the code logic identical to the original (comments added only).                       *
 * ------------------------------------------------------------------------------------------------
 */
 
@@ -50,7 +53,14 @@
 #include <ESP8266WiFi.h>
 #include <WiFiClientSecureBearSSL.h>
 #include <ESP8266HTTPClient.h>
+#include <bearssl/bearssl.h>
 #include "sendRequest.h"
+#include "readings.h"
+#include "tls.h"
+#include "config.h"
+#include "compress.h"
+#include "netstats.h"
+#include "schema.h"
 
 // Print a summary of the current Wi-Fi connection.
 // Single, unique definition so sketches can call it from setup().
@@ -94,50 +104,285 @@ static String urlEncode(const String& s) {
   return out;
 }
 
+// Build the URL-encoded reading shared by every transport.
+// "<sec><ms as 3 digits>" without 64-bit printf (not in every libc build).
+static String epochMs(uint32_t sec, uint16_t ms) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%lu%03u", (unsigned long)sec, (unsigned)ms);
+  return String(buf);
+}
+
+String formBody(const Reading& r, const String& isoUtc, const String& tzRegion,
+                uint32_t captureSec, uint16_t captureMs) {
+  String body = "node_name="     + urlEncode(readingNodeName(r.node)) +
+                "&measured_iso=" + urlEncode(isoUtc) +
+                "&tz_region="    + urlEncode(tzRegion);
+  schemaForm(r, body);   // distance_cm, sound_db, then whatever else is present
+  if (r.seq) {
+    body += "&node_id=" + nodeId();
+    body += "&seq=" + String(r.seq);
+    if (captureSec) body += "&cap_ms=" + epochMs(captureSec, captureMs);
+  }
+  return body;
+}
+
+String traceId(uint32_t seq) {
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%08lx%08lx", (unsigned long)ESP.getChipId(), (unsigned long)seq);
+  return String(buf);
+}
+
+// X-Trace-* headers (see UploadTrace in sendRequest.h).
+static void addTraceHeaders(HTTPClient& http, const UploadTrace* trace) {
+  if (!trace || !trace->seq) return;
+  http.addHeader("X-Trace-Id", traceId(trace->seq));
+  if (trace->captureSec) http.addHeader("X-Trace-Capture", epochMs(trace->captureSec, trace->captureMs));
+  uint32_t sec; uint16_t ms;
+  if (captureTime(sec, ms)) http.addHeader("X-Trace-Sent", epochMs(sec, ms));
+}
+
 // Perform an HTTPS POST with URL-encoded form data.
 // NOTE: do NOT mark this function 'static' and do NOT put it inside a namespace.
 // Returns true if an HTTP transaction was attempted; status is placed in httpCodeOut.
 bool postToServer(
   const String& baseUrl,
   const String& path,
-  const String& nodeName,
+  const Reading& r,
   const String& isoUtc,
   const String& tzRegion,
-  float distance_cm,
-  float sound_db,
   int& httpCodeOut,
-  String& bodyOut
+  String& bodyOut,
+  const UploadTrace* trace
 ) {
   httpCodeOut = 0; 
   bodyOut = "";
 
-  // Use a secure client; setInsecure() skips certificate verification.
-  std::unique_ptr<BearSSL::WiFiClientSecure> client(new BearSSL::WiFiClientSecure);
-  client->setInsecure();
-
-  HTTPClient https;
-
   // Compose full URL (e.g., https://domain.com/api/ingest.php).
   String full = baseUrl + path;
-  if (!https.begin(*client, full)) return false; // begin() failed to init
-
-  // Send classic form data.
-  https.addHeader("Content-Type", "application/x-www-form-urlencoded");
 
   // Build URL-encoded body.
-  String body = "node_name="     + urlEncode(nodeName) +
-                "&measured_iso=" + urlEncode(isoUtc) +
-                "&tz_region="    + urlEncode(tzRegion) +
-                "&distance_cm="  + String(distance_cm, 2) +
-                "&sound_db="     + String(sound_db, 2);
+  String body = formBody(r, isoUtc, tzRegion, trace ? trace->captureSec : 0, trace ? trace->captureMs : 0);
+
+  // Server verification follows config().tls_mode (see tls.h). In pinned mode
+  // each attempt tries another pin; a pin mismatch fails the handshake before
+  // anything is sent, so moving on to the next pin cannot duplicate the POST.
+  const uint8_t attempts = tlsAttempts();
+  for (uint8_t attempt = 0; attempt < attempts; attempt++) {
+    std::unique_ptr<BearSSL::WiFiClientSecure> client(new BearSSL::WiFiClientSecure);
+    if (!tlsApply(*client, attempt)) return false;  // no trust material: fail closed
+
+    HTTPClient https;
+    if (!https.begin(*client, full)) return false; // begin() failed to init
+
+    // Send classic form data.
+    https.addHeader("Content-Type", "application/x-www-form-urlencoded");
+    addTraceHeaders(https, trace);
 
-  // Execute POST and collect results.
-  httpCodeOut = https.POST(body);
-  bodyOut = https.getString();
+    // Execute POST and collect results.
+    uint32_t t0 = millis();
+    httpCodeOut = https.POST(body);
+    if (httpCodeOut == HTTPC_ERROR_CONNECTION_FAILED && attempt + 1 < attempts && tlsVerifyFailed(*client)) {
+      Serial.printf("[tls] %s rejected, trying next pin\n", tlsAttemptName(attempt));
+      netHttp(0, 0, true, false, httpCodeOut, millis() - t0);
+      https.end();
+      continue;
+    }
+    if (httpCodeOut > 0) tlsMarkGood(attempt);
+    bodyOut = https.getString();
+    netHttp(httpCodeOut > 0 ? body.length() : 0, bodyOut.length(), true, httpCodeOut > 0, httpCodeOut, millis() - t0);
 
-  // Always end() to free resources.
-  https.end();
+    // Always end() to free resources.
+    https.end();
+    break;
+  }
 
   // Return whether we at least attempted an HTTP request (httpCodeOut > 0).
   return (httpCodeOut > 0);
 }
+
+// Lower-case hex of the chip ID; identifies the node (and its key) to the gateway.
+String nodeId() {
+  char buf[9];
+  snprintf(buf, sizeof(buf), "%08lx", (unsigned long)ESP.getChipId());
+  return String(buf);
+}
+
+// HMAC-SHA256 over the canonical request:
+//   "<nodeId>\n<seq>\n<path>\n<body>"
+// Binding node, sequence and path stops a captured body from being replayed
+// under another sequence number or against another endpoint.
+static String signRequest(const uint8_t* key, size_t keyLen, const String& id,
+                          uint32_t seq, const String& path, const String& body) {
+  br_hmac_key_context kc;
+  br_hmac_context hc;
+  br_hmac_key_init(&kc, &br_sha256_vtable, key, keyLen);
+  br_hmac_init(&hc, &kc, 0);
+
+  char seqBuf[11];
+  snprintf(seqBuf, sizeof(seqBuf), "%lu", (unsigned long)seq);
+  br_hmac_update(&hc, id.c_str(), id.length());
+  br_hmac_update(&hc, "\n", 1);
+  br_hmac_update(&hc, seqBuf, strlen(seqBuf));
+  br_hmac_update(&hc, "\n", 1);
+  br_hmac_update(&hc, path.c_str(), path.length());
+  br_hmac_update(&hc, "\n", 1);
+  br_hmac_update(&hc, body.c_str(), body.length());
+
+  uint8_t mac[32];
+  br_hmac_out(&hc, mac);
+
+  const char* hex = "0123456789abcdef";
+  char out[65];
+  for (uint8_t i = 0; i < 32; i++) {
+    out[2 * i]     = hex[mac[i] >> 4];
+    out[2 * i + 1] = hex[mac[i] & 0xF];
+  }
+  out[64] = '\0';
+  return String(out);
+}
+
+bool nodeKeySet(const uint8_t* key, size_t keyLen) {
+  uint8_t any = 0;
+  for (size_t i = 0; i < keyLen; i++) any |= key[i];
+  if (!any) Serial.println(F("[ERROR] node_key not set (cfg set node_key <64 hex>)"));
+  return any != 0;
+}
+
+// Plain-HTTP POST authenticated with a per-node HMAC (trusted LAN gateways).
+// Same body and return convention as postToServer(); no TLS handshake.
+bool postToServerSigned(
+  const String& baseUrl,
+  const String& path,
+  const Reading& r,
+  const String& isoUtc,
+  const String& tzRegion,
+  const uint8_t* key,
+  size_t keyLen,
+  int& httpCodeOut,
+  String& bodyOut,
+  const UploadTrace* trace
+) {
+  httpCodeOut = 0;
+  bodyOut = "";
+  if (!nodeKeySet(key, keyLen)) return false;   // never sign with the zero key: fail closed
+
+  WiFiClient client;
+  HTTPClient http;
+
+  String full = baseUrl + path;
+  if (!http.begin(client, full)) return false;
+
+  String body = formBody(r, isoUtc, tzRegion, trace ? trace->captureSec : 0, trace ? trace->captureMs : 0);
+  String id = nodeId();
+  uint32_t seq = r.seq;
+
+  http.addHeader("Content-Type", "application/x-www-form-urlencoded");
+  http.addHeader("X-Node-Id", id);
+  http.addHeader("X-Node-Seq", String(seq));
+  http.addHeader("X-Node-Sig", signRequest(key, keyLen, id, seq, path, body));
+  addTraceHeaders(http, trace);
+
+  uint32_t t0 = millis();
+  httpCodeOut = http.POST(body);
+  bodyOut = http.getString();
+  http.end();
+  netHttp(httpCodeOut > 0 ? body.length() : 0, bodyOut.length(), false, false, httpCodeOut, millis() - t0);
+
+  return (httpCodeOut > 0);
+}
+
+// Peer support for HS_CONTENT_ENCODING, learned from responses:
+// -1 not known yet, 0 refused / not advertised, 1 advertised.
+static int8_t g_peerCoding = -1;
+
+// One POST of 'data' on an already configured client. Records the server's
+// Accept-Encoding so the next batch knows whether to compress.
+static int batchExchange(WiFiClient& client, const String& url, const uint8_t* data, size_t len,
+                         const char* contentType, bool encoded, bool tls, const UploadTrace* trace,
+                         String& bodyOut) {
+  HTTPClient http;
+  if (!http.begin(client, url)) return 0;
+  static const char* HEADERS[] = { "Accept-Encoding" };
+  http.collectHeaders(HEADERS, 1);
+  http.addHeader("Content-Type", contentType);
+  if (encoded) http.addHeader("Content-Encoding", HS_CONTENT_ENCODING);
+  addTraceHeaders(http, trace);
+  uint32_t t0 = millis();
+  int code = http.POST(data, len);
+  size_t rx = 0;
+  if (code > 0) {
+    g_peerCoding = (http.header("Accept-Encoding").indexOf(HS_CONTENT_ENCODING) >= 0) ? 1 : 0;
+    bodyOut = http.getString();
+    rx = bodyOut.length();
+  }
+  http.end();
+  netHttp(code > 0 ? len : 0, rx, tls, tls && code > 0, code, millis() - t0);
+  return code;
+}
+
+bool postBatch(
+  const String& baseUrl,
+  const String& path,
+  const uint8_t* body,
+  size_t bodyLen,
+  const char* contentType,
+  uint8_t compress,
+  int& httpCodeOut,
+  String& bodyOut,
+  const UploadTrace* trace
+) {
+  httpCodeOut = 0;
+  bodyOut = "";
+  String full = baseUrl + path;
+
+  // Compress when the mode and the peer allow it and it actually saves bytes.
+  // ON only skips waiting for the advertisement; a refusal (415, or a reply
+  // without the coding in Accept-Encoding) turns it off like AUTO.
+  const uint8_t* data = body;
+  size_t len = bodyLen;
+  std::unique_ptr<uint8_t[]> packed;
+  bool tryCoding = compress != COMPRESS_OFF && g_peerCoding != 0 &&
+                   (compress == COMPRESS_ON || g_peerCoding == 1);
+  if (tryCoding && len > 0) packed.reset(new (std::nothrow) uint8_t[len]);
+  if (packed) {
+    uint32_t t0 = micros();
+    size_t n = hsCompress(data, len, packed.get(), len);
+    Serial.printf("[lz] %u -> %u B in %lu us\n", (unsigned)len, (unsigned)(n ? n : len), (unsigned long)(micros() - t0));
+    if (n) { data = packed.get(); len = n; }
+    else packed.reset();
+  }
+  bool encoded = (bool)packed;
+
+  for (;;) {
+    if (full.startsWith("http://")) {
+      WiFiClient client;
+      httpCodeOut = batchExchange(client, full, data, len, contentType, encoded, false, trace, bodyOut);
+    } else {
+      // Same pin rotation as postToServer(); see the note there.
+      const uint8_t attempts = tlsAttempts();
+      for (uint8_t attempt = 0; attempt < attempts; attempt++) {
+        std::unique_ptr<BearSSL::WiFiClientSecure> client(new BearSSL::WiFiClientSecure);
+        if (!tlsApply(*client, attempt)) return false;
+        httpCodeOut = batchExchange(*client, full, data, len, contentType, encoded, true, trace, bodyOut);
+        if (httpCodeOut == HTTPC_ERROR_CONNECTION_FAILED && attempt + 1 < attempts && tlsVerifyFailed(*client)) {
+          Serial.printf("[tls] %s rejected, trying next pin\n", tlsAttemptName(attempt));
+          continue;
+        }
+        if (httpCodeOut > 0) tlsMarkGood(attempt);
+        break;
+      }
+    }
+
+    // Server does not take the coding: resend once as identity.
+    if (httpCodeOut == 415 && encoded) {
+      Serial.println(F("[lz] server refused " HS_CONTENT_ENCODING ", resending uncompressed"));
+      g_peerCoding = 0;
+      data = body;
+      len = bodyLen;
+      encoded = false;
+      continue;
+    }
+    break;
+  }
+  return (httpCodeOut > 0);
+}
@@ -10,6 +10,11 @@
 *   Header for networking/utility helpers used by the ESP8266 sketch. Declares:
 *     - connectionDetails(): prints Wi-Fi connection information to Serial.
 *     - postToServer(): sends URL-encoded measurements to a backend over HTTPS.
+*     - postToServerSigned(): same body over plain HTTP, authenticated with a
+*       per-node HMAC-SHA256 and a sequence number (trusted LAN gateways).
+*     - nodeId(): chip-derived node identifier used by the signed mode.
+*     - traceId(): per-reading trace ID (nodeId + sequence number) sent in the
+*       X-Trace-* upload headers.
 *
 * Inputs:
 *   See function parameter docs below.
@@ -19,12 +24,13 @@
 *
 * Example Application:
 *   After connecting to Wi-Fi, call connectionDetails() to log network info.
-*   When a measurement is taken, call postToServer() with the timestamp,
-*   time zone, and sensor values to send data to your API endpoint.
+*   When a measurement is taken, call postToServer() with the Reading,
+*   timestamp and time zone to send data to your API endpoint.
 *
 * Dependencies:
 *   - Arduino core for ESP8266
 *   - <Arduino.h>, <ESP8266WiFi.h>
+*   - "readings.h" (Reading; its fields are encoded through schema.h)
 *
 * Usage Notes:
 *   - This file contains declarations only; implementations live in sendRequest.cpp.
@@ -35,22 +41,43 @@
 #pragma once
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
+#include "readings.h"
 
 // Declaration only: prints SSID, IP, RSSI, etc. to the Serial monitor.
 void connectionDetails();
 
+// End-to-end trace context of one upload. A reading's trace ID is
+// traceId(seq): nodeId() followed by its sequence number as 8 hex digits,
+// so it is unique per node and survives every retry and transport. A batch
+// is traced under the ID of its first (oldest) reading.
+// HTTP uploads send:
+//   X-Trace-Id      : traceId(seq)
+//   X-Trace-Capture : capture time of that reading, UTC epoch ms
+//   X-Trace-Sent    : node clock when the request went out, UTC epoch ms
+// CoAP and MQTT have no headers; there the server derives the same ID from
+// the node_id/seq and capture time inside the payload.
+struct UploadTrace {
+  uint32_t seq;          // first reading's sequence number (0 = untraced)
+  uint32_t captureSec;   // its capture time (UTC), 0 = unknown
+  uint16_t captureMs;
+};
+
 /**
  * Perform an HTTPS POST (implemented in sendRequest.cpp).
  *
  * @param baseUrl     Base URL, e.g., "https://markpulido.io/api"
  * @param path        Endpoint path, e.g., "/ingest.php"
- * @param nodeName    Logical node/sensor name to tag the reading
+ * @param r           The reading: node (sent as its name), the fields present
+ *                    in r.fields (schema.h), and r.seq, the per-node sequence
+ *                    number (seqNext(); 0 = none). A seq is sent as node_id/seq
+ *                    form fields so the server can drop a retry of a reading
+ *                    it already stored. Reuse it on retries.
  * @param isoUtc      ISO-8601 UTC timestamp, e.g., "2025-11-10T19:30:00Z"
  * @param tzRegion    IANA time zone name, e.g., "America/Los_Angeles"
- * @param distance_cm Distance measurement in centimeters
- * @param sound_db    Relative sound level (not calibrated SPL)
  * @param httpCodeOut (out) HTTP status code returned by the server
  * @param bodyOut     (out) Response body as a String
+ * @param trace       Capture time of the reading (see UploadTrace); sent as
+ *                    the cap_ms form field and X-Trace-* headers.
  *
  * @return true if an HTTP transaction was attempted (status in httpCodeOut),
  *         false if setup/connection failed before sending.
@@ -58,11 +85,91 @@ void connectionDetails();
 bool postToServer(
   const String& baseUrl,   // e.g. "https://markpulido.io/api"
   const String& path,      // e.g. "/ingest.php"
-  const String& nodeName,
+  const Reading& r,
   const String& isoUtc,    // "2025-11-10T19:30:00Z"
   const String& tzRegion,  // "America/Los_Angeles"
-  float distance_cm,
-  float sound_db,
   int& httpCodeOut,
-  String& bodyOut
+  String& bodyOut,
+  const UploadTrace* trace = nullptr
+);
+
+// URL-encoded reading body ("node_name=...&measured_iso=...&tz_region=..."
+// then one "&<key>=<value>" per field present in r.fields, schema.h:
+// distance_cm, sound_db (both always, 0.00 when absent), cls=<p0>,<p1>,...
+// (percent, classify.h order), q=<flags> (decimal, quality.h)), shared by
+// every transport. A non-zero r.seq appends "&node_id=<nodeId()>&seq=<seq>"
+// (server-side dedup key), and a capture time appends "&cap_ms=<UTC epoch ms>"
+// for latency tracing.
+String formBody(const Reading& r, const String& isoUtc, const String& tzRegion,
+                uint32_t captureSec = 0, uint16_t captureMs = 0);
+
+// Node identifier sent as X-Node-Id (lower-case hex chip ID).
+String nodeId();
+
+// 16 lower-case hex digits: chip ID, then 'seq'.
+String traceId(uint32_t seq);
+
+// False (and an error on Serial) if the HMAC key is still all zero, the
+// unprovisioned default; signed uploads then fail closed.
+bool nodeKeySet(const uint8_t* key, size_t keyLen);
+
+/**
+ * Perform a plain-HTTP POST signed with HMAC-SHA256 (implemented in sendRequest.cpp).
+ *
+ * Sends the same URL-encoded body as postToServer() plus three headers:
+ *   X-Node-Id  : nodeId()
+ *   X-Node-Seq : seq (decimal; must increase for every request from this node)
+ *   X-Node-Sig : hex HMAC-SHA256(key, nodeId + "\n" + seq + "\n" + path + "\n" + body)
+ * The gateway rejects bad signatures and any seq not above the last accepted one.
+ *
+ * @param key         Per-node HMAC key
+ * @param keyLen      Key length in bytes
+ * (other parameters as postToServer(); r.seq is the signed sequence number)
+ *
+ * @return true if an HTTP transaction was attempted (status in httpCodeOut);
+ *         false without sending when the key is unset (nodeKeySet()).
+ */
+bool postToServerSigned(
+  const String& baseUrl,   // e.g. "http://192.168.1.20:8080/api"
+  const String& path,      // e.g. "/ingest.php"
+  const Reading& r,
+  const String& isoUtc,
+  const String& tzRegion,
+  const uint8_t* key,
+  size_t keyLen,
+  int& httpCodeOut,
+  String& bodyOut,
+  const UploadTrace* trace = nullptr
+);
+
+/**
+ * POST a batch body: text/plain formBody() lines or the binary layout from
+ * batchcodec.h (implemented in sendRequest.cpp).
+ *
+ * https:// bases follow config().tls_mode; http:// bases (LAN gateway) go out
+ * in the clear. Depending on 'compress' (CompressMode, config.h) the body is
+ * sent with Content-Encoding: HS_CONTENT_ENCODING when that makes it smaller.
+ * The server's Accept-Encoding response header (RFC 7694) turns compression
+ * on in COMPRESS_AUTO; a 415 turns it off in both AUTO and ON and the batch
+ * is resent uncompressed.
+ *
+ * @param body        Payload bytes (BatchPayload::data())
+ * @param len         Payload length
+ * @param contentType "text/plain" or BATCH_CONTENT_TYPE
+ * @param compress    CompressMode
+ * @param trace       Oldest reading in the batch (X-Trace-* headers)
+ * (other parameters as postToServer())
+ *
+ * @return true if an HTTP transaction was attempted (status in httpCodeOut).
+ */
+bool postBatch(
+  const String& baseUrl,
+  const String& path,
+  const uint8_t* body,
+  size_t len,
+  const char* contentType,
+  uint8_t compress,
+  int& httpCodeOut,
+  String& bodyOut,
+  const UploadTrace* trace = nullptr
 );
@@ -0,0 +1,125 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Static Sensor Framework
+* File Name            : sensors.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Make adding a sensor one struct instead of edits in every layer. A sensor
+*   is a type deriving from Sensor<Itself, Schedule> that declares at compile
+*   time:
+*     - kNode    : READING_NODE_* it reports as (server name, sequence, flags);
+*     - kFields  : READING_FIELD_* mask of the Reading fields it fills; it
+*                  becomes the reading's presence bitmap (schema.h), so
+*                  only those fields are uploaded;
+*     - Value    : what one measurement yields;
+*     - measure(): take a measurement (false: nothing this pass);
+*     - encode() : write a Value into the Reading's fields.
+*   The Schedule policy (OnSwitch<>, SelfPaced) decides when measure() runs.
+*   SensorSet<A, B, ...> polls every sensor in order and hands each filled
+*   Reading to one sink (submitReading() in main.cpp), which uploads any
+*   node the same way.
+*   Everything is static and resolved at compile time: no instances, no
+*   vtables, no heap; the fold over the set inlines to the same calls a
+*   hand-written loop() would make.
+*
+* Inputs:
+*   - SensorTick per loop() pass: millis() and the debounced button
+*     (check_switch() in main.cpp).
+*
+* Outputs:
+*   - SensorSet<...>::service(tick, sink): readings produced this pass.
+*   - SensorSet<...>::busy(): a sensor is mid-measurement; loop() must not sleep.
+*
+* Example Application:
+*   struct Lux : Sensor<Lux, SelfPaced> {
+*     static constexpr uint8_t kNode = READING_NODE_SOUND;
+*     static constexpr uint8_t kFields = READING_FIELD_SOUND;
+*     typedef float Value;
+*     static bool measure(Value& v) { v = analogRead(A0); return true; }
+*     static void encode(const Value& v, Reading& r) { r.sound_db = v; }
+*   };
+*   typedef SensorSet<Ultra, Sound, Lux> Sensors;
+*   Sensors::service(tick, [](const Reading& r) { submitReading(r); });
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "readings.h" (Reading, READING_NODE_*, READING_FIELD_*), "schema.h"
+*
+* Usage Notes:
+*   - Header-only: the set must be visible where it is serviced to be inlined.
+*   - A sensor that samples across several passes (classifier frames, fast
+*     ranging) overrides busy(); the default is false.
+*   - Order in the set is poll order within one pass.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include "readings.h"
+#include "schema.h"
+
+// What the schedules see of one loop() pass.
+struct SensorTick {
+  uint32_t ms;           // millis()
+  uint8_t  pressed;      // READING_NODE_* of the debounced button, 0 if none
+};
+
+// Schedule: measure when the button for Node was pressed this pass.
+template <uint8_t Node>
+struct OnSwitch {
+  static_assert(Node != 0, "a switch schedule needs a node");
+  static inline bool due(const SensorTick& t) { return t.pressed == Node; }
+};
+
+// Schedule: poll every pass; measure() keeps its own clock and returns false
+// until it has a value.
+struct SelfPaced {
+  static inline bool due(const SensorTick&) { return true; }
+};
+
+// CRTP base: D supplies kNode, kFields, Value, measure() and encode().
+template <class D, class Schedule>
+struct Sensor {
+  static inline bool busy() { return false; }
+
+  // Measure when due and build the Reading (time and seq are stamped on submit).
+  static inline bool poll(const SensorTick& t, Reading& r) {
+    static_assert(D::kNode != 0, "sensor needs a READING_NODE_* id");
+    static_assert(D::kFields != 0, "sensor must fill at least one field");
+    if (!Schedule::due(t)) return false;
+    typename D::Value v;
+    if (!D::measure(v)) return false;
+    r = Reading();
+    r.node = D::kNode;
+    r.fields = D::kFields;
+    D::encode(v, r);
+    return true;
+  }
+
+  // "[node] key=value ..." for the declared fields only.
+  static void print(const Reading& r) {
+    Serial.printf("[%s]", readingNodeName(D::kNode));
+    schemaPrint(r);
+    Serial.println();
+  }
+};
+
+// A fixed set of sensors, serviced in order.
+template <class... S>
+struct SensorSet {
+  static_assert(sizeof...(S) > 0, "empty sensor set");
+
+  // Poll each sensor; every reading goes to sink(const Reading&). Returns the count.
+  template <class Sink>
+  static inline uint8_t service(const SensorTick& t, Sink&& sink) {
+    uint8_t n = 0;
+    Reading r;
+    ((S::poll(t, r) ? (S::print(r), sink(r), ++n) : 0), ...);
+    return n;
+  }
+
+  static inline bool busy() { return (S::busy() || ...); }
+};
@@ -0,0 +1,85 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Upload Sequence Numbers
+* File Name            : sequence.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Block-reserved, flash-backed sequence counter (see sequence.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <EEPROM.h>
+*   - "config.h", "sequence.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "config.h"
+#include "sequence.h"
+
+#define SEQ_MAGIC 0x5153u   // "SQ"
+
+// Stored bound plus its bitwise complement as a cheap integrity check.
+struct __attribute__((packed)) SeqRecord {
+  uint16_t magic;
+  uint32_t reserved;    // every number below this may already have been used
+  uint32_t check;       // ~reserved
+};
+
+static_assert(CONFIG_SEQ_OFFSET + sizeof(SeqRecord) <= CONFIG_EEPROM_SIZE,
+              "SeqRecord does not fit the EEPROM area");
+
+static uint32_t g_next = 1;       // next number to hand out
+static uint32_t g_reserved = 1;   // first number NOT covered by flash
+static uint32_t g_last = 0;
+
+static bool readRecord(int offset, uint32_t& reserved) {
+  SeqRecord r;
+  EEPROM.get(offset, r);
+  if (r.magic != SEQ_MAGIC || r.check != ~r.reserved) return false;
+  reserved = r.reserved;
+  return true;
+}
+
+void seqBegin() {
+  uint32_t reserved;
+  if (readRecord(CONFIG_SEQ_OFFSET, reserved)) {
+    g_next = g_reserved = reserved;
+  } else if (readRecord(CONFIG_SEQ_OFFSET_V1, reserved)) {
+    // Pre-v6 location, about to be covered by the larger NodeConfig: move the
+    // bound now so numbers keep increasing after the next config commit.
+    SeqRecord r = { SEQ_MAGIC, reserved, ~reserved };
+    EEPROM.put(CONFIG_SEQ_OFFSET, r);
+    EEPROM.commit();
+    g_next = g_reserved = reserved;
+  } else {
+    g_next = g_reserved = 1;
+  }
+  Serial.printf("[seq] resuming at %lu\n", (unsigned long)g_next);
+}
+
+uint32_t seqNext() {
+  if (g_next >= g_reserved) {
+    SeqRecord r;
+    r.magic = SEQ_MAGIC;
+    r.reserved = g_next + SEQ_RESERVE_BLOCK;
+    r.check = ~r.reserved;
+    EEPROM.put(CONFIG_SEQ_OFFSET, r);
+    // Persist before handing out any number of the new block: a number past
+    // an unsaved bound would be issued again after a reboot.
+    bool saved = false;
+    for (uint8_t i = 0; i < SEQ_COMMIT_TRIES && !saved; i++) saved = EEPROM.commit();
+    if (!saved) {
+      Serial.println(F("[seq] commit FAILED, no number issued"));
+      return 0;
+    }
+    g_reserved = r.reserved;
+  }
+  g_last = g_next++;
+  return g_last;
+}
+
+uint32_t seqLast() { return g_last; }
@@ -0,0 +1,57 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Upload Sequence Numbers
+* File Name            : sequence.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Hand out a strictly increasing per-node upload sequence number that keeps
+*   increasing across reboots, without a flash write per upload.
+*   Every reading is tagged with one (readingPush(), transmit()) and keeps it
+*   across retries and replays; the ingest side drops (node, seq) pairs it has
+*   already stored, which makes uploads idempotent.
+*
+* Inputs:
+*   - EEPROM record at CONFIG_SEQ_OFFSET (see config.h).
+*
+* Outputs:
+*   - seqNext(): next sequence number (never repeats for this node), or 0
+*     when the new block bound could not be saved.
+*
+* Example Application:
+*   configBegin();            // opens the EEPROM sector
+*   seqBegin();
+*   uint32_t seq = seqNext(); // tag an upload
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <EEPROM.h>
+*   - "config.h"
+*
+* Usage Notes:
+*   - Numbers are reserved in blocks of SEQ_RESERVE_BLOCK. Only the block's upper
+*     bound is written to flash, so a commit happens once per block. After a
+*     reset the counter resumes at the last reserved bound; the unused tail of
+*     that block is skipped (gaps are fine, repeats are not).
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#ifndef SEQ_RESERVE_BLOCK
+#define SEQ_RESERVE_BLOCK 64
+#endif
+#define SEQ_COMMIT_TRIES  3       // EEPROM.commit() attempts per block
+
+// Load the reserved bound from flash. Call after configBegin().
+void seqBegin();
+
+// Next sequence number (starts at 1). May commit flash once per block;
+// returns 0 (nothing issued) if that commit keeps failing. Callers must not
+// upload with 0 and ask again later.
+uint32_t seqNext();
+
+// Most recently issued number (0 if none yet this boot).
+uint32_t seqLast();
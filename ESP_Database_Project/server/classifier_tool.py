@@ -0,0 +1,545 @@
+#!/usr/bin/env python3
+"""
+Project/Program Name : ESP8266 Dual Sensor Demo - Acoustic Classifier Tooling
+File Name            : server/classifier_tool.py
+Author               : Mark P.
+Date                 : 18 OCT 2026
+Version              : 1.0.0
+
+Purpose:
+  Host side of the on-device acoustic event classifier (classify.h):
+    synth   write labelled synthetic traces (raw ADC counts) for a first model
+            or a smoke test of the pipeline
+    train   compute features, train the 32-16-5 network, quantize it to int8
+            and write ../classify_weights.h
+    eval    run the bit-exact fixed-point pipeline and int8 network over
+            recorded traces: accuracy, confusion matrix, and CPU cost per
+            window on the node
+  The feature front end here mirrors classify.cpp operation for operation
+  (Q15 Hann window and twiddles, 64-bit FFT products, Q8 mel weights, Q8
+  log2), so features and class decisions match the node's for the same
+  samples and bias.
+
+Trace format:
+  Text, one raw ADC count (0..1023) per line, '#' comments allowed.
+  A "# fs=<Hz> label=<class>" comment sets the sample rate and label;
+  otherwise the label is the file name up to the first '_' or '-' and
+  fs defaults to 5000. Capture them from the node with the sound sketch or
+  any serial logger at the node's target_fs.
+
+Usage:
+  python3 classifier_tool.py synth --out traces/ [--files 6] [--seconds 10] [--seed 1]
+  python3 classifier_tool.py train traces/*.txt [--header ../classify_weights.h]
+  python3 classifier_tool.py eval  held_out/*.txt [--header ../classify_weights.h]
+                                   [--frame-cycles N --infer-cycles N]
+
+  --frame-cycles / --infer-cycles take the "classifier" rows of the node's
+  sampling benchmark (-DSAMPLING_BENCH); without them eval prices the
+  operation counts with the per-operation estimates in CYCLE_MODEL.
+
+Dependencies:
+  Python 3.8+ standard library only.
+"""
+
+import argparse
+import glob
+import math
+import os
+import random
+import re
+import textwrap
+
+# ---- Must match classify.h ----
+CLASSES = ("background", "traffic", "voices", "alarm", "machinery")
+FFT_N = 256
+FFT_LOG2 = 8
+BINS = FFT_N // 2 + 1
+MELS = 16
+FRAMES = 8
+FRAMES_LOG2 = 3
+FEATURES = 2 * MELS
+HIDDEN = 16
+MEL_LO_HZ = 100.0
+LUT_FRAC = 13                       # adccal.h ADC_VOLTS_FRAC
+IDEAL_FULL_MV = 3300                # adccal.h ADC_IDEAL_FULL_MV
+BIAS_SHIFT = 12                     # bias.h
+
+# Cycles per operation on the ESP8266 (LX106 at 80 MHz), used when the
+# benchmark figures are not given. 64-bit multiplies go through libgcc.
+CYCLE_MODEL = {"adc_read": 0, "mul64": 36, "butterfly_misc": 24, "bin": 60,
+               "log": 40, "mac8": 6, "softmax": 2500, "frame_misc": 2000}
+
+
+def lround(x):
+    """C lround(): nearest, halves away from zero."""
+    return int(math.floor(abs(x) + 0.5)) * (1 if x >= 0 else -1)
+
+
+# ================== Tables (classifyTables() in classify.cpp) ==================
+def hann_q15():
+    return [lround(32767.0 * (0.5 - 0.5 * math.cos(2.0 * math.pi * n / FFT_N))) for n in range(FFT_N // 2 + 1)]
+
+
+def twiddles_q15():
+    cos_t = [lround(32767.0 * math.cos(2.0 * math.pi * k / FFT_N)) for k in range(FFT_N // 2)]
+    sin_t = [lround(32767.0 * math.sin(2.0 * math.pi * k / FFT_N)) for k in range(FFT_N // 2)]
+    return cos_t, sin_t
+
+
+def mel_table(fs):
+    """Per bin: (segment, rising weight Q8) or (0xFF, 0) outside the filter bank."""
+    def mel(f):
+        return 2595.0 * math.log10(1.0 + f / 700.0)
+
+    def hz(m):
+        return 700.0 * (10.0 ** (m / 2595.0) - 1.0)
+    lo, hi = mel(MEL_LO_HZ), mel(fs / 2.0)
+    pts = [hz(lo + (hi - lo) * i / (MELS + 1)) for i in range(MELS + 2)]
+    table = []
+    for k in range(BINS):
+        f = k * fs / float(FFT_N)
+        seg = 0xFF
+        w = 0
+        for j in range(MELS + 1):
+            if pts[j] <= f < pts[j + 1]:
+                seg = j
+                w = lround(255.0 * (f - pts[j]) / (pts[j + 1] - pts[j]))
+                break
+        table.append((seg, w))
+    return table
+
+
+def ideal_lut():
+    lut = [lround(i * IDEAL_FULL_MV / 1000.0 / 1023 * (1 << LUT_FRAC)) for i in range(1024)]
+    return lut + [lut[-1]]
+
+
+# ================== Fixed-point front end ==================
+def _trunc64(v):
+    return ((v + (1 << 63)) & ((1 << 64) - 1)) - (1 << 63)
+
+
+def log2_q8(e):
+    """classify.cpp log2Q8(): integer part from the leading bit, 8 fraction
+    bits taken linearly from the bits below it."""
+    if e <= 0:
+        return 0
+    n = e.bit_length() - 1
+    frac = ((e << (63 - n)) & ((1 << 64) - 1)) >> 55 & 0xFF
+    return n * 256 + frac
+
+
+class FrontEnd:
+    def __init__(self, fs):
+        self.fs = fs
+        self.hann = hann_q15()
+        self.cos, self.sin = twiddles_q15()
+        self.mel = mel_table(fs)
+        self.lut = ideal_lut()
+        self.rev = [int(format(i, "0%db" % FFT_LOG2)[::-1], 2) for i in range(FFT_N)]
+
+    def fft(self, re, im):
+        n = FFT_N
+        re = [re[self.rev[i]] for i in range(n)]
+        im = [im[self.rev[i]] for i in range(n)]
+        half = 1
+        while half < n:
+            step = n // (2 * half)
+            for start in range(0, n, 2 * half):
+                for k in range(half):
+                    wr, wi = self.cos[k * step], -self.sin[k * step]
+                    i, j = start + k, start + k + half
+                    tr = _trunc64(wr * re[j] - wi * im[j]) >> 15
+                    ti = _trunc64(wr * im[j] + wi * re[j]) >> 15
+                    re[j], im[j] = re[i] - tr, im[i] - ti
+                    re[i], im[i] = re[i] + tr, im[i] + ti
+            half *= 2
+        return re, im
+
+    def frame(self, raw, mid):
+        """256 raw counts, bias in Q13 volts -> MELS log2 energies (Q8)."""
+        re = []
+        for n, r in enumerate(raw):
+            x = self.lut[r] - mid
+            w = self.hann[n if n <= FFT_N // 2 else FFT_N - n]
+            re.append((x * w) >> 15)
+        re, im = self.fft(re, [0] * FFT_N)
+        e = [0] * MELS
+        for k in range(BINS):
+            seg, w = self.mel[k]
+            if seg == 0xFF:
+                continue
+            p = re[k] * re[k] + im[k] * im[k]
+            if seg < MELS:
+                e[seg] += p * w
+            if seg > 0:
+                e[seg - 1] += p * (255 - w)
+        return [log2_q8(v) for v in e]
+
+    def windows(self, samples):
+        """Yield one FEATURES vector per FRAMES x FFT_N samples. The bias is
+        tracked as bias.h does, seeded with the trace's first-frame mean
+        (the node restores its tracked bias at boot)."""
+        first = samples[:FFT_N]
+        bias = (sum(first) << 16) // max(len(first), 1)
+        step = FRAMES * FFT_N
+        for w0 in range(0, len(samples) - step + 1, step):
+            logs = []
+            for f in range(FRAMES):
+                raw = samples[w0 + f * FFT_N: w0 + (f + 1) * FFT_N]
+                i = min(bias >> 16, 1023)
+                frac = bias & 0xFFFF
+                mid = self.lut[i] + (((self.lut[i + 1] - self.lut[i]) * frac) >> 16)
+                for r in raw:
+                    bias += ((r << 16) - bias) >> BIAS_SHIFT
+                logs.append(self.frame(raw, mid))
+            yield features(logs)
+
+
+def features(logs):
+    """Per band: mean over the frames and mean absolute deviation (Q8)."""
+    mean = [sum(l[b] for l in logs) >> FRAMES_LOG2 for b in range(MELS)]
+    mad = [sum(abs(l[b] - mean[b]) for l in logs) >> FRAMES_LOG2 for b in range(MELS)]
+    return mean + mad
+
+
+# ================== Traces ==================
+def load_trace(path):
+    fs, label, samples = 5000, None, []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line.startswith("#"):
+                m = re.search(r"fs=(\d+)", line)
+                fs = int(m.group(1)) if m else fs
+                m = re.search(r"label=(\w+)", line)
+                label = m.group(1) if m else label
+                continue
+            samples.append(max(0, min(1024, int(line))))
+    if label is None:
+        label = re.split(r"[_\-.]", os.path.basename(path))[0]
+    if label not in CLASSES:
+        raise SystemExit("%s: unknown label %r (expected one of %s)" % (path, label, ", ".join(CLASSES)))
+    return fs, CLASSES.index(label), samples
+
+
+def dataset(paths):
+    xs, ys, front = [], [], {}
+    for p in paths:
+        fs, y, samples = load_trace(p)
+        fe = front.setdefault(fs, FrontEnd(fs))
+        for x in fe.windows(samples):
+            xs.append(x)
+            ys.append(y)
+    if not xs:
+        raise SystemExit("no complete windows (%d samples each) in the traces" % (FRAMES * FFT_N))
+    return xs, ys, sorted(front)
+
+
+# ================== Synthetic traces ==================
+def synth_trace(label, seconds, fs, rng):
+    n = int(seconds * fs)
+    bias = rng.uniform(490, 530)
+    out = []
+    t = 0.0
+    lp = hp = 0.0
+    f0 = rng.uniform(100, 240)
+    tones = [rng.uniform(300, 1200) for _ in range(3)]
+    hum = rng.choice((50.0, 60.0))
+    alarm_f = rng.uniform(900, 2300)
+    beep = rng.uniform(2.0, 5.0)
+    siren = rng.random() < 0.5
+    phase = [0.0] * 12
+    gain = rng.uniform(0.5, 2.0)
+    for i in range(n):
+        t = i / fs
+        noise = rng.gauss(0.0, 1.0)
+        if label == "background":
+            v = rng.gauss(0.0, rng.uniform(0.4, 1.2)) * gain
+        elif label == "traffic":
+            lp += 0.04 * (noise - lp)                      # rumble below ~300 Hz
+            hp += 0.002 * (lp - hp)
+            env = 0.5 + 0.5 * math.sin(2 * math.pi * t / rng.uniform(4.0, 4.2))
+            v = (lp - hp) * 220.0 * gain * (0.3 + env) + rng.gauss(0, 0.8)
+        elif label == "voices":
+            syl = max(0.0, math.sin(2 * math.pi * 3.7 * t + math.sin(2 * math.pi * 0.7 * t)))
+            f = f0 * (1.0 + 0.05 * math.sin(2 * math.pi * 5 * t))
+            v = 0.0
+            for h in range(1, 12):
+                fh = f * h
+                if fh >= fs / 2:
+                    break
+                phase[h] += 2 * math.pi * fh / fs
+                formant = math.exp(-((fh - 700) / 300.0) ** 2) + 0.6 * math.exp(-((fh - 1800) / 400.0) ** 2) + 0.15
+                v += formant * math.sin(phase[h])
+            v = v * 18.0 * gain * syl + rng.gauss(0, 0.8)
+        elif label == "alarm":
+            f = alarm_f * (1.0 + 0.3 * math.sin(2 * math.pi * 0.8 * t)) if siren else alarm_f
+            phase[0] += 2 * math.pi * min(f, fs / 2 - 50) / fs
+            on = siren or (math.sin(2 * math.pi * beep * t) > 0)
+            v = (40.0 * gain * math.sin(phase[0]) if on else 0.0) + rng.gauss(0, 0.8)
+        else:  # machinery
+            v = 0.0
+            for h, a in ((1, 1.0), (2, 0.7), (3, 0.5)):
+                v += a * math.sin(2 * math.pi * hum * h * t)
+            for k, f in enumerate(tones):
+                phase[k + 4] += 2 * math.pi * f / fs
+                v += 1.2 * math.sin(phase[k + 4])
+            v = v * 20.0 * gain + rng.gauss(0, 3.0)
+        out.append(max(0, min(1023, int(round(bias + v)))))
+    return out
+
+
+def cmd_synth(args):
+    rng = random.Random(args.seed)
+    os.makedirs(args.out, exist_ok=True)
+    for label in CLASSES:
+        for k in range(args.files):
+            path = os.path.join(args.out, "%s_%02d.txt" % (label, k))
+            with open(path, "w") as f:
+                f.write("# fs=%d label=%s synthetic seed=%d\n" % (args.fs, label, args.seed))
+                f.write("\n".join(map(str, synth_trace(label, args.seconds, args.fs, rng))))
+                f.write("\n")
+    print("wrote %d traces to %s" % (args.files * len(CLASSES), args.out))
+
+
+# ================== Network ==================
+def standardise(xs):
+    mu = [sum(x[i] for x in xs) / len(xs) for i in range(FEATURES)]
+    sd = [max(math.sqrt(sum((x[i] - mu[i]) ** 2 for x in xs) / len(xs)), 8.0) for i in range(FEATURES)]
+    return mu, sd
+
+
+def softmax(z):
+    m = max(z)
+    e = [math.exp(v - m) for v in z]
+    s = sum(e)
+    return [v / s for v in e]
+
+
+def train_float(zs, ys, epochs, rng):
+    w1 = [[rng.gauss(0, math.sqrt(2.0 / FEATURES)) for _ in range(FEATURES)] for _ in range(HIDDEN)]
+    b1 = [0.0] * HIDDEN
+    w2 = [[rng.gauss(0, math.sqrt(1.0 / HIDDEN)) for _ in range(HIDDEN)] for _ in CLASSES]
+    b2 = [0.0] * len(CLASSES)
+    order = list(range(len(zs)))
+    lr = 0.05
+    for ep in range(epochs):
+        rng.shuffle(order)
+        loss = 0.0
+        for n in order:
+            x, y = zs[n], ys[n]
+            a = [b1[j] + sum(w1[j][i] * x[i] for i in range(FEATURES)) for j in range(HIDDEN)]
+            h = [max(0.0, v) for v in a]
+            p = softmax([b2[c] + sum(w2[c][j] * h[j] for j in range(HIDDEN)) for c in range(len(CLASSES))])
+            loss -= math.log(max(p[y], 1e-12))
+            g = [p[c] - (1.0 if c == y else 0.0) for c in range(len(CLASSES))]
+            gh = [sum(g[c] * w2[c][j] for c in range(len(CLASSES))) if a[j] > 0 else 0.0 for j in range(HIDDEN)]
+            for c in range(len(CLASSES)):
+                b2[c] -= lr * g[c]
+                for j in range(HIDDEN):
+                    w2[c][j] -= lr * g[c] * h[j]
+            for j in range(HIDDEN):
+                if gh[j]:
+                    b1[j] -= lr * gh[j]
+                    for i in range(FEATURES):
+                        w1[j][i] -= lr * gh[j] * x[i]
+        if ep % 10 == 9 or ep == epochs - 1:
+            print("epoch %3d  loss %.4f" % (ep + 1, loss / len(zs)))
+        lr *= 0.97
+    return w1, b1, w2, b2
+
+
+def quantize(mu, sd, w1, b1, w2, b2, zs):
+    """int8 weights, int32 biases and the requantisation constants of classify.cpp."""
+    x_scale = 4.0 / 127.0                                  # int8 input covers +/-4 sd
+    mul = [lround(65536.0 * 127.0 / (4.0 * s)) for s in sd]
+    s_w1 = max(abs(v) for row in w1 for v in row) / 127.0
+    w1q = [[lround(v / s_w1) for v in row] for row in w1]
+    s_a1 = s_w1 * x_scale
+    b1q = [lround(v / s_a1) for v in b1]
+    hmax = max(max(0.0, b1[j] + sum(w1[j][i] * z[i] for i in range(FEATURES))) for z in zs for j in range(HIDDEN))
+    s_h = max(hmax, 1e-3) / 127.0
+    m1 = lround((1 << 24) * s_a1 / s_h)
+    s_w2 = max(abs(v) for row in w2 for v in row) / 127.0
+    w2q = [[lround(v / s_w2) for v in row] for row in w2]
+    s_a2 = s_w2 * s_h
+    b2q = [lround(v / s_a2) for v in b2]
+    return {"mu": [lround(v) for v in mu], "mul": mul, "w1": w1q, "b1": b1q, "m1": m1,
+            "w2": w2q, "b2": b2q, "logit_scale": s_a2}
+
+
+def infer(q, f):
+    """classifyInfer() in classify.cpp: int8 network, float softmax."""
+    x = [max(-127, min(127, _trunc64((f[i] - q["mu"][i]) * q["mul"][i] + 32768) >> 16)) for i in range(FEATURES)]
+    h = []
+    for j in range(HIDDEN):
+        acc = q["b1"][j] + sum(q["w1"][j][i] * x[i] for i in range(FEATURES))
+        acc = max(acc, 0)
+        h.append(min(127, (acc * q["m1"] + (1 << 23)) >> 24))
+    z = [q["b2"][c] + sum(q["w2"][c][j] * h[j] for j in range(HIDDEN)) for c in range(len(CLASSES))]
+    return softmax([v * q["logit_scale"] for v in z])
+
+
+# ================== Header I/O ==================
+def c_list(vals, per_line=16, indent="  "):
+    lines = []
+    for i in range(0, len(vals), per_line):
+        lines.append(indent + ", ".join(str(v) for v in vals[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def write_header(path, q, note):
+    flat1 = [v for row in q["w1"] for v in row]
+    flat2 = [v for row in q["w2"] for v in row]
+    text = """/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Acoustic Classifier Weights
+* File Name            : classify_weights.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   int8 weights and requantisation constants of the 32-16-5 classifier
+*   (classify.h). Generated by server/classifier_tool.py train; do not edit.
+*   %s
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+// Feature normalisation: x = clamp(((f - mu) * mul + 2^15) >> 16, -127, 127).
+static const int16_t CLS_MU[%d] PROGMEM = {
+%s
+};
+static const int32_t CLS_MUL[%d] PROGMEM = {
+%s
+};
+
+// Hidden layer, row per unit; h = min(127, (max(acc, 0) * CLS_M1 + 2^23) >> 24).
+static const int8_t CLS_W1[%d * %d] PROGMEM = {
+%s
+};
+static const int32_t CLS_B1[%d] PROGMEM = {
+%s
+};
+#define CLS_M1 %dL
+
+// Output layer, row per class; probabilities = softmax(acc * CLS_LOGIT_SCALE).
+static const int8_t CLS_W2[%d * %d] PROGMEM = {
+%s
+};
+static const int32_t CLS_B2[%d] PROGMEM = {
+%s
+};
+#define CLS_LOGIT_SCALE %.9ef
+""" % ("\n*   ".join(textwrap.wrap(note, 88)), FEATURES, c_list(q["mu"]), FEATURES, c_list(q["mul"], 8), HIDDEN, FEATURES, c_list(flat1, FEATURES // 2),
+       HIDDEN, c_list(q["b1"], 8), q["m1"], len(CLASSES), HIDDEN, c_list(flat2), len(CLASSES), c_list(q["b2"]),
+       q["logit_scale"])
+    with open(path, "w", newline="\r\n") as f:
+        f.write(text)
+
+
+def read_header(path):
+    with open(path) as f:
+        text = f.read()
+
+    def arr(name):
+        m = re.search(name + r"\[[^\]]*\] PROGMEM = \{(.*?)\};", text, re.S)
+        return [int(v) for v in re.findall(r"-?\d+", m.group(1))]
+
+    w1, w2 = arr("CLS_W1"), arr("CLS_W2")
+    return {"mu": arr("CLS_MU"), "mul": arr("CLS_MUL"), "b1": arr("CLS_B1"), "b2": arr("CLS_B2"),
+            "w1": [w1[j * FEATURES:(j + 1) * FEATURES] for j in range(HIDDEN)],
+            "w2": [w2[c * HIDDEN:(c + 1) * HIDDEN] for c in range(len(CLASSES))],
+            "m1": int(re.search(r"#define CLS_M1 (-?\d+)", text).group(1)),
+            "logit_scale": float(re.search(r"#define CLS_LOGIT_SCALE ([-+.\deE]+)f", text).group(1))}
+
+
+# ================== Commands ==================
+def report(q, xs, ys):
+    conf = [[0] * len(CLASSES) for _ in CLASSES]
+    for f, y in zip(xs, ys):
+        p = infer(q, f)
+        conf[y][p.index(max(p))] += 1
+    ok = sum(conf[c][c] for c in range(len(CLASSES)))
+    print("accuracy %.1f%% (%d / %d windows)" % (100.0 * ok / len(ys), ok, len(ys)))
+    print("%-11s" % "true\\pred" + "".join("%11s" % c for c in CLASSES))
+    for c in range(len(CLASSES)):
+        print("%-11s" % CLASSES[c] + "".join("%11d" % v for v in conf[c]))
+    return ok / float(len(ys))
+
+
+def cmd_train(args):
+    rng = random.Random(args.seed)
+    xs, ys, rates = dataset(args.traces)
+    print("%d windows from %d traces (fs %s)" % (len(xs), len(args.traces), ", ".join(map(str, rates))))
+    mu, sd = standardise(xs)
+    zs = [[(x[i] - mu[i]) / sd[i] for i in range(FEATURES)] for x in xs]
+    w1, b1, w2, b2 = train_float(zs, ys, args.epochs, rng)
+    q = quantize(mu, sd, w1, b1, w2, b2, zs)
+    print("int8 model on the training windows:")
+    report(q, xs, ys)
+    note = args.note or "Trained on %d windows from %d traces." % (len(xs), len(args.traces))
+    write_header(args.header, q, note)
+    print("wrote", args.header)
+
+
+def cycles_per_window(args):
+    m = CYCLE_MODEL
+    butterflies = FFT_N // 2 * FFT_LOG2
+    frame = (args.frame_cycles if args.frame_cycles else
+             butterflies * (4 * m["mul64"] + m["butterfly_misc"]) + BINS * m["bin"] + MELS * m["log"] + m["frame_misc"])
+    infer_c = (args.infer_cycles if args.infer_cycles else
+               (FEATURES * HIDDEN + HIDDEN * len(CLASSES)) * m["mac8"] + m["softmax"])
+    return frame, infer_c
+
+
+def cmd_eval(args):
+    q = read_header(args.header)
+    xs, ys, rates = dataset(args.traces)
+    report(q, xs, ys)
+    frame, infer_c = cycles_per_window(args)
+    window = FRAMES * frame + infer_c
+    src = "benchmark" if args.frame_cycles and args.infer_cycles else "estimated (CYCLE_MODEL)"
+    print("cycles: %d per frame, %d per inference, %d per window, %s" % (frame, infer_c, window, src))
+    for fs in rates:
+        span_ms = 1000.0 * FRAMES * FFT_N / fs
+        cpu_ms = window / (args.mhz * 1000.0)
+        print("fs %d: window %.0f ms of audio, %.1f ms CPU at %d MHz (%.1f%% of the window, ADC excluded)"
+              % (fs, span_ms, cpu_ms, args.mhz, 100.0 * cpu_ms / span_ms))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Acoustic classifier tooling (classify.h)")
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    s = sub.add_parser("synth", help="write synthetic labelled traces")
+    s.add_argument("--out", required=True)
+    s.add_argument("--files", type=int, default=6, help="traces per class")
+    s.add_argument("--seconds", type=float, default=10.0)
+    s.add_argument("--fs", type=int, default=5000)
+    s.add_argument("--seed", type=int, default=1)
+    t = sub.add_parser("train", help="train, quantize and write the weights header")
+    t.add_argument("traces", nargs="+")
+    t.add_argument("--header", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "classify_weights.h"))
+    t.add_argument("--epochs", type=int, default=40)
+    t.add_argument("--seed", type=int, default=1)
+    t.add_argument("--note", help="provenance line for the header")
+    e = sub.add_parser("eval", help="accuracy and CPU cost of the int8 model on traces")
+    e.add_argument("traces", nargs="+")
+    e.add_argument("--header", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "classify_weights.h"))
+    e.add_argument("--frame-cycles", type=int, help="benchmark: cycles per frame (features)")
+    e.add_argument("--infer-cycles", type=int, help="benchmark: cycles per inference")
+    e.add_argument("--mhz", type=int, default=80)
+    args = ap.parse_args()
+    if getattr(args, "traces", None):
+        args.traces = [p for pat in args.traces for p in (sorted(glob.glob(pat)) or [pat])]
+    {"synth": cmd_synth, "train": cmd_train, "eval": cmd_eval}[args.cmd](args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""
+Project/Program Name : ESP8266 Dual Sensor Demo - Local CoAP Ingest Stand-in
+File Name            : server/coap_standin.py
+Author               : Mark P.
+Date                 : 18 OCT 2026
+Version              : 1.0.0
+
+Purpose:
+  UDP/CoAP counterpart of ingest_standin.py for the firmware's CoAP transport
+  (coap.cpp). Accepts confirmable POSTs carrying newline-separated URL-encoded
+  readings, reassembles Block1 transfers, and answers duplicates from a
+  message-ID cache so retransmissions are never stored twice.
+
+Usage:
+  python3 coap_standin.py --port 5683 [--csv readings.csv] [--trace traces.csv] [--drop 0.2]
+
+  On the node:  cfg set transport coap
+                cfg set server_base coap://<host>:5683
+                cfg set post_path /ingest
+
+  --drop discards that fraction of incoming datagrams, to exercise the node's
+  retransmission and the server's deduplication. --trace records per-reading
+  latencies as ingest_standin.py does; CoAP has no headers, so there is no
+  node send time and the trace ID comes from the payload's node_id / seq.
+
+Dependencies:
+  Python 3.8+ standard library only (shares RowSink/parse_payload/dedup with ingest_standin.py).
+"""
+
+import argparse
+import random
+import socket
+import struct
+import time
+
+from ingest_standin import DedupStore, RowSink, TraceLog, parse_payload, store_forms
+
+CON, NON, ACK, RST = 0, 1, 2, 3
+OPT_URI_PATH, OPT_CONTENT_FORMAT, OPT_BLOCK1, OPT_SIZE1 = 11, 12, 27, 60
+EXCHANGE_LIFETIME = 247.0        # RFC 7252 default, seconds
+
+
+def code(cls, detail):
+    return (cls << 5) | detail
+
+
+def parse(dgram):
+    """Decode a CoAP message -> (type, code, mid, token, options, payload) or None."""
+    if len(dgram) < 4 or dgram[0] >> 6 != 1:
+        return None
+    mtype = (dgram[0] >> 4) & 3
+    tkl = dgram[0] & 0x0F
+    mcode, mid = dgram[1], struct.unpack(">H", dgram[2:4])[0]
+    token = dgram[4:4 + tkl]
+    i, num, opts = 4 + tkl, 0, []
+    while i < len(dgram) and dgram[i] != 0xFF:
+        d, l = dgram[i] >> 4, dgram[i] & 0x0F
+        i += 1
+        if d == 13:
+            d = dgram[i] + 13; i += 1
+        elif d == 14:
+            d = struct.unpack(">H", dgram[i:i + 2])[0] + 269; i += 2
+        if l == 13:
+            l = dgram[i] + 13; i += 1
+        elif l == 14:
+            l = struct.unpack(">H", dgram[i:i + 2])[0] + 269; i += 2
+        num += d
+        opts.append((num, dgram[i:i + l]))
+        i += l
+    payload = dgram[i + 1:] if i < len(dgram) else b""
+    return mtype, mcode, mid, token, opts, payload
+
+
+def uint_opt(opts, number):
+    for n, v in opts:
+        if n == number:
+            return int.from_bytes(v, "big")
+    return None
+
+
+def encode_opts(opts):
+    out, last = b"", 0
+    for n, v in sorted(opts):
+        d, l = n - last, len(v)
+        last = n
+        dn = d if d < 13 else 13
+        ln = l if l < 13 else 13
+        out += bytes([(dn << 4) | ln])
+        if dn == 13:
+            out += bytes([d - 13])
+        if ln == 13:
+            out += bytes([l - 13])
+        out += v
+    return out
+
+
+def ack(mid, token, rcode, opts=(), payload=b""):
+    hdr = bytes([0x40 | (ACK << 4) | len(token), rcode]) + struct.pack(">H", mid) + token
+    body = encode_opts(list(opts))
+    return hdr + body + ((b"\xff" + payload) if payload else b"")
+
+
+def uint_bytes(v):
+    return v.to_bytes((v.bit_length() + 7) // 8, "big") if v else b""
+
+
+class CoapIngest:
+    def __init__(self, sink, dedup, traces):
+        self.sink = sink
+        self.dedup = dedup
+        self.traces = traces
+        self.seen = {}       # (addr, mid) -> (expires, response bytes)
+        self.partial = {}    # (addr, path) -> bytearray of received blocks
+
+    def handle(self, dgram, addr):
+        msg = parse(dgram)
+        if msg is None:
+            return None
+        mtype, mcode, mid, token, opts, payload = msg
+        if mtype == CON and mcode == 0:
+            return bytes([0x40 | (RST << 4), 0]) + struct.pack(">H", mid)   # CoAP ping -> RST
+        if mtype not in (CON, NON) or mcode == 0:
+            return None       # ACK/RST: nothing to do
+
+        # Deduplicate by message ID: resend the stored response, do not reprocess.
+        now = time.time()
+        self.seen = {k: v for k, v in self.seen.items() if v[0] > now}
+        hit = self.seen.get((addr, mid))
+        if hit:
+            print("[coap] duplicate mid %d from %s, replaying response" % (mid, addr[0]), flush=True)
+            return hit[1]
+
+        resp = self.process(addr, mcode, token, opts, payload, mid)
+        if mtype == CON:
+            self.seen[(addr, mid)] = (now + EXCHANGE_LIFETIME, resp)
+            return resp
+        return None
+
+    def process(self, addr, mcode, token, opts, payload, mid):
+        if mcode != code(0, 2):                                   # only POST
+            return ack(mid, token, code(4, 5))
+        path = "/" + "/".join(v.decode() for n, v in opts if n == OPT_URI_PATH)
+        key = (addr, path)
+
+        block1 = uint_opt(opts, OPT_BLOCK1)
+        if block1 is not None:
+            num, more, szx = block1 >> 4, bool(block1 & 8), block1 & 7
+            size = 1 << (szx + 4)
+            if num == 0:                                          # (re)start: drop any leftover
+                self.partial[key] = bytearray()
+            buf = self.partial.setdefault(key, bytearray())
+            if num * size != len(buf):                            # out of order / gap
+                self.partial.pop(key, None)
+                return ack(mid, token, code(4, 8))                # Request Entity Incomplete
+            buf += payload
+            if more:
+                return ack(mid, token, code(2, 31), [(OPT_BLOCK1, uint_bytes(block1))])
+            payload = bytes(self.partial.pop(key))
+            echo = [(OPT_BLOCK1, uint_bytes(block1))]
+        else:
+            echo = []
+
+        trace = self.traces.begin("coap")
+        try:
+            forms = parse_payload(payload)
+        except ValueError as e:
+            print("[coap] %s %s: %s" % (addr[0], path, e), flush=True)
+            return ack(mid, token, code(4, 0), echo)              # 4.00 Bad Request
+        stored, dups = store_forms(self.sink, self.dedup, forms, {"peer": addr[0], "path": path}, trace)
+        print("[coap] %s %s: %d readings, %d duplicates, %d B" % (addr[0], path, stored, dups, len(payload)), flush=True)
+        return ack(mid, token, code(2, 4), echo)                  # 2.04 Changed
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Local CoAP stand-in for the ingest endpoint")
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=5683)
+    ap.add_argument("--csv", help="append accepted readings to this CSV file")
+    ap.add_argument("--state", help="JSON file for per-node seen sequence numbers")
+    ap.add_argument("--trace", help="append per-reading trace records to this CSV file (trace_report.py)")
+    ap.add_argument("--drop", type=float, default=0.0, help="fraction of datagrams to drop")
+    cfg = ap.parse_args()
+
+    srv = CoapIngest(RowSink(cfg.csv), DedupStore(cfg.state), TraceLog(cfg.trace))
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((cfg.host, cfg.port))
+    print("[coap] listening on %s:%d" % (cfg.host, cfg.port), flush=True)
+    while True:
+        dgram, addr = sock.recvfrom(2048)
+        if cfg.drop and random.random() < cfg.drop:
+            continue
+        resp = srv.handle(dgram, addr)
+        if resp:
+            sock.sendto(resp, addr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,666 @@
+#!/usr/bin/env python3
+"""
+Project/Program Name : ESP8266 Dual Sensor Demo - Local Ingest Stand-in
+File Name            : server/ingest_standin.py
+Author               : Mark P.
+Date                 : 18 OCT 2026
+Version              : 1.0.0
+
+Purpose:
+  Local replacement for the hosted /api/ingest.php endpoint, for bench tests
+  and LAN gateways. Accepts the same URL-encoded form body the firmware sends
+  and, for the signed plain-HTTP transport (postToServerSigned), verifies the
+  per-node HMAC-SHA256.
+  Every reading carries a per-node sequence number (X-Node-Seq for signed
+  requests, node_id/seq form fields otherwise). A reading whose (node, seq)
+  was already stored is acknowledged but not stored again, so nodes can retry
+  and replay queued data freely after a lost response.
+  Batch bodies (text/plain, one form body per line, transport https_batch)
+  may be compressed with Content-Encoding: x-heatshrink-w9l4; every response
+  advertises that coding in Accept-Encoding (RFC 7694) so nodes can enable it.
+  Binary batches (application/x-ee570-batch, batch_format binary; layout in
+  batchcodec.h) are expanded by decode_batch() into the same form fields.
+  Their header lists each field's ID, wire type and scale (schema.h); fields
+  whose ID is not in SCHEMA below are skipped, so a node with newer fields
+  still uploads here. Fixed-layout 0xB1 batches from older firmware are
+  still accepted.
+  Tracing: every stored reading gets a trace record keyed by its trace ID
+  (node ID + 8 hex digits of seq, traceId() in sendRequest.h) with the
+  capture time (cap_ms form field / binary timestamp), the node's send time
+  (X-Trace-Sent, HTTP only) and three server times: enqueue (request
+  received), commit (row written) and visible (first GET <base>/readings
+  that returns the row). A record waits for that query and is written with
+  visible empty if the row leaves the recent-rows index, or the server stops,
+  before one comes; the CoAP / MQTT stand-ins have no query endpoint and
+  always write it empty. trace_report.py turns --trace files into percentiles.
+  Classifier readings (node 3, classify.h) carry five class percentages in
+  the "cls" column (cls form field / binary field 3); it is empty for
+  sensor readings.
+  Quality flags (quality.h: 1 clip, 2 stuck, 4 bias, 8 jitter, 16 no echo,
+  32 echo rate, 64 near-field echo gated) arrive as the q form field / binary field 4 and are
+  stored in column "q" (0 when the node reported none).
+  Adaptive ranging readings (ranging.h) carry the reading interval in force
+  (interval_ms, field 5) and, on the readings where the rate changes, the
+  transition (range_ev, field 6: 1 idle -> active, 2 active -> idle); both
+  are empty otherwise.
+
+Usage:
+  python3 ingest_standin.py --port 8080 \\
+      --key 00a1b2c3=<64 hex chars> [--key ...] \\
+      [--state seq_state.json] [--csv readings.csv] [--trace traces.csv] [--allow-unsigned]
+
+  On the node:  cfg set server_base http://<host>:8080/api
+                cfg set transport hmac_http
+                cfg set node_key <same 64 hex chars>
+
+  Batched, compressed uploads (run with --allow-unsigned):
+                cfg set transport https_batch
+                cfg set compress auto
+                cfg set batch_format binary     (optional)
+
+  Recently stored rows:  curl 'http://<host>:8080/api/readings?node_id=00a1b2c3&limit=20'
+
+Responses:
+  200 {"ok":true,...}   reading(s) accepted; "duplicates" counts already-stored ones
+  400                   malformed body / headers
+  401                   unknown node, bad signature, or unsigned when not allowed
+  415                   unsupported Content-Encoding (node retries uncompressed)
+
+Dependencies:
+  Python 3.8+ standard library only.
+"""
+
+import argparse
+import csv
+import hashlib
+import hmac
+import json
+import os
+from bisect import bisect_right
+import sys
+import threading
+import time
+from collections import deque
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlsplit
+
+FIELDS = ("node_name", "measured_iso", "tz_region", "distance_cm", "sound_db")
+HS_CODING = "x-heatshrink-w9l4"
+BATCH_TYPE = "application/x-ee570-batch"
+BATCH_MAGIC = 0xB2                   # schema batch (batchcodec.h)
+BATCH_MAGIC_V1 = 0xB1                # fixed-layout batch, older firmware
+WIRE_SCALED, WIRE_BYTES = 0, 1       # FIELD_WIRE_* in schema.h
+# Field registry (SCHEMA_FIELDS in schema.cpp): wire ID -> column, and the
+# column's value when a reading does not carry the field.
+SCHEMA = {1: "distance_cm", 2: "sound_db", 3: "cls", 4: "q", 5: "interval_ms", 6: "range_ev"}
+ABSENT = {"distance_cm": "0.00", "sound_db": "0.00", "cls": "", "q": "0", "interval_ms": "", "range_ev": ""}
+NODE_NAMES = {1: "Ultrasonic_Sensor", 2: "Sound_Sensor_MAX4466", 3: "Sound_Classifier"}   # READING_NODE_* in readings.h
+CLASSES = 5                                                         # READING_CLASSES in readings.h
+RECENT_ROWS = 1000                   # rows kept for GET <base>/readings
+
+
+def now_ms():
+    return int(time.time() * 1000)
+
+
+def trace_id(node_id, seq):
+    """Trace ID of one reading: node ID + seq as 8 hex digits (traceId() in sendRequest.h)."""
+    return "%s%08x" % (node_id.lower(), int(seq))
+
+
+def heatshrink_decode(data, window_bits=9, lookahead_bits=4):
+    """Inverse of hsCompress() (compress.h): '1'+8 bits literal, '0'+W+L bits back-reference."""
+    out = bytearray()
+    bits = int.from_bytes(data, "big")
+    total = len(data) * 8
+    pos = 0
+
+    def get(n):
+        nonlocal pos
+        pos += n
+        return (bits >> (total - pos)) & ((1 << n) - 1)
+
+    while pos < total:
+        if get(1):
+            if total - pos < 8:
+                break
+            out.append(get(8))
+        else:
+            if total - pos < window_bits + lookahead_bits:
+                break
+            off = get(window_bits) + 1
+            cnt = get(lookahead_bits) + 1
+            if off > len(out):
+                raise ValueError("back-reference before start of data")
+            for _ in range(cnt):
+                out.append(out[-off])
+    return bytes(out)
+
+
+class SeqRanges:
+    """Sequence numbers seen from one node: all of 1..hwm, plus disjoint
+    [lo, hi] ranges above hwm (out-of-order arrivals). A range that reaches
+    hwm + 1 is folded into hwm, so in steady state the check is one compare."""
+
+    MAX_RANGES = 64   # beyond this the oldest gap is treated as permanently lost
+
+    def __init__(self, hwm=0, ranges=()):
+        self.hwm = hwm
+        self.ranges = [list(r) for r in ranges]
+
+    def seen(self, seq):
+        if seq <= self.hwm:
+            return True
+        i = bisect_right(self.ranges, [seq, float("inf")]) - 1
+        return i >= 0 and seq <= self.ranges[i][1]
+
+    def add(self, seq):
+        """Record seq; returns False if it was already seen."""
+        if self.seen(seq):
+            return False
+        i = bisect_right(self.ranges, [seq, float("inf")])
+        joins_left = i > 0 and self.ranges[i - 1][1] == seq - 1
+        joins_right = i < len(self.ranges) and self.ranges[i][0] == seq + 1
+        if joins_left and joins_right:
+            self.ranges[i - 1][1] = self.ranges.pop(i)[1]
+        elif joins_left:
+            self.ranges[i - 1][1] = seq
+        elif joins_right:
+            self.ranges[i][0] = seq
+        else:
+            self.ranges.insert(i, [seq, seq])
+        # Gaps left by reboots (reserved blocks) or overwritten queue entries
+        # never fill; bound the list by giving up on the oldest one.
+        while self.ranges and (self.ranges[0][0] == self.hwm + 1 or len(self.ranges) > self.MAX_RANGES):
+            self.hwm = self.ranges.pop(0)[1]
+        return True
+
+
+class DedupStore:
+    """Per-node SeqRanges, optionally saved to disk as JSON."""
+
+    def __init__(self, path=None):
+        self.path = path
+        self.lock = threading.Lock()
+        self.nodes = {}
+        if path and os.path.exists(path):
+            with open(path) as f:
+                for node, v in json.load(f).items():
+                    if isinstance(v, int):          # older high-water-mark-only state
+                        self.nodes[node] = SeqRanges(v)
+                    else:
+                        self.nodes[node] = SeqRanges(v["hwm"], v["ranges"])
+
+    def accept(self, node, seq, store):
+        """If (node, seq) is new, call store() and then record it; False for a
+        duplicate. If store() raises, seq stays unrecorded so a retry stores it."""
+        with self.lock:
+            r = self.nodes.setdefault(node, SeqRanges())
+            if r.seen(seq):
+                return False
+            store()
+            r.add(seq)
+            if self.path:
+                tmp = self.path + ".tmp"
+                with open(tmp, "w") as f:
+                    json.dump({n: {"hwm": v.hwm, "ranges": v.ranges} for n, v in self.nodes.items()}, f)
+                os.replace(tmp, self.path)
+            return True
+
+
+class RowSink:
+    """Print accepted rows and optionally append them to a CSV file. Committed
+    rows are then published to a small in-memory index that GET <base>/readings
+    serves; a reading becomes visible when a query first returns it.
+    'queryable' is False for stand-ins without that endpoint."""
+
+    def __init__(self, csv_path=None, queryable=False):
+        self.csv_path = csv_path
+        self.queryable = queryable
+        self.lock = threading.Lock()
+        self.recent = deque()          # [row, trace record waiting for a query or None, TraceLog]
+
+    def publish(self, row, rec=None, log=None):
+        """Add row to the index. rec (a TraceLog record) is written by 'log'
+        once a query returns the row, or with visible_ms empty if it drops out
+        of the index unseen."""
+        with self.lock:
+            self.recent.append([row, rec, log])
+            old = self.recent.popleft() if len(self.recent) > RECENT_ROWS else None
+        if old and old[1]:
+            old[2].write([old[1]])
+
+    def query(self, node_id=None, limit=100):
+        with self.lock:
+            hits = [e for e in self.recent if not node_id or e[0].get("node_id", "").lower() == node_id.lower()]
+            hits = hits[-limit:]
+            seen = [e for e in hits if e[1]]
+            for e in seen:
+                e[1]["visible_ms"] = now_ms()
+            done = [(e[1], e[2]) for e in seen]
+            for e in seen:
+                e[1] = None
+        self._write_traces(done)
+        return [e[0] for e in hits]
+
+    def flush_traces(self):
+        """Write the trace records still waiting for a query (at shutdown)."""
+        with self.lock:
+            done = [(e[1], e[2]) for e in self.recent if e[1]]
+            for e in self.recent:
+                e[1] = None
+        self._write_traces(done)
+
+    @staticmethod
+    def _write_traces(done):
+        by_log = {}
+        for rec, log in done:
+            by_log.setdefault(id(log), (log, []))[1].append(rec)
+        for log, recs in by_log.values():
+            log.write(recs)
+
+    def write(self, row):
+        print("[standin] " + json.dumps(row), flush=True)
+        if not self.csv_path:
+            return
+        with self.lock:
+            new = not os.path.exists(self.csv_path)
+            with open(self.csv_path, "a", newline="") as f:
+                w = csv.DictWriter(f, fieldnames=list(row.keys()))
+                if new:
+                    w.writeheader()
+                w.writerow(row)
+
+
+class TraceLog:
+    """Per-reading trace records, printed per request and optionally appended to a CSV file.
+    capture_ms / sent_ms come from the node's clock, the rest from the server's (epoch ms)."""
+
+    FIELDS = ("trace_id", "batch_trace_id", "node_id", "seq", "transport",
+              "capture_ms", "sent_ms", "enqueue_ms", "commit_ms", "visible_ms")
+
+    def __init__(self, csv_path=None):
+        self.csv_path = csv_path
+        self.lock = threading.Lock()
+
+    def begin(self, transport, headers=None):
+        """Context for one request; call when the request has been fully received."""
+        headers = headers or {}
+        sent = headers.get("X-Trace-Sent", "")
+        return {"log": self, "transport": transport, "enqueue_ms": now_ms(),
+                "batch_trace_id": headers.get("X-Trace-Id", "").lower(),
+                "capture_ms": headers.get("X-Trace-Capture", ""),
+                "sent_ms": int(sent) if sent.isdigit() else ""}
+
+    def record(self, records, deferred=False):
+        """Summarise one request's records; write them now unless 'deferred'
+        (RowSink.publish() holds them until a query sets visible_ms)."""
+        if not records:
+            return
+        first = records[0]
+        e2e = [r["commit_ms"] - r["capture_ms"] for r in records if r["capture_ms"] != ""]
+        print("[trace] %s %s: %d readings, capture->commit %s ms, enqueue->commit %d ms" % (
+            first["batch_trace_id"], first["transport"], len(records),
+            "%d..%d" % (min(e2e), max(e2e)) if e2e else "n/a",
+            records[-1]["commit_ms"] - first["enqueue_ms"]), flush=True)
+        if not deferred:
+            self.write(records)
+
+    def write(self, records):
+        if not self.csv_path or not records:
+            return
+        with self.lock:
+            new = not os.path.exists(self.csv_path)
+            with open(self.csv_path, "a", newline="") as f:
+                w = csv.DictWriter(f, fieldnames=self.FIELDS)
+                if new:
+                    w.writeheader()
+                w.writerows(records)
+
+
+def parse_form(text):
+    """One URL-encoded reading -> dict, or None if a required field is missing.
+    node_id / seq are optional (empty when the node did not send them);
+    cap_ms (capture time, epoch ms) is returned as "capture_ms" for tracing;
+    cls (class percentages) and q (quality flags) are always present so CSV
+    rows share one header."""
+    form = {k: v[0] for k, v in parse_qs(text).items()}
+    if any(f not in form for f in FIELDS):
+        return None
+    out = {"node_id": form.get("node_id", ""), "seq": form.get("seq", "")}
+    out.update((f, form[f]) for f in FIELDS)
+    out.update((col, form.get(col, ABSENT[col])) for col in SCHEMA.values() if col not in FIELDS)
+    if form.get("cap_ms", "").isdigit():
+        out["capture_ms"] = int(form["cap_ms"])
+    return out
+
+
+def store_forms(sink, dedup, forms, extra, trace=None):
+    """Write parsed readings, skipping (node_id, seq) pairs already stored.
+    Readings without a sequence number are always stored. 'trace' (from
+    TraceLog.begin) adds a trace record per stored reading that has a node ID
+    and seq. The seq is recorded as stored only once sink.write() has
+    returned. Returns (stored, duplicates)."""
+    stored = dups = 0
+    records = []
+    for form in forms:
+        capture = form.pop("capture_ms", "")
+        seq = int(form["seq"]) if str(form["seq"]).isdigit() else 0
+        row = {"received": time.strftime("%Y-%m-%dT%H:%M:%S")}
+        row.update(extra)
+        row.update(form)
+        if not (form["node_id"] and seq):
+            sink.write(row)
+        elif not dedup.accept(form["node_id"].lower(), seq, lambda: sink.write(row)):
+            dups += 1
+            continue
+        commit = now_ms()
+        stored += 1
+        rec = None
+        if trace and form["node_id"] and seq:
+            tid = trace_id(form["node_id"], seq)
+            if capture == "" and not records and str(trace["capture_ms"]).isdigit():
+                capture = int(trace["capture_ms"])   # header describes the first reading
+            rec = {"trace_id": tid, "batch_trace_id": trace["batch_trace_id"] or tid,
+                   "node_id": form["node_id"].lower(), "seq": seq, "transport": trace["transport"],
+                   "capture_ms": capture, "sent_ms": trace["sent_ms"], "enqueue_ms": trace["enqueue_ms"],
+                   "commit_ms": commit, "visible_ms": ""}
+            records.append(rec)
+        if sink.queryable and rec:
+            sink.publish(row, rec, trace["log"])
+        else:
+            sink.publish(row)
+    if trace:
+        trace["log"].record(records, deferred=sink.queryable)
+    return stored, dups
+
+
+class BatchReader:
+    """Varint / zigzag reader over one binary batch (ByteReader in batchcodec.cpp)."""
+
+    def __init__(self, data):
+        self.data, self.pos = data, 0
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise ValueError("truncated batch")
+        self.pos += 1
+        return self.data[self.pos - 1]
+
+    def varint(self):
+        v = shift = 0
+        while True:
+            b = self.byte()
+            v |= (b & 0x7F) << shift
+            if not b & 0x80:
+                return v
+            shift += 7
+            if shift >= 64:
+                raise ValueError("bad varint")
+
+    def svarint(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+    def bytes(self, n):
+        return [self.byte() for _ in range(n)]
+
+
+def decode_batch(data):
+    """Binary batch (batchcodec.h) -> list of form dicts as parse_form() returns them.
+    Raises ValueError on a malformed or truncated payload."""
+    rd = BatchReader(data)
+    magic = rd.byte()
+    if magic not in (BATCH_MAGIC, BATCH_MAGIC_V1):
+        raise ValueError("not a binary batch")
+    chip, seq, t = rd.varint(), rd.varint() - 1, rd.varint()
+    offset_min = rd.svarint()
+
+    def form(t, seq, node, values):
+        f = {
+            "capture_ms": t,
+            "node_id": "%08x" % chip,
+            "seq": str(seq),
+            "node_name": NODE_NAMES.get(node, NODE_NAMES[2]),
+            "measured_iso": time.strftime("%Y-%m-%dT%H:%M:%S", time.gmtime(t // 1000 + offset_min * 60)),
+            "tz_region": tz,
+        }
+        f.update(ABSENT)
+        f.update(values)
+        return f
+
+    if magic == BATCH_MAGIC_V1:
+        dec = rd.byte()
+        dist_scale, sound_scale = 10.0 ** (dec >> 4), 10.0 ** (dec & 0x0F)
+        tz = bytes(rd.bytes(rd.varint())).decode("utf-8", "replace")
+        forms = []
+        dt = dist = sound = 0
+        for _ in range(rd.varint()):
+            head = rd.byte()
+            seq += rd.svarint() + 1 if head & 0x10 else 1
+            dt += rd.svarint()
+            t += dt
+            if head & 0x04:
+                dist += rd.svarint()
+            if head & 0x08:
+                sound += rd.svarint()
+            values = {}
+            if head & 0x40:
+                values["cls"] = ",".join(map(str, rd.bytes(CLASSES)))
+            if head & 0x80:
+                values["q"] = str(rd.byte())
+            distance = float("nan") if head & 0x20 else (dist / dist_scale if head & 0x04 else 0.0)
+            values["distance_cm"] = "%.2f" % distance
+            values["sound_db"] = "%.2f" % (sound / sound_scale if head & 0x08 else 0.0)
+            forms.append(form(t, seq, head & 0x03, values))
+        if rd.pos != len(data):
+            raise ValueError("trailing bytes after batch")
+        return forms
+
+    tz = bytes(rd.bytes(rd.varint())).decode("utf-8", "replace")
+    fields = []                                  # (column or None, wire, param)
+    for _ in range(rd.varint()):
+        fid, wire, param = rd.byte(), rd.byte(), rd.byte()
+        if wire not in (WIRE_SCALED, WIRE_BYTES) or (wire == WIRE_SCALED and param > 9):
+            raise ValueError("field %d: unknown wire type %d" % (fid, wire))
+        fields.append((SCHEMA.get(fid), wire, param))
+
+    forms = []
+    dt = 0
+    prev = [0] * len(fields)
+    node_fields = {}                             # presence bitmap last sent per node
+    for _ in range(rd.varint()):
+        head = rd.byte()
+        if head & 0xE0:
+            raise ValueError("reserved head bits set")
+        node = head & 0x07
+        seq += rd.svarint() + 1 if head & 0x08 else 1
+        dt += rd.svarint()
+        t += dt
+        if head & 0x10:
+            node_fields[node] = rd.varint()
+            if node_fields[node] >> len(fields):
+                raise ValueError("presence bit beyond the field table")
+        present = node_fields.get(node, 0)
+        values = {}
+        for i, (col, wire, param) in enumerate(fields):
+            if not present >> i & 1:
+                continue
+            if wire == WIRE_BYTES:
+                raw = rd.bytes(param)
+                value = str(raw[0]) if param == 1 else ",".join(map(str, raw))
+            else:
+                z = rd.varint()
+                if z:
+                    d = z - 1
+                    prev[i] += (d >> 1) ^ -(d & 1)
+                value = "%.2f" % (prev[i] / 10.0 ** param if z else float("nan"))
+            if col:
+                values[col] = value
+        forms.append(form(t, seq, node, values))
+    if rd.pos != len(data):
+        raise ValueError("trailing bytes after batch")
+    return forms
+
+
+def parse_payload(payload):
+    """Batch payload from any transport: binary if it starts with BATCH_MAGIC or
+    BATCH_MAGIC_V1 (never the first byte of a form body), else one form body
+    per line. Malformed lines are skipped; a malformed binary batch raises ValueError."""
+    if payload[:1] in (bytes([BATCH_MAGIC]), bytes([BATCH_MAGIC_V1])):
+        return decode_batch(payload)
+    return [f for f in map(parse_form, payload.decode("utf-8", "replace").splitlines()) if f]
+
+
+def canonical(node_id, seq, path, body):
+    """Bytes the node signs: nodeId \\n seq \\n path \\n body (see sendRequest.h)."""
+    return b"\n".join([node_id.encode(), str(seq).encode(), path.encode(), body])
+
+
+class IngestHandler(BaseHTTPRequestHandler):
+    server_version = "IngestStandin/1.0"
+
+    def reply(self, code, obj):
+        data = json.dumps(obj).encode()
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Accept-Encoding", HS_CODING)
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def verify(self, body):
+        """Return (node_id, seq) if the request is acceptable, else send an error and return None."""
+        cfg = self.server.cfg
+        sig = self.headers.get("X-Node-Sig")
+        if sig is None:
+            if cfg.allow_unsigned:
+                return ("", 0)
+            self.reply(401, {"ok": False, "error": "unsigned request"})
+            return None
+
+        node_id = self.headers.get("X-Node-Id", "")
+        try:
+            seq = int(self.headers.get("X-Node-Seq", ""))
+        except ValueError:
+            self.reply(400, {"ok": False, "error": "bad X-Node-Seq"})
+            return None
+
+        key = cfg.keys.get(node_id)
+        if key is None:
+            self.reply(401, {"ok": False, "error": "unknown node"})
+            return None
+
+        # The node signs the endpoint path relative to its server_base, which is
+        # the request path with the --base prefix removed.
+        path = urlsplit(self.path).path
+        if path.startswith(cfg.base):
+            path = path[len(cfg.base):]
+        want = hmac.new(key, canonical(node_id, seq, path, body), hashlib.sha256).hexdigest()
+        if not hmac.compare_digest(want, sig.lower()):
+            self.reply(401, {"ok": False, "error": "bad signature"})
+            return None
+        return (node_id, seq)
+
+    def do_GET(self):
+        url = urlsplit(self.path)
+        if url.path != self.server.cfg.base + "/readings":
+            self.reply(404, {"ok": False, "error": "not found"})
+            return
+        q = {k: v[0] for k, v in parse_qs(url.query).items()}
+        limit = int(q["limit"]) if q.get("limit", "").isdigit() else 100
+        self.reply(200, {"ok": True, "rows": self.server.sink.query(q.get("node_id"), limit)})
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", "0"))
+        body = self.rfile.read(length)
+        trace = self.server.traces.begin("https", self.headers)
+
+        auth = self.verify(body)
+        if auth is None:
+            return
+        node_id, seq = auth
+
+        coding = self.headers.get("Content-Encoding", "identity").strip().lower()
+        if coding == HS_CODING:
+            try:
+                wire = len(body)
+                body = heatshrink_decode(body)
+            except ValueError:
+                self.reply(400, {"ok": False, "error": "corrupt %s body" % HS_CODING})
+                return
+            sys.stderr.write("[standin] %s: %d -> %d B (%.2fx)\n" % (coding, wire, len(body), len(body) / max(wire, 1)))
+        elif coding != "identity":
+            self.reply(415, {"ok": False, "error": "unsupported Content-Encoding %s" % coding})
+            return
+
+        # text/plain carries a batch: one form body per line; BATCH_TYPE the binary layout.
+        ctype = self.headers.get("Content-Type", "")
+        if ctype.startswith(BATCH_TYPE):
+            try:
+                forms = decode_batch(body)
+            except ValueError as e:
+                self.reply(400, {"ok": False, "error": str(e)})
+                return
+        else:
+            batch = ctype.startswith("text/plain")
+            lines = body.decode("utf-8", "replace").splitlines() if batch else [body.decode("utf-8", "replace")]
+            forms = [parse_form(line) for line in lines if line]
+        if not forms or any(f is None for f in forms):
+            self.reply(400, {"ok": False, "error": "missing field"})
+            return
+
+        # Signed requests: the authenticated headers identify the reading.
+        if node_id:
+            for form in forms:
+                form["node_id"], form["seq"] = node_id, str(seq)
+        stored, dups = store_forms(self.server.sink, self.server.seqs, forms, {}, trace)
+        self.reply(200, {"ok": True, "seq": seq, "rows": stored, "duplicates": dups})
+
+    def log_message(self, fmt, *args):
+        sys.stderr.write("[standin] %s %s\n" % (self.address_string(), fmt % args))
+
+
+class IngestServer(ThreadingHTTPServer):
+    def __init__(self, addr, cfg):
+        super().__init__(addr, IngestHandler)
+        self.cfg = cfg
+        self.seqs = DedupStore(cfg.state)
+        self.sink = RowSink(cfg.csv, queryable=True)
+        self.traces = TraceLog(cfg.trace)
+
+
+def parse_args(argv=None):
+    ap = argparse.ArgumentParser(description="Local stand-in for /api/ingest.php")
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=8080)
+    ap.add_argument("--base", default="/api", help="URL prefix matching the node's server_base path")
+    ap.add_argument("--key", action="append", default=[], metavar="NODEID=HEX",
+                    help="per-node HMAC key (repeatable)")
+    ap.add_argument("--state", help="JSON file for per-node seen sequence numbers")
+    ap.add_argument("--csv", help="append accepted readings to this CSV file")
+    ap.add_argument("--trace", help="append per-reading trace records to this CSV file (trace_report.py)")
+    ap.add_argument("--allow-unsigned", action="store_true",
+                    help="also accept requests without X-Node-Sig")
+    cfg = ap.parse_args(argv)
+    keys = {}
+    for item in cfg.key:
+        node, _, hexkey = item.partition("=")
+        keys[node.lower()] = bytes.fromhex(hexkey)
+    cfg.keys = keys
+    return cfg
+
+
+def main():
+    cfg = parse_args()
+    srv = IngestServer((cfg.host, cfg.port), cfg)
+    print("[standin] listening on %s:%d (%d node keys)" % (cfg.host, cfg.port, len(cfg.keys)), flush=True)
+    try:
+        srv.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    srv.sink.flush_traces()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+Project/Program Name : ESP8266 Dual Sensor Demo - Live Level Stream Receiver
+File Name            : server/live_standin.py
+Author               : Mark P.
+Date                 : 18 OCT 2026
+Version              : 1.0.0
+
+Purpose:
+  WebSocket (RFC 6455) receiver for the firmware's live level stream
+  (livestream.cpp). Accepts the upgrade, decodes the binary 'L' messages
+  (see livestream.h for the layout), reports rate, coalescing (stride > 1)
+  and missed windows (seq gaps), and pings the node periodically.
+
+Usage:
+  python3 live_standin.py --port 8081 [--csv levels.csv] [--slow 0.5] [--ping 20]
+
+  On the node:  cfg set live_url ws://<host>:8081/live
+                cfg set live_rate_hz 25
+
+  --slow pauses that many seconds between socket reads, so the node's TCP
+  window fills and its ring starts coalescing.
+
+Dependencies:
+  Python 3.8+ standard library only (shares RowSink with ingest_standin.py).
+"""
+
+import argparse
+import asyncio
+import base64
+import hashlib
+import struct
+import time
+
+from ingest_standin import RowSink
+
+GUID = b"258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+OP_BINARY, OP_CLOSE, OP_PING, OP_PONG = 0x2, 0x8, 0x9, 0xA
+HDR = struct.Struct(">cBHIIHH")   # type, stride, count, seq, epoch, ms, period_ms
+
+
+def ws_frame(opcode, payload=b""):
+    n = len(payload)
+    head = bytes([0x80 | opcode])
+    if n < 126:
+        head += bytes([n])
+    else:
+        head += bytes([126]) + struct.pack(">H", n)
+    return head + payload
+
+
+async def read_frame(reader):
+    b0, b1 = await reader.readexactly(2)
+    n = b1 & 0x7F
+    if n == 126:
+        n = struct.unpack(">H", await reader.readexactly(2))[0]
+    elif n == 127:
+        n = struct.unpack(">Q", await reader.readexactly(8))[0]
+    mask = await reader.readexactly(4) if b1 & 0x80 else None
+    data = bytearray(await reader.readexactly(n))
+    if mask:
+        for i in range(n):
+            data[i] ^= mask[i & 3]
+    return b0 & 0x0F, bytes(data), mask is not None
+
+
+class LiveReceiver:
+    def __init__(self, sink, slow, ping):
+        self.sink = sink
+        self.slow = slow
+        self.ping = ping
+
+    async def upgrade(self, reader, writer):
+        request = await reader.readuntil(b"\r\n\r\n")
+        headers = {}
+        lines = request.decode("latin-1").split("\r\n")
+        for line in lines[1:]:
+            if ":" in line:
+                k, v = line.split(":", 1)
+                headers[k.strip().lower()] = v.strip()
+        key = headers.get("sec-websocket-key")
+        if not key or headers.get("upgrade", "").lower() != "websocket":
+            writer.write(b"HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n")
+            await writer.drain()
+            return None
+        accept = base64.b64encode(hashlib.sha1(key.encode() + GUID).digest()).decode()
+        writer.write(("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                      "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n" % accept).encode())
+        await writer.drain()
+        return lines[0].split(" ")[1] if " " in lines[0] else "/"
+
+    async def pinger(self, writer):
+        while True:
+            await asyncio.sleep(self.ping)
+            writer.write(ws_frame(OP_PING, b"%d" % int(time.time())))
+            await writer.drain()
+
+    async def handle(self, reader, writer):
+        peer = "%s:%d" % writer.get_extra_info("peername")[:2]
+        path = await self.upgrade(reader, writer)
+        if path is None:
+            writer.close()
+            return
+        print("[live] %s connected on %s" % (peer, path), flush=True)
+        ping_task = asyncio.ensure_future(self.pinger(writer)) if self.ping else None
+        expect = None
+        levels = frames = missed = 0
+        t_start = time.time()
+        try:
+            while True:
+                if self.slow:
+                    await asyncio.sleep(self.slow)
+                opcode, data, masked = await read_frame(reader)
+                if not masked:
+                    print("[live] %s unmasked client frame" % peer, flush=True)
+                if opcode == OP_CLOSE:
+                    writer.write(ws_frame(OP_CLOSE))
+                    await writer.drain()
+                    break
+                if opcode != OP_BINARY or len(data) < HDR.size:
+                    continue
+                kind, stride, count, seq, epoch, ms, period = HDR.unpack_from(data)
+                if kind != b"L" or len(data) != HDR.size + 2 * count:
+                    print("[live] %s malformed message (%d B)" % (peer, len(data)), flush=True)
+                    continue
+                values = struct.unpack_from(">%dH" % count, data, HDR.size)
+                if expect is not None and seq != expect:
+                    gap = seq - expect
+                    missed += max(gap, 0)
+                    print("[live] %s seq gap: expected %d got %d (%+d windows)" % (peer, expect, seq, gap), flush=True)
+                expect = seq + count * stride
+                frames += 1
+                levels += count
+                for i, v in enumerate(values if self.sink else ()):
+                    offset_ms = i * stride * period
+                    self.sink.write({
+                        "received": time.strftime("%Y-%m-%dT%H:%M:%S"),
+                        "peer": peer,
+                        "seq": seq + i * stride,
+                        "stride": stride,
+                        "t": "%.3f" % (epoch + (ms + offset_ms) / 1000.0) if epoch else "",
+                        "level_db": "%.2f" % (v / 100.0),
+                    })
+                elapsed = max(time.time() - t_start, 1e-3)
+                print("[live] %s seq=%d n=%d stride=%d last=%.2f dB  (%.1f levels/s, %d frames, %d missed)"
+                      % (peer, seq, count, stride, values[-1] / 100.0 if values else 0.0,
+                         levels / elapsed, frames, missed), flush=True)
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            if ping_task:
+                ping_task.cancel()
+            writer.close()
+            print("[live] %s disconnected after %d levels in %d frames, %d windows missed"
+                  % (peer, levels, frames, missed), flush=True)
+
+
+async def main():
+    ap = argparse.ArgumentParser(description="Live level stream (WebSocket) receiver")
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=8081)
+    ap.add_argument("--csv", help="append received levels to this CSV file")
+    ap.add_argument("--slow", type=float, default=0.0, help="seconds to pause between reads")
+    ap.add_argument("--ping", type=float, default=20.0, help="ping interval in seconds (0 = off)")
+    cfg = ap.parse_args()
+
+    # Per-level rows only with --csv; the per-message summary line is enough otherwise.
+    rx = LiveReceiver(RowSink(cfg.csv) if cfg.csv else None, cfg.slow, cfg.ping)
+    server = await asyncio.start_server(rx.handle, cfg.host, cfg.port)
+    print("[live] listening on %s:%d" % (cfg.host, cfg.port), flush=True)
+    async with server:
+        await server.serve_forever()
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+"""
+Project/Program Name : ESP8266 Dual Sensor Demo - Local MQTT Broker Stand-in
+File Name            : server/mqtt_standin.py
+Author               : Mark P.
+Date                 : 18 OCT 2026
+Version              : 1.0.0
+
+Purpose:
+  Small MQTT 3.1.1 broker for bench tests of the firmware's MQTT transport
+  (mqtt.cpp). Supports CONNECT with persistent sessions (CleanSession = 0,
+  "session present" on resume), QoS0/QoS1 PUBLISH with PUBACK, SUBSCRIBE
+  (QoS0 delivery, '+' and '#' wildcards), PINGREQ and DISCONNECT. Readings
+  published by nodes are decoded and stored like ingest_standin.py; upload
+  statistics records on <topic>/<node>/net (netstats.h) are decoded and logged.
+
+Usage:
+  python3 mqtt_standin.py --port 1883 [--csv readings.csv] [--trace traces.csv] [--drop-ack 0.2]
+
+  On the node:  cfg set transport mqtt
+                cfg set server_base mqtt://<host>:1883
+
+  --drop-ack withholds that fraction of PUBACKs, so the node has to time out,
+  reconnect, resume its session and resend with DUP set. --trace records
+  per-reading latencies as ingest_standin.py does (trace ID from the payload's
+  node_id / seq; no node send time).
+  Watch traffic:  mosquitto_sub -h <host> -t 'ee570/#' -v
+
+Dependencies:
+  Python 3.8+ standard library only (shares RowSink/parse_payload/dedup with ingest_standin.py).
+"""
+
+import argparse
+import asyncio
+import random
+import struct
+
+from ingest_standin import DedupStore, RowSink, TraceLog, parse_payload, store_forms
+
+# NetRecord wire record (netEncode(), netstats.h): version byte, then little-endian fields.
+NET_VERSION = 1                                                     # NET_RECORD_VERSION
+NET_RECORD = struct.Struct("<BBHIHHHHIIIII")
+NET_FIELDS = ("version", "transport", "seconds", "start", "readings", "requests", "failures",
+              "handshakes", "tx", "rx", "ovh_tx", "ovh_rx", "radio_ms")
+
+CONNECT, CONNACK, PUBLISH, PUBACK = 1, 2, 3, 4
+SUBSCRIBE, SUBACK, PINGREQ, PINGRESP, DISCONNECT = 8, 9, 12, 13, 14
+
+
+def rem_len(n):
+    out = bytearray()
+    while True:
+        b = n & 0x7F
+        n >>= 7
+        out.append(b | (0x80 if n else 0))
+        if not n:
+            return bytes(out)
+
+
+def mqtt_str(s):
+    b = s.encode()
+    return struct.pack(">H", len(b)) + b
+
+
+def topic_matches(flt, topic):
+    f, t = flt.split("/"), topic.split("/")
+    for i, part in enumerate(f):
+        if part == "#":
+            return True
+        if i >= len(t) or (part != "+" and part != t[i]):
+            return False
+    return len(f) == len(t)
+
+
+class Session:
+    def __init__(self, client_id):
+        self.client_id = client_id
+        self.subs = set()
+        self.acked = set()      # QoS1 packet IDs already stored (dedup of DUP resends)
+        self.writer = None
+
+
+class Broker:
+    def __init__(self, sink, dedup, drop_ack, traces):
+        self.sink = sink
+        self.dedup = dedup
+        self.traces = traces
+        self.drop_ack = drop_ack
+        self.sessions = {}
+
+    async def read_packet(self, reader):
+        hdr = (await reader.readexactly(1))[0]
+        mult, length = 1, 0
+        while True:
+            b = (await reader.readexactly(1))[0]
+            length += (b & 0x7F) * mult
+            mult *= 128
+            if not b & 0x80:
+                break
+        return hdr, await reader.readexactly(length)
+
+    async def handle(self, reader, writer):
+        peer = writer.get_extra_info("peername")
+        sess = None
+        try:
+            hdr, body = await self.read_packet(reader)
+            if hdr >> 4 != CONNECT:
+                return
+            flags = body[7]
+            keepalive = struct.unpack(">H", body[8:10])[0]
+            cid_len = struct.unpack(">H", body[10:12])[0]
+            cid = body[12:12 + cid_len].decode()
+            clean = bool(flags & 0x02)
+            present = (not clean) and cid in self.sessions
+            if clean or cid not in self.sessions:
+                self.sessions[cid] = Session(cid)
+            sess = self.sessions[cid]
+            if sess.writer is not None:
+                sess.writer.close()          # a client ID has one live connection
+            sess.writer = writer
+            writer.write(bytes([CONNACK << 4, 2, 1 if present else 0, 0]))
+            print("[mqtt] %s connected from %s (clean=%d, session present=%d, keepalive=%ds)"
+                  % (cid, peer[0], clean, present, keepalive), flush=True)
+
+            timeout = keepalive * 1.5 if keepalive else None
+            while True:
+                hdr, body = await asyncio.wait_for(self.read_packet(reader), timeout)
+                ptype = hdr >> 4
+                if ptype == PUBLISH:
+                    await self.on_publish(sess, hdr, body, writer)
+                elif ptype == SUBSCRIBE:
+                    pid = body[:2]
+                    i, granted = 2, bytearray()
+                    while i < len(body):
+                        n = struct.unpack(">H", body[i:i + 2])[0]
+                        sess.subs.add(body[i + 2:i + 2 + n].decode())
+                        i += 2 + n + 1
+                        granted.append(0)
+                    writer.write(bytes([SUBACK << 4]) + rem_len(2 + len(granted)) + pid + bytes(granted))
+                elif ptype == PINGREQ:
+                    writer.write(bytes([PINGRESP << 4, 0]))
+                elif ptype == DISCONNECT:
+                    break
+                await writer.drain()
+        except (asyncio.IncompleteReadError, asyncio.TimeoutError, ConnectionError):
+            pass
+        finally:
+            if sess is not None and sess.writer is writer:
+                sess.writer = None
+                print("[mqtt] %s disconnected" % sess.client_id, flush=True)
+            writer.close()
+
+    async def on_publish(self, sess, hdr, body, writer):
+        qos, dup = (hdr >> 1) & 3, bool(hdr & 0x08)
+        n = struct.unpack(">H", body[:2])[0]
+        topic = body[2:2 + n].decode()
+        i = 2 + n
+        pid = None
+        if qos:
+            pid = struct.unpack(">H", body[i:i + 2])[0]
+            i += 2
+        payload = body[i:]
+
+        duplicate = qos == 1 and dup and pid in sess.acked
+        if not duplicate:
+            self.store(sess, topic, payload, pid, dup)
+            if qos == 1:
+                sess.acked.add(pid)
+                if len(sess.acked) > 1024:
+                    sess.acked.clear()
+            for other in list(self.sessions.values()):
+                if other.writer and any(topic_matches(f, topic) for f in other.subs):
+                    msg = mqtt_str(topic) + payload
+                    other.writer.write(bytes([PUBLISH << 4]) + rem_len(len(msg)) + msg)
+        else:
+            print("[mqtt] %s pid %d DUP already stored, re-acking" % (sess.client_id, pid), flush=True)
+
+        if qos == 1:
+            if self.drop_ack and random.random() < self.drop_ack:
+                print("[mqtt] %s pid %d: PUBACK withheld (--drop-ack)" % (sess.client_id, pid), flush=True)
+                return
+            writer.write(bytes([PUBACK << 4, 2]) + struct.pack(">H", pid))
+
+    def store(self, sess, topic, payload, pid, dup):
+        if topic.endswith("/net"):
+            self.log_net(sess, payload)
+            return
+        trace = self.traces.begin("mqtt")
+        try:
+            forms = parse_payload(payload)
+        except ValueError as e:
+            # Still acknowledged: a resend would be just as malformed.
+            print("[mqtt] %s %s pid=%s: %s" % (sess.client_id, topic, pid, e), flush=True)
+            return
+        rows, dups = store_forms(self.sink, self.dedup, forms, {"client": sess.client_id, "topic": topic}, trace)
+        print("[mqtt] %s %s pid=%s dup=%d: %d readings, %d duplicates" % (sess.client_id, topic, pid, dup, rows, dups), flush=True)
+
+    def log_net(self, sess, payload):
+        if len(payload) != NET_RECORD.size or payload[0] != NET_VERSION:
+            print("[net] %s: unexpected record (%d B, version %d)" % (
+                sess.client_id, len(payload), payload[0] if payload else -1), flush=True)
+            return
+        r = dict(zip(NET_FIELDS, NET_RECORD.unpack(payload)))
+        total = r["tx"] + r["rx"] + r["ovh_tx"] + r["ovh_rx"]
+        per = ""
+        if r["readings"]:
+            per = ", %.1f B/reading, %.2f req/reading, %.0f ms radio/reading" % (
+                total / r["readings"], r["requests"] / r["readings"], r["radio_ms"] / r["readings"])
+        print("[net] %s %d s: %d readings, %d req (%d failed, %d TLS), %d/%d B + ~%d/%d B est, radio %d ms%s" % (
+            sess.client_id, r["seconds"], r["readings"], r["requests"], r["failures"], r["handshakes"],
+            r["tx"], r["rx"], r["ovh_tx"], r["ovh_rx"], r["radio_ms"], per), flush=True)
+
+
+async def main():
+    ap = argparse.ArgumentParser(description="Local MQTT broker stand-in")
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=1883)
+    ap.add_argument("--csv", help="append received readings to this CSV file")
+    ap.add_argument("--state", help="JSON file for per-node seen sequence numbers")
+    ap.add_argument("--trace", help="append per-reading trace records to this CSV file (trace_report.py)")
+    ap.add_argument("--drop-ack", type=float, default=0.0, help="fraction of PUBACKs to withhold")
+    cfg = ap.parse_args()
+
+    broker = Broker(RowSink(cfg.csv), DedupStore(cfg.state), cfg.drop_ack, TraceLog(cfg.trace))
+    server = await asyncio.start_server(broker.handle, cfg.host, cfg.port)
+    print("[mqtt] listening on %s:%d" % (cfg.host, cfg.port), flush=True)
+    async with server:
+        await server.serve_forever()
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        pass
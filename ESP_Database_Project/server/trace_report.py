@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+Project/Program Name : ESP8266 Dual Sensor Demo - Trace Latency Report
+File Name            : server/trace_report.py
+Author               : Mark P.
+Date                 : 18 OCT 2026
+Version              : 1.0.0
+
+Purpose:
+  Read the --trace CSV files written by the stand-ins and print latency
+  percentiles (p50/p90/p99/max) per pipeline stage and transport:
+    capture->sent      sample taken to request sent (queueing / batching on the node)
+    sent->enqueue      request sent to request received (network, TLS)
+    capture->enqueue   sample taken to request received
+    enqueue->commit    request received to row written
+    commit->visible    row written to first GET <base>/readings that returns it
+    capture->visible   end to end
+
+Usage:
+  python3 trace_report.py traces.csv [more.csv ...] [--node 00a1b2c3] [--slowest 10]
+
+Dependencies:
+  Python 3.8+ standard library only.
+
+Notes:
+  capture_ms and sent_ms come from the node's clock, the rest from the
+  server's. Both are SNTP-synchronised, so stages that cross the two clocks
+  (capture->enqueue, sent->enqueue, capture->visible) carry their skew, which
+  can even make them negative; the node-only and server-only stages do not.
+"""
+
+import argparse
+import csv
+import math
+from collections import defaultdict
+
+STAGES = (
+    ("capture->sent", "capture_ms", "sent_ms"),
+    ("sent->enqueue", "sent_ms", "enqueue_ms"),
+    ("capture->enqueue", "capture_ms", "enqueue_ms"),
+    ("enqueue->commit", "enqueue_ms", "commit_ms"),
+    ("commit->visible", "commit_ms", "visible_ms"),
+    ("capture->visible", "capture_ms", "visible_ms"),
+)
+
+
+def percentile(sorted_vals, p):
+    """Nearest-rank percentile of an ascending list."""
+    if not sorted_vals:
+        return None
+    k = max(0, min(len(sorted_vals) - 1, math.ceil(p / 100.0 * len(sorted_vals)) - 1))
+    return sorted_vals[k]
+
+
+def load(paths, node=None):
+    rows = []
+    for path in paths:
+        with open(path, newline="") as f:
+            for row in csv.DictReader(f):
+                if node and row["node_id"] != node.lower():
+                    continue
+                rows.append(row)
+    return rows
+
+
+def span(row, start, end):
+    """end - start in ms, or None if either time is missing (e.g. visible_ms
+    of a reading no query returned)."""
+    a, b = row.get(start, ""), row.get(end, "")
+    if a.lstrip("-").isdigit() and b.lstrip("-").isdigit():
+        return int(b) - int(a)
+    return None
+
+
+def stage_values(rows, start, end):
+    return sorted(v for v in (span(row, start, end) for row in rows) if v is not None)
+
+
+def report(rows):
+    by_transport = defaultdict(list)
+    for row in rows:
+        by_transport[row["transport"]].append(row)
+    for transport in sorted(by_transport):
+        group = by_transport[transport]
+        nodes = len({r["node_id"] for r in group})
+        print("%s: %d readings from %d node(s)" % (transport, len(group), nodes))
+        print("  %-18s %7s %9s %9s %9s %9s" % ("stage (ms)", "n", "p50", "p90", "p99", "max"))
+        for name, start, end in STAGES:
+            vals = stage_values(group, start, end)
+            if not vals:
+                print("  %-18s %7d %9s %9s %9s %9s" % (name, 0, "-", "-", "-", "-"))
+                continue
+            print("  %-18s %7d %9d %9d %9d %9d" % (name, len(vals), percentile(vals, 50),
+                                                  percentile(vals, 90), percentile(vals, 99), vals[-1]))
+
+
+def slowest(rows, n):
+    timed = [(span(r, "capture_ms", "visible_ms"), r) for r in rows]
+    timed = sorted((t for t in timed if t[0] is not None), key=lambda t: t[0], reverse=True)
+    print("slowest %d end to end:" % min(n, len(timed)))
+    for ms, r in timed[:n]:
+        print("  %s (batch %s, %s) %d ms" % (r["trace_id"], r["batch_trace_id"], r["transport"], ms))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Latency percentiles from stand-in --trace files")
+    ap.add_argument("files", nargs="+")
+    ap.add_argument("--node", help="only this node ID")
+    ap.add_argument("--slowest", type=int, default=0, help="also list the N slowest readings")
+    cfg = ap.parse_args()
+
+    rows = load(cfg.files, cfg.node)
+    if not rows:
+        print("no trace records")
+        return
+    report(rows)
+    if cfg.slowest:
+        slowest(rows, cfg.slowest)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,68 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Host Test Stubs
+* File Name            : Arduino.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Just enough of the Arduino / ESP8266 core for firmware modules to compile
+*   in the native environment (platformio.ini [env:native]). Values that
+*   would come from the chip (millis(), heap, chip ID) are plain variables a
+*   test sets.
+*
+* Usage Notes:
+*   - Only what the modules under test use; extend as tests grow.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+#define F(s) (s)
+
+class String {
+ public:
+  String(const char* s = "") : s_(s) {}
+  const char* c_str() const { return s_.c_str(); }
+  unsigned int length() const { return s_.size(); }
+ private:
+  std::string s_;
+};
+
+extern uint32_t g_stubMillis;
+inline unsigned long millis() { return g_stubMillis; }
+
+struct HardwareSerial {
+  int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+  }
+};
+extern HardwareSerial Serial;
+
+struct EspClass {
+  uint32_t chipId, freeHeap, maxBlock;
+  uint8_t  fragmentation;
+  uint32_t getChipId() const { return chipId; }
+  uint32_t getFreeHeap() const { return freeHeap; }
+  uint32_t getMaxFreeBlockSize() const { return maxBlock; }
+  uint8_t  getHeapFragmentation() const { return fragmentation; }
+  uint32_t getCycleCount() const { return 0; }
+};
+extern EspClass ESP;
@@ -0,0 +1,40 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Host Test Stubs
+* File Name            : ESP8266WebServer.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Declarations metrics.cpp needs from the web server and Wi-Fi; the native
+*   tests never start a server, so nothing here is called.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+struct IPAddress {
+  String toString() const { return String("0.0.0.0"); }
+};
+
+struct ESP8266WiFiClass {
+  IPAddress localIP() const { return IPAddress(); }
+};
+extern ESP8266WiFiClass WiFi;
+
+class ESP8266WebServer {
+ public:
+  explicit ESP8266WebServer(int) {}
+  void begin() {}
+  void handleClient() {}
+  void on(const char*, void (*)()) {}
+  void onNotFound(void (*)()) {}
+  void send(int, const char*, const char*) {}
+  void setContentLength(size_t) {}
+  void sendContent(const char*, size_t) {}
+  void sendContent(const char*) {}
+};
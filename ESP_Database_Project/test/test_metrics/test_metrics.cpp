@@ -0,0 +1,225 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - /metrics Host Test
+* File Name            : test_metrics.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Scrape the /metrics page through metricsRender() on the host, with every
+*   counter it reads stubbed, and check the Prometheus text exposition
+*   format (0.0.4): HELP / TYPE before each family's samples, well-formed
+*   sample lines, cumulative histogram buckets, and the chunking limit.
+*
+* Usage Notes:
+*   - pio test -e native
+*   - metrics.cpp is compiled into this test directly (test_build_src = no),
+*     so the other firmware modules are not needed; their accessors are the
+*     stubs below.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <unity.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "metrics.cpp"
+
+// ----- Stubbed chip and counters -----
+uint32_t g_stubMillis = 90500;
+HardwareSerial Serial;
+EspClass ESP = { 0x00abcdef, 31234, 28000, 9 };
+ESP8266WiFiClass WiFi;
+
+static NodeConfig g_cfg;
+const NodeConfig& config() { return g_cfg; }
+
+static NetTotals g_net;
+const NetTotals& netTotals() { return g_net; }
+uint8_t readingCount() { return 7; }
+uint32_t readingOverflows() { return 3; }
+uint8_t linkBatchSize() { return 8; }
+int8_t linkRssi() { return -67; }
+static LiveStats g_live;
+const LiveStats& liveStats() { return g_live; }
+static OversampleStats g_os = { 8, 39800, 40000, 12, 5 };
+const OversampleStats& oversampleStats() { return g_os; }
+
+static bool g_twOn = false;
+static TwLevel g_tl = { 1000, 6512, 6400, 6890, 7011, 8850 };
+static TwStats g_ts = { 50000, 120, 40 };
+bool twActive() { return g_twOn; }
+const TwLevel& twLatest() { return g_tl; }
+const TwStats& twStats() { return g_ts; }
+
+const char* const CLS_NAMES[CLS_CLASSES] = { "background", "traffic", "voices", "alarm", "machinery" };
+static ClsResult g_cls;
+static ClsStats g_clsStats;
+bool clsActive() { return false; }
+const ClsResult& clsLatest() { return g_cls; }
+const ClsStats& clsStats() { return g_clsStats; }
+
+const char* const QUALITY_NAMES[QUALITY_FLAG_COUNT] = { "clip", "stuck", "bias", "jitter", "no_echo", "echo_rate", "near" };
+static QualityStats g_qs;
+const QualityStats& qualityStats() { return g_qs; }
+static RangeMotion g_rm;
+const RangeMotion& rangeMotion() { return g_rm; }
+
+// ----- Scrape helpers -----
+static std::string g_page;
+static size_t g_pieces, g_maxPiece;
+
+static void collect(const char* data, size_t len, void*) {
+  g_page.append(data, len);
+  g_pieces++;
+  g_maxPiece = max(g_maxPiece, len);
+}
+
+static size_t scrape() {
+  g_page.clear();
+  g_pieces = g_maxPiece = 0;
+  return metricsRender(collect, nullptr);
+}
+
+static std::vector<std::string> lines() {
+  std::vector<std::string> out;
+  size_t start = 0, nl;
+  while ((nl = g_page.find('\n', start)) != std::string::npos) {
+    out.push_back(g_page.substr(start, nl - start));
+    start = nl + 1;
+  }
+  return out;
+}
+
+// Value of the sample line that starts with 'series' (name plus labels).
+static double sample(const std::string& series) {
+  for (const std::string& l : lines())
+    if (l.compare(0, series.size() + 1, series + " ") == 0) return atof(l.c_str() + series.size() + 1);
+  TEST_FAIL_MESSAGE(("missing series " + series).c_str());
+  return NAN;
+}
+
+static bool isNameChar(char c) { return isalnum((unsigned char)c) || c == '_' || c == ':'; }
+
+// ----- Tests -----
+void setUp() {
+  g_cfg = NodeConfig();
+  g_cfg.transport = 0;
+  g_twOn = false;
+}
+
+void tearDown() {}
+
+static void test_pieces_fit_the_chunk() {
+  size_t n = scrape();
+  TEST_ASSERT_EQUAL(g_page.size(), n);
+  TEST_ASSERT_TRUE(g_pieces > 1);
+  TEST_ASSERT_TRUE(g_maxPiece <= METRICS_CHUNK);
+  TEST_ASSERT_EQUAL_CHAR('\n', g_page.back());
+  TEST_ASSERT_EQUAL_DOUBLE(0, sample("ee570_metrics_truncated"));
+}
+
+// Every sample belongs to the family announced by the preceding HELP / TYPE,
+// and every line is a comment or "name[{labels}] value".
+static void test_exposition_format() {
+  g_twOn = true;
+  g_cfg.range_idle_ms = 1000;
+  scrape();
+  std::string family, type;
+  std::set<std::string> seen;
+  for (const std::string& l : lines()) {
+    TEST_ASSERT_FALSE_MESSAGE(l.empty(), "blank line");
+    if (l.compare(0, 7, "# HELP ") == 0) {
+      family = l.substr(7, l.find(' ', 7) - 7);
+      TEST_ASSERT_TRUE_MESSAGE(seen.insert(family).second, ("family repeated: " + family).c_str());
+      type.clear();
+      continue;
+    }
+    if (l.compare(0, 7, "# TYPE ") == 0) {
+      TEST_ASSERT_EQUAL_STRING(family.c_str(), l.substr(7, family.size()).c_str());
+      type = l.substr(8 + family.size());
+      TEST_ASSERT_TRUE(type == "gauge" || type == "counter" || type == "histogram");
+      continue;
+    }
+    TEST_ASSERT_FALSE_MESSAGE(type.empty(), ("sample before TYPE: " + l).c_str());
+    size_t i = 0;
+    while (i < l.size() && isNameChar(l[i])) i++;
+    std::string name = l.substr(0, i);
+    bool ok = name == family ||
+              (type == "histogram" && (name == family + "_bucket" || name == family + "_sum" || name == family + "_count"));
+    TEST_ASSERT_TRUE_MESSAGE(ok, ("sample outside its family: " + l).c_str());
+    if (l[i] == '{') {
+      size_t close = l.find('}', i);
+      TEST_ASSERT_TRUE(close != std::string::npos);
+      i = close + 1;
+    }
+    TEST_ASSERT_EQUAL_CHAR(' ', l[i]);
+    char* end;
+    strtod(l.c_str() + i + 1, &end);
+    TEST_ASSERT_EQUAL_CHAR_MESSAGE('\0', *end, ("bad value: " + l).c_str());
+  }
+}
+
+static void test_counter_values() {
+  metricsReading(READING_NODE_ULTRA);
+  metricsReading(READING_NODE_ULTRA);
+  metricsReading(READING_NODE_SOUND);
+  g_net.readings = 41;
+  g_net.failures = 2;
+  scrape();
+  TEST_ASSERT_EQUAL_DOUBLE(7, sample("ee570_queue_readings"));
+  TEST_ASSERT_EQUAL_DOUBLE(READING_QUEUE_CAP, sample("ee570_queue_capacity_readings"));
+  TEST_ASSERT_EQUAL_DOUBLE(3, sample("ee570_queue_overflows_total"));
+  TEST_ASSERT_EQUAL_DOUBLE(2, sample("ee570_readings_captured_total{sensor=\"" READING_NAME_ULTRA "\"}"));
+  TEST_ASSERT_EQUAL_DOUBLE(1, sample("ee570_readings_captured_total{sensor=\"" READING_NAME_SOUND "\"}"));
+  TEST_ASSERT_EQUAL_DOUBLE(41, sample("ee570_readings_uploaded_total"));
+  TEST_ASSERT_EQUAL_DOUBLE(2, sample("ee570_upload_failures_total"));
+  TEST_ASSERT_EQUAL_DOUBLE(90.5, sample("ee570_uptime_seconds"));
+  TEST_ASSERT_EQUAL_DOUBLE(1, sample("ee570_node_info{node=\"00abcdef\",transport=\"https\"}"));
+}
+
+// Optional sections follow their feature switches.
+static void test_optional_sections() {
+  scrape();
+  TEST_ASSERT_TRUE(g_page.find("ee570_sound_level_db") == std::string::npos);
+  TEST_ASSERT_TRUE(g_page.find("ee570_range_active") == std::string::npos);
+  g_twOn = true;
+  scrape();
+  TEST_ASSERT_EQUAL_DOUBLE(65.12, sample("ee570_sound_level_db{weighting=\"fast\"}"));
+  TEST_ASSERT_EQUAL_DOUBLE(120, sample("ee570_sound_slots_missed_total"));
+}
+
+// Buckets are cumulative, end at +Inf and match _count.
+static void test_loop_histogram() {
+  g_stubMillis = 100000;
+  metricsLoopTick();
+  const uint32_t steps[] = { 3, 7, 7, 40, 300, 6000 };
+  for (uint32_t ms : steps) {
+    g_stubMillis += ms;
+    metricsLoopTick();
+  }
+  scrape();
+  double prev = 0;
+  for (const char* le : { "0.005", "0.01", "0.025", "0.05", "0.1", "0.25", "1", "5", "+Inf" }) {
+    double v = sample(std::string("ee570_loop_period_seconds_bucket{le=\"") + le + "\"}");
+    TEST_ASSERT_TRUE(v >= prev);
+    prev = v;
+  }
+  TEST_ASSERT_EQUAL_DOUBLE(6, prev);
+  TEST_ASSERT_EQUAL_DOUBLE(6, sample("ee570_loop_period_seconds_count"));
+  TEST_ASSERT_EQUAL_DOUBLE(1, sample("ee570_loop_period_seconds_bucket{le=\"0.005\"}"));
+  TEST_ASSERT_EQUAL_DOUBLE(6.357, sample("ee570_loop_period_seconds_sum"));
+  TEST_ASSERT_EQUAL_DOUBLE(6, sample("ee570_loop_period_max_seconds"));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_pieces_fit_the_chunk);
+  RUN_TEST(test_exposition_format);
+  RUN_TEST(test_counter_values);
+  RUN_TEST(test_optional_sections);
+  RUN_TEST(test_loop_histogram);
+  return UNITY_END();
+}
@@ -0,0 +1,153 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Fast/Slow/Impulse Time Weighting
+* File Name            : timeweight.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Coefficients, the between-work sampler, dB conversion and the level
+*   history (see timeweight.h).
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "timeweight.h", "config.h", "adccal.h", "bias.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include "config.h"
+#include "adccal.h"
+#include "bias.h"
+#include "timeweight.h"
+
+static TimeWeighter g_tw;
+static uint32_t g_fs = 0;               // rate / output rate the kernel was set up for
+static uint8_t  g_rate = 0;
+static uint32_t g_gapUs = 0;
+static uint32_t g_nextUs = 0;           // next twService() sample slot
+static TwLevel  g_hist[TW_RING];        // oldest first once full
+static uint8_t  g_histLen = 0;
+static TwLevel  g_latest = {};
+static TwStats  g_stats = {};
+
+// 1 - exp(-1 / (fs * tau)) in Q30.
+static uint32_t coeffQ30(uint32_t fs, uint32_t tauMs) {
+  return (uint32_t)lround((1.0 - exp(-1000.0 / ((double)fs * tauMs))) * (double)(1UL << 30));
+}
+
+void TimeWeighter::begin(uint32_t fs, uint32_t decimation) {
+  memset(this, 0, sizeof(*this));
+  aFast = coeffQ30(fs, TW_FAST_MS);
+  aSlow = coeffQ30(fs, TW_SLOW_MS);
+  aImp  = coeffQ30(fs, TW_IMPULSE_MS);
+  bImp  = coeffQ30(fs, TW_IMPULSE_DECAY_MS);
+  decim = max<uint32_t>(decimation, 1);
+}
+
+// Mean square (Q26 volts^2) -> calibrated centi-dB, same reference as the
+// standalone sketch: cal_db_at_ref at ref_rms volts RMS.
+static int16_t cdbFromMeanSq(int32_t msQ26) {
+  float cdb = adcDbFromMeanSq((float)msQ26) * 100.0f;
+  return (int16_t)constrain(lroundf(cdb), -32000L, 32000L);
+}
+
+static bool configured() {
+  const NodeConfig& cfg = config();
+  if (!cfg.tw_rate_hz) return false;
+  if (cfg.target_fs != g_fs || cfg.tw_rate_hz != g_rate) {
+    g_fs = cfg.target_fs;
+    g_rate = cfg.tw_rate_hz;
+    g_gapUs = 1000000UL / g_fs;
+    g_tw.begin(g_fs, g_fs / g_rate);
+    // Start the DC tracker at the persisted bias rather than the first sample.
+    g_tw.dcQ25 = biasVoltsQ13() * 4096;
+    g_tw.primed = true;
+    g_nextUs = micros();
+  }
+  return true;
+}
+
+void twClose() {
+  TwLevel l;
+  l.ms       = millis();
+  l.fast_cdb = cdbFromMeanSq((int32_t)(g_tw.fast >> 30));
+  l.slow_cdb = cdbFromMeanSq((int32_t)(g_tw.slow >> 30));
+  l.imp_cdb  = cdbFromMeanSq((int32_t)(g_tw.imp >> 30));
+  l.fmax_cdb = cdbFromMeanSq(g_tw.fmax);
+  // L_peak: the peak itself against the same reference (peak^2 < 2^30).
+  l.peak_cdb = cdbFromMeanSq(g_tw.peak * g_tw.peak);
+  g_tw.count = 0;
+  g_tw.peak = 0;
+  g_tw.fmax = 0;
+
+  g_latest = l;
+  if (g_histLen == TW_RING) {
+    memmove(g_hist, g_hist + 1, (TW_RING - 1) * sizeof(TwLevel));
+    g_histLen--;
+  }
+  g_hist[g_histLen++] = l;
+  g_stats.levels++;
+}
+
+static inline void weigh(int32_t vQ13) {
+  g_stats.samples++;
+  if (g_tw.push(vQ13)) twClose();
+}
+
+bool twActive() { return config().tw_rate_hz > 0; }
+
+TimeWeighter* twWindow() { return configured() ? &g_tw : nullptr; }
+
+void twWindowEnd(TimeWeighter* tw, uint32_t samples) {
+  if (!tw) return;
+  g_stats.samples += samples;
+  g_nextUs = micros() + g_gapUs;        // the window covered these slots
+}
+
+void twService() {
+  if (!configured()) return;
+  uint32_t now = micros();
+  if ((int32_t)(now - g_nextUs) < 0) return;
+  uint32_t missed = (now - g_nextUs) / g_gapUs;
+  if (missed) {
+    g_stats.missed += missed;
+    g_nextUs += missed * g_gapUs;
+  }
+  uint8_t pin = config().pin_sound;
+  uint32_t burst = max<uint32_t>(g_fs * TW_BURST_MS / 1000, 1);
+  for (uint32_t i = 0; i < burst; i++) {
+    while ((int32_t)(micros() - g_nextUs) < 0) {}
+    uint16_t raw = analogRead(pin);
+    biasTrack(raw);
+    weigh(adcVoltsQ13(raw));
+    g_nextUs += g_gapUs;
+  }
+}
+
+const TwLevel& twLatest() { return g_latest; }
+
+uint8_t twHistory(TwLevel* out, uint8_t max) {
+  uint8_t n = min(max, g_histLen);
+  memcpy(out, g_hist + (g_histLen - n), n * sizeof(TwLevel));
+  return n;
+}
+
+const TwStats& twStats() { return g_stats; }
+
+void twPrint() {
+  if (!twActive()) { Serial.println(F("[lvl] off (cfg set tw_rate_hz <1..50>)")); return; }
+  uint32_t slots = g_stats.samples + g_stats.missed;
+  Serial.printf("[lvl] %lu samples weighted, %lu slots missed (%.1f%% coverage), %lu levels\n",
+                (unsigned long)g_stats.samples, (unsigned long)g_stats.missed,
+                slots ? 100.0f * g_stats.samples / slots : 0.0f, (unsigned long)g_stats.levels);
+  Serial.println(F("[lvl]   age ms   L_ZF   L_ZS   L_ZI  L_ZFmax  L_Zpeak  (dB)"));
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < g_histLen; i++) {
+    const TwLevel& l = g_hist[i];
+    Serial.printf("      %8lu %6.1f %6.1f %6.1f %8.1f %8.1f\n", (unsigned long)(now - l.ms),
+                  l.fast_cdb / 100.0f, l.slow_cdb / 100.0f, l.imp_cdb / 100.0f,
+                  l.fmax_cdb / 100.0f, l.peak_cdb / 100.0f);
+  }
+}
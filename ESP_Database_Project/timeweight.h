@@ -0,0 +1,152 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - Fast/Slow/Impulse Time Weighting
+* File Name            : timeweight.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Sound level meter style time weighting on the sample stream, next to the
+*   one-number-per-window crude dB the uploads carry. Per sample, in integer
+*   arithmetic:
+*     - DC removal (first-order tracker, ~0.2 s) and squaring;
+*     - Fast (125 ms) and Slow (1 s) exponential averages of the square;
+*     - Impulse: 35 ms average followed by a 1.5 s decaying hold;
+*     - peak |x| and the highest Fast level of the current output interval.
+*   Samples arrive as calibrated volts from the ADC table (adccal.h). Every
+*   1 / config().tw_rate_hz seconds of samples the five values are converted
+*   to calibrated dB (ref_rms / cal_db_at_ref, as in the standalone sketch)
+*   and queued as one TwLevel.
+*
+* Inputs:
+*   - twWindow() / twPush() / twWindowEnd() around every sound sampling loop
+*     (sampling.h, oversample.cpp, classify.cpp), and twService() sampling
+*     A0 itself between other work.
+*   - config().target_fs (sample rate), tw_rate_hz (0 = off), ref_rms,
+*     cal_db_at_ref.
+*
+* Outputs:
+*   - The latest TwLevel and a history of TW_RING; TwStats coverage
+*     counters; "lvl" on the console; Fast/Slow/Impulse/peak on /metrics.
+*
+* Example Application:
+*   // cfg set tw_rate_hz 8
+*   twService();                       // in loop()
+*   Serial.printf("L_ZF %.1f dB\n", twLatest().fast_cdb / 100.0f);
+*
+* Dependencies:
+*   - Arduino core for ESP8266
+*   - "config.h", "adccal.h" (sample scale and dB offset)
+*
+* Usage Notes:
+*   - Averages are kept as Q30-scaled 64-bit states so slow time constants
+*     at high sample rates do not stall on rounding; each update is one
+*     32x32->64 multiply. Cost per sample is in the sampling benchmark.
+*   - The sampling loops check the configuration once per window
+*     (twWindow()); per sample they pay the inlined push() only, or one
+*     null test when the stage is off.
+*   - No frequency weighting: levels are Z-weighted (flat), L_ZF / L_ZS / L_ZI.
+*   - The ESP8266 cannot sample A0 from a timer interrupt alongside Wi-Fi, so
+*     twService() samples in bursts of at most TW_BURST_MS per loop pass.
+*     Slots missed while loop() is busy (uploads, TLS) are not invented: the
+*     averages hold and the slots are counted in TwStats::missed.
+*   - Levels are timed in samples, not wall-clock, so gaps stretch them.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+
+#define TW_FAST_MS        125
+#define TW_SLOW_MS        1000
+#define TW_IMPULSE_MS     35
+#define TW_IMPULSE_DECAY_MS 1500
+#define TW_DC_SHIFT       10          // DC tracker: 2^-10 per sample (~0.2 s at 5 kHz)
+#define TW_BURST_MS       5           // longest twService() burst per loop pass
+#define TW_RING           16          // recent levels kept for twHistory()
+
+// One decimated output; levels in hundredths of a dB (calibrated SPL).
+struct TwLevel {
+  uint32_t ms;          // millis() when the interval closed
+  int16_t  fast_cdb;    // L_ZF at the end of the interval
+  int16_t  slow_cdb;    // L_ZS
+  int16_t  imp_cdb;     // L_ZI
+  int16_t  fmax_cdb;    // highest L_ZF within the interval
+  int16_t  peak_cdb;    // L_Zpeak (largest |x| within the interval)
+};
+
+// The per-sample kernel. Samples are Q13 volts, so mean squares are Q26
+// volts^2; the averages hold them scaled by 2^30.
+struct TimeWeighter {
+  int32_t  dcQ25;                    // DC estimate, Q25 volts
+  int64_t  fast, slow, imp35, imp;   // Q26 volts^2 << 30
+  uint32_t aFast, aSlow, aImp, bImp; // Q30 per-sample coefficients
+  int32_t  peak;                     // largest |v| this interval, Q13
+  int32_t  fmax;                     // largest Fast mean square this interval, Q26
+  uint32_t count, decim;             // samples into this interval / per interval
+  bool     primed;
+
+  // Coefficients for sample rate fs and 'decim' samples per output.
+  void begin(uint32_t fs, uint32_t decimation);
+
+  static inline void average(int64_t& y, int32_t e, uint32_t a) {
+    y += (int64_t)(e - (int32_t)(y >> 30)) * a;
+  }
+
+  // Weight one sample; true when an output interval has closed.
+  inline bool push(int32_t vQ13) {
+    if (!primed) { dcQ25 = vQ13 * 4096; primed = true; }
+    dcQ25 += (vQ13 * 4096 - dcQ25) >> TW_DC_SHIFT;
+    int32_t ac = vQ13 - (dcQ25 >> 12);
+    int32_t e = ac * ac;                          // Q26, < 2^30 below 4 V
+    average(fast, e, aFast);
+    average(slow, e, aSlow);
+    average(imp35, e, aImp);
+    if (imp35 > imp) imp = imp35;
+    else imp -= (imp >> 30) * bImp;
+    int32_t mag = ac < 0 ? -ac : ac;
+    if (mag > peak) peak = mag;
+    int32_t f = (int32_t)(fast >> 30);
+    if (f > fmax) fmax = f;
+    return ++count >= decim;
+  }
+};
+
+struct TwStats {
+  uint32_t samples;     // samples weighted since boot
+  uint32_t missed;      // slots twService() could not sample (loop busy)
+  uint32_t levels;      // TwLevel outputs produced
+};
+
+// True when the stage is on (config().tw_rate_hz > 0).
+bool twActive();
+
+// Kernel for one sampling window, set up for the current config; nullptr
+// when the stage is off. Call once before the loop.
+TimeWeighter* twWindow();
+
+// Close the current output interval (from twPush()).
+void twClose();
+
+// Weight one sample. vQ13: adcVoltsQ13() of the reading, any DC offset.
+static inline void twPush(TimeWeighter* tw, int32_t vQ13) {
+  if (tw && tw->push(vQ13)) twClose();
+}
+
+// After the loop: count its samples and mark the slots as covered.
+void twWindowEnd(TimeWeighter* tw, uint32_t samples);
+
+// Sample A0 for the slots that are due (bounded burst). Call from loop().
+void twService();
+
+// Most recent level (all zero before the first one).
+const TwLevel& twLatest();
+
+// Copy up to 'max' recent levels, oldest first; returns how many.
+uint8_t twHistory(TwLevel* out, uint8_t max);
+
+const TwStats& twStats();
+
+// Latest levels, coverage counters and recent history on Serial.
+void twPrint();
@@ -0,0 +1,154 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - TLS Verification Modes
+* File Name            : tls.cpp
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Pin bookkeeping and BearSSL client setup for the modes in tls.h, plus the
+*   optional handshake benchmark (-DTLS_BENCH).
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <WiFiClientSecureBearSSL.h>
+*   - "config.h", "tls.h", "tls_pins.h"
+* ------------------------------------------------------------------------------------------------
+*/
+
+#include <Arduino.h>
+#include <WiFiClientSecureBearSSL.h>
+#include <time.h>
+#include "config.h"
+#include "tls.h"
+#include "tls_pins.h"
+
+static const uint8_t MAX_KEY_PINS = 4;
+static const char* const CA_PEM = TLS_CA_PEM;
+
+static BearSSL::PublicKey* g_keys[MAX_KEY_PINS];   // parsed lazily, kept for reuse
+static uint8_t g_keyCount = 0xFF;                  // 0xFF = not parsed yet
+static BearSSL::X509List*  g_ca = nullptr;
+static uint8_t g_good = 0;                         // pin index that last worked
+
+// Parse the compile-time PEM keys once; they must outlive every client using them.
+static uint8_t keyPinCount() {
+  if (g_keyCount != 0xFF) return g_keyCount;
+  g_keyCount = 0;
+  for (uint8_t i = 0; TLS_KEY_PINS[i] && g_keyCount < MAX_KEY_PINS; i++) {
+    BearSSL::PublicKey* k = new BearSSL::PublicKey(TLS_KEY_PINS[i]);
+    g_keys[g_keyCount++] = k;
+  }
+  return g_keyCount;
+}
+
+static bool fpUsed(uint8_t slot) {
+  const uint8_t* fp = config().tls_fp[slot];
+  for (uint8_t k = 0; k < TLS_FP_LEN; k++) if (fp[k]) return true;
+  return false;
+}
+
+// Pins in order: compiled public keys, then configured fingerprints.
+static uint8_t pinCount() {
+  uint8_t n = keyPinCount();
+  for (uint8_t i = 0; i < TLS_FP_PINS; i++) if (fpUsed(i)) n++;
+  return n;
+}
+
+// Apply pin number 'idx' (0 .. pinCount()-1).
+static bool applyPin(BearSSL::WiFiClientSecure& client, uint8_t idx) {
+  uint8_t keys = keyPinCount();
+  if (idx < keys) {
+    client.setKnownKey(g_keys[idx]);
+    return true;
+  }
+  idx -= keys;
+  for (uint8_t i = 0; i < TLS_FP_PINS; i++) {
+    if (!fpUsed(i)) continue;
+    if (idx-- == 0) return client.setFingerprint(config().tls_fp[i]);
+  }
+  return false;
+}
+
+static bool applyMode(BearSSL::WiFiClientSecure& client, uint8_t mode, uint8_t attempt) {
+  switch (mode) {
+    case TLS_PINNED: {
+      uint8_t n = pinCount();
+      if (n == 0) { Serial.println(F("[tls] pinned mode but no pins")); return false; }
+      return applyPin(client, (uint8_t)((g_good + attempt) % n));
+    }
+    case TLS_CA:
+      if (!CA_PEM) { Serial.println(F("[tls] CA mode but TLS_CA_PEM unset")); return false; }
+      if (!g_ca) g_ca = new BearSSL::X509List(CA_PEM);
+      client.setTrustAnchors(g_ca);
+      client.setX509Time(time(nullptr));
+      return true;
+    default:
+      client.setInsecure();
+      return true;
+  }
+}
+
+uint8_t tlsAttempts() {
+  if (config().tls_mode != TLS_PINNED) return 1;
+  uint8_t n = pinCount();
+  return n ? n : 1;
+}
+
+bool tlsApply(BearSSL::WiFiClientSecure& client, uint8_t attempt) {
+  return applyMode(client, config().tls_mode, attempt);
+}
+
+void tlsMarkGood(uint8_t attempt) {
+  if (config().tls_mode != TLS_PINNED) return;
+  uint8_t n = pinCount();
+  if (n) g_good = (uint8_t)((g_good + attempt) % n);
+}
+
+bool tlsVerifyFailed(BearSSL::WiFiClientSecure& client) {
+  int err = client.getLastSSLError();
+  return err > BR_ERR_X509_OK && err < BR_ERR_X509_OK + 32;   // BR_ERR_X509_* block
+}
+
+const char* tlsAttemptName(uint8_t attempt) {
+  static char buf[8];
+  if (config().tls_mode != TLS_PINNED) return config().tls_mode == TLS_CA ? "ca" : "insecure";
+  uint8_t n = pinCount();
+  uint8_t idx = n ? (uint8_t)((g_good + attempt) % n) : 0;
+  uint8_t keys = keyPinCount();
+  if (idx < keys) snprintf(buf, sizeof(buf), "key%u", idx);
+  else            snprintf(buf, sizeof(buf), "fp%u", idx - keys);
+  return buf;
+}
+
+#ifdef TLS_BENCH
+// Time connect() (TCP + full TLS handshake) and the heap it holds while open.
+static void benchMode(const char* name, uint8_t mode, const char* host, uint16_t port, uint8_t rounds) {
+  uint32_t okCount = 0, totalMs = 0, worstHeap = 0;
+  for (uint8_t r = 0; r < rounds; r++) {
+    uint32_t heap0 = ESP.getFreeHeap();
+    BearSSL::WiFiClientSecure client;
+    if (!applyMode(client, mode, 0)) { Serial.printf("  %-9s skipped (no trust material)\n", name); return; }
+    uint32_t t0 = millis();
+    bool ok = client.connect(host, port);
+    uint32_t dt = millis() - t0;
+    uint32_t heapCost = heap0 - ESP.getFreeHeap();
+    if (ok) { okCount++; totalMs += dt; if (heapCost > worstHeap) worstHeap = heapCost; }
+    else    { Serial.printf("  %-9s round %u failed (ssl err %d)\n", name, r, client.getLastSSLError()); }
+    client.stop();
+    delay(200);
+  }
+  if (okCount)
+    Serial.printf("  %-9s %lu/%u ok  avg handshake %lu ms  heap held %lu B  max block %lu B\n",
+                  name, (unsigned long)okCount, rounds, (unsigned long)(totalMs / okCount),
+                  (unsigned long)worstHeap, (unsigned long)ESP.getMaxFreeBlockSize());
+}
+
+void runTlsBench(const char* host, uint16_t port, uint8_t rounds) {
+  Serial.printf("\n[bench] TLS handshake to %s:%u (%u rounds, CPU %u MHz)\n",
+                host, port, rounds, ESP.getCpuFreqMHz());
+  benchMode("insecure", TLS_INSECURE, host, port, rounds);
+  benchMode("pinned",   TLS_PINNED,   host, port, rounds);
+  benchMode("ca",       TLS_CA,       host, port, rounds);
+}
+#endif // TLS_BENCH
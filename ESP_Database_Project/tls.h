@@ -0,0 +1,73 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - TLS Verification Modes
+* File Name            : tls.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Configure a BearSSL client for the verification mode in config().tls_mode:
+*     TLS_INSECURE : setInsecure() (old behaviour, no server authentication)
+*     TLS_PINNED   : BearSSL known-key (setKnownKey) or certificate fingerprint
+*                    (setFingerprint) pins; several pins allow key rotation
+*     TLS_CA       : full X.509 chain validation against TLS_CA_PEM
+*   Pinned mode skips chain building and signature checks on the certificate
+*   chain, so it costs close to insecure mode while still authenticating the server.
+*
+* Inputs:
+*   - config().tls_mode, config().tls_fp[] (runtime fingerprints)
+*   - TLS_KEY_PINS / TLS_CA_PEM (tls_pins.h, compile time)
+*
+* Outputs:
+*   - tlsApply(): client ready for connect() for one pin attempt.
+*   - runTlsBench(): handshake time and heap cost per mode on Serial.
+*
+* Example Application:
+*   for (uint8_t a = 0; a < tlsAttempts(); a++) {
+*     BearSSL::WiFiClientSecure c;
+*     if (!tlsApply(c, a)) break;
+*     if (c.connect(host, 443)) { tlsMarkGood(a); ... break; }
+*   }
+*
+* Dependencies:
+*   - Arduino core for ESP8266, <WiFiClientSecureBearSSL.h>
+*   - "config.h", "tls_pins.h"
+*
+* Usage Notes:
+*   - Attempts start at the pin that last succeeded, so a rotation only costs
+*     extra handshakes until the first success with the new pin.
+*   - A failed pin fails the handshake before any request bytes are sent, so
+*     retrying the next pin is safe for POSTs. Only verification failures
+*     (tlsVerifyFailed()) move on to the next pin; an unreachable host costs
+*     one connect attempt, not one per pin.
+*   - CA mode needs a valid clock (SNTP) for certificate dates.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <WiFiClientSecureBearSSL.h>
+
+// Number of connection attempts the current mode allows (>= 1).
+uint8_t tlsAttempts();
+
+// Configure 'client' for attempt number 'attempt' (0-based).
+// Returns false if the mode has no usable trust material (fail closed).
+bool tlsApply(BearSSL::WiFiClientSecure& client, uint8_t attempt);
+
+// Remember which attempt succeeded so the next connection tries it first.
+void tlsMarkGood(uint8_t attempt);
+
+// True if the last connection failed in certificate / pin verification
+// (a BearSSL X.509 error), the only failure the next pin can fix; DNS, TCP
+// and server-side errors are not retried per pin.
+bool tlsVerifyFailed(BearSSL::WiFiClientSecure& client);
+
+// Human-readable description of an attempt, for logs ("key0", "fp1", ...).
+const char* tlsAttemptName(uint8_t attempt);
+
+#ifdef TLS_BENCH
+// Handshake time and heap cost for insecure / pinned / CA against 'host'.
+void runTlsBench(const char* host, uint16_t port = 443, uint8_t rounds = 3);
+#endif
@@ -0,0 +1,40 @@
+/*
+* ------------------------------------------------------------------------------------------------
+* Project/Program Name : ESP8266 Dual Sensor Demo - TLS Trust Material
+* File Name            : tls_pins.h
+* Author               : Mark P.
+* Date                 : 18 OCT 2026
+* Version              : 1.0.0
+*
+* Purpose:
+*   Compile-time trust material for tls.cpp:
+*     - TLS_KEY_PINS : server public keys (PEM) accepted in TLS_PINNED mode.
+*     - TLS_CA_PEM   : root/intermediate certificate(s) for TLS_CA mode.
+*
+* Usage Notes:
+*   - List the current key AND the next one before rotating the server key, so
+*     deployed nodes keep connecting across the switch. Certificate fingerprints
+*     (tls_fp0..2) can also be set at runtime from the Serial console.
+*   - Extract a server's public key:
+*       openssl s_client -connect markpulido.io:443 -servername markpulido.io </dev/null \
+*         | openssl x509 -pubkey -noout
+*   - Certificate SHA-1 fingerprint for "cfg set tls_fp0 ...":
+*       ... | openssl x509 -fingerprint -sha1 -noout
+*   - Leave an entry list empty ({ nullptr }) when unused; the mode then fails closed.
+* ------------------------------------------------------------------------------------------------
+*/
+
+#pragma once
+
+// Public keys, most likely first. nullptr-terminated.
+static const char* const TLS_KEY_PINS[] = {
+  // R"PEM(-----BEGIN PUBLIC KEY-----
+  // ...
+  // -----END PUBLIC KEY-----)PEM",
+  nullptr
+};
+
+// Trust anchors for full chain validation (PEM, may hold several certificates).
+#ifndef TLS_CA_PEM
+#define TLS_CA_PEM nullptr
+#endif